@@ -0,0 +1,33 @@
+#!/bin/sh
+# Compares the requests per second of x10c (served by x10d) against spawning x10 for every request.
+#
+# Usage: benchmarks/daemon.sh [BUILD_DIR] [SCRIPT] [REQUESTS] [CLIENTS]
+#   BUILD_DIR  The directory which contains x10, x10d and x10c (default: build)
+#   SCRIPT     The script executed by every request (default: corpus/loops.x10)
+#   REQUESTS   The amount of requests (default: 2000)
+#   CLIENTS    The amount of requests made at once (default: the amount of cores)
+
+BUILD=${1:-build}
+SCRIPT=${2:-corpus/loops.x10}
+REQUESTS=${3:-2000}
+CLIENTS=${4:-$(nproc 2>/dev/null || echo 4)}
+
+X10D_SOCKET=$(mktemp -u /tmp/x10d-benchmark.XXXXXX)
+export X10D_SOCKET
+
+"$BUILD/x10d" --jobs="$CLIENTS" > /dev/null &
+DAEMON=$!
+trap 'kill $DAEMON 2>/dev/null' EXIT
+
+while [ ! -S "$X10D_SOCKET" ]; do sleep 0.05; done
+
+# Runs REQUESTS requests with a command, CLIENTS at once, and writes the requests per second.
+run() {
+    start=$(date +%s%N)
+    seq "$REQUESTS" | xargs -P "$CLIENTS" -I {} "$1" "$SCRIPT" -n 5 > /dev/null 2>&1
+    end=$(date +%s%N)
+    echo "$2: $(( REQUESTS * 1000000000 / (end - start) )) requests/s"
+}
+
+run "$BUILD/x10" "spawn-per-job (x10)"
+run "$BUILD/x10c" "daemon (x10c)"
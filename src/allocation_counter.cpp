@@ -0,0 +1,77 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "allocation_counter.h"
+
+#ifdef X10_COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/// The amount of heap allocations made so far.
+static std::atomic<uint64_t> allocation_count(0);
+
+// Every other form of operator new (except the aligned ones) calls one of these.
+void *operator new(size_t size) {
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+	void *memory = malloc(size == 0 ? 1 : size);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void *operator new(size_t size, const std::nothrow_t&) noexcept {
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	return malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void *memory) noexcept {
+	free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+	free(memory);
+}
+
+void operator delete(void *memory, const std::nothrow_t&) noexcept {
+	free(memory);
+}
+
+uint64_t getAllocationCount() {
+	return allocation_count.load(std::memory_order_relaxed);
+}
+
+void reportAllocations(std::ostream &output, uint64_t since) {
+	output << "\n[INFO] Heap allocations during execution: " << getAllocationCount() - since;
+}
+
+#else
+
+uint64_t getAllocationCount() {
+	return 0;
+}
+
+void reportAllocations(std::ostream &output, uint64_t since) { }
+
+#endif
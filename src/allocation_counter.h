@@ -0,0 +1,44 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef X10_ALLOCATION_COUNTER_H
+#define X10_ALLOCATION_COUNTER_H
+
+#include <cstdint>
+#include <ostream>
+
+/**
+ * Gets the amount of heap allocations made so far.
+ * Allocations are only counted when the interpreter is built with X10_COUNT_ALLOCATIONS.
+ *
+ * @return The amount of heap allocations, or 0 if they aren't counted.
+ */
+uint64_t getAllocationCount();
+/**
+ * Writes the amount of heap allocations made since a previous count, if allocations are counted.
+ *
+ * @param output The stream where to write.
+ * @param since The previous count.
+ */
+void reportAllocations(std::ostream &output, uint64_t since);
+
+#endif
@@ -0,0 +1,104 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "arguments.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+template<typename Cell>
+void initializePointer(uint32_t argc, char *argv[], std::vector<Cell> &pointer) {
+	pointer.reserve(INITIAL_POINTER_CAPACITY);
+
+	if (argc < 1) {
+		pointer.push_back(0);
+	}
+	else {
+		// As numbers.
+		if (strcmp(argv[0], "-n") == 0 || strcmp(argv[0], "-N") == 0) {
+			argc--;
+			argv++;
+
+			pointer.push_back(argc);
+
+			for (uint32_t i = 0; i < argc; ++i)
+				pointer.push_back(atoi(argv[i]));
+		}
+		// As characters.
+		else if (strcmp(argv[0], "-c") == 0 || strcmp(argv[0], "-C") == 0) {
+			argc--;
+			argv++;
+
+			pointer.push_back(argc);
+
+			for (uint32_t i = 0; i < argc; ++i)
+				pointer.push_back((unsigned char) *argv[i]);
+		}
+		// As a string.
+		else if (strcmp(argv[0], "-s") == 0 || strcmp(argv[0], "-S") == 0) {
+			argc--;
+			argv++;
+
+			std::string buffer;
+			for (uint32_t i = 0; i < argc; ++i)
+				buffer.append(argv[i]);
+
+			pointer.push_back(buffer.length());
+
+			for (char c : buffer)
+				pointer.push_back((unsigned char) c);
+		}
+		else throw std::runtime_error(std::string("Invalid argument '") + argv[0] + "'");
+	}
+}
+
+template void initializePointer<uint8_t>(uint32_t argc, char *argv[], std::vector<uint8_t> &pointer);
+template void initializePointer<uint16_t>(uint32_t argc, char *argv[], std::vector<uint16_t> &pointer);
+template void initializePointer<uint32_t>(uint32_t argc, char *argv[], std::vector<uint32_t> &pointer);
+template void initializePointer<uint64_t>(uint32_t argc, char *argv[], std::vector<uint64_t> &pointer);
+
+/**
+ * Initializes the data pointer of an execution state from the optional arguments, for a type of cells.
+ *
+ * @tparam Cell The type of the cells.
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @param state The execution state.
+ */
+template<typename Cell>
+static void initializeCells(uint32_t argc, char *argv[], ExecutionState &state) {
+	std::vector<Cell> pointer;
+	initializePointer(argc, argv, pointer);
+	state.setPointer((const uint8_t*) pointer.data(), pointer.size() * sizeof(Cell));
+}
+
+void initializeState(uint32_t argc, char *argv[], ExecutionState &state) {
+	switch (state.getCellBits()) {
+		case 16: initializeCells<uint16_t>(argc, argv, state); break;
+		case 32: initializeCells<uint32_t>(argc, argv, state); break;
+		case 64: initializeCells<uint64_t>(argc, argv, state); break;
+		default: initializeCells<uint8_t>(argc, argv, state); break;
+	}
+}
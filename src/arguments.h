@@ -0,0 +1,56 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef X10_ARGUMENTS_H
+#define X10_ARGUMENTS_H
+
+#include "definitions.h"
+#include "engine.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Initializes the data pointer from the optional arguments (-n, -c or -s, followed by the values).
+ *
+ * @tparam Cell The type of the cells.
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @param pointer The data pointer to initialize.
+ *
+ * @throws std::runtime_error If the arguments are invalid.
+ */
+template<typename Cell>
+void initializePointer(uint32_t argc, char *argv[], std::vector<Cell> &pointer);
+/**
+ * Initializes the data pointer of an execution state from the optional arguments.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @param state The execution state, whose cell width is used.
+ *
+ * @throws std::runtime_error If the arguments are invalid.
+ */
+void initializeState(uint32_t argc, char *argv[], ExecutionState &state);
+
+#endif
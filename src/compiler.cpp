@@ -0,0 +1,704 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "compiler.h"
+#include "operators.h"
+
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <unordered_map>
+
+/// Reads a script exactly like the binary std::ifstream used by the interpreter.
+class ScriptReader {
+	private:
+		/// The script source.
+		const std::string &source;
+		/// The current position.
+		uint32_t position;
+		/// Whether the end of the script was reached (the eofbit of the stream).
+		bool end;
+
+	public:
+		explicit ScriptReader(const std::string &src) : source(src), position(0), end(false) { }
+
+		int get() {
+			if (end || position >= source.size()) {
+				end = true;
+				return EOF;
+			}
+			return (unsigned char) source[position++];
+		}
+
+		int peek() {
+			if (end || position >= source.size()) {
+				end = true;
+				return EOF;
+			}
+			return (unsigned char) source[position];
+		}
+
+		void ignore() {
+			if (end || position >= source.size())
+				end = true;
+			else ++position;
+		}
+
+		/**
+		 * Gets the position reported by tellg() when an error is raised.
+		 *
+		 * @return The current position, or the script size if the end of the script was reached.
+		 */
+		uint32_t tell() const {
+			return end ? (uint32_t) source.size() : position;
+		}
+
+		void seek(uint32_t pos) {
+			end = false;
+			position = pos;
+		}
+
+		bool eof() const {
+			return end;
+		}
+};
+
+/// The kinds of jump targets which are compiled after the current block.
+enum FixupKind : uint8_t {
+	FIXUP_OPERATION,    // The target of an operation.
+	FIXUP_SHORT_TARGET, // The short_target of an expression.
+	FIXUP_SHORT_SKIP    // The short_skip of an expression.
+};
+
+/// A jump target which is compiled after the current block.
+struct Fixup {
+	FixupKind kind;
+	/// The index of the operation or expression.
+	uint32_t index;
+	/// The position of the target in the script.
+	uint32_t position;
+};
+
+/// The state of a compilation.
+struct Compiler {
+	/// The program being compiled.
+	Program &program;
+	/// The script reader.
+	ScriptReader script;
+	/// Whether the current instruction contains a syntax error.
+	bool failed;
+	/// The operations compiled at each position of the script.
+	std::unordered_map<uint32_t, uint32_t> entries;
+	/// The jump targets which are not compiled yet.
+	std::vector<Fixup> fixups;
+
+	explicit Compiler(Program &prg) : program(prg), script(prg.source), failed(false) { }
+};
+
+/**
+ * Checks whether a character is skipped by the interpreter between instructions.
+ *
+ * @param c The character to check.
+ *
+ * @return True, if the character is a new line, space or tab. False otherwise.
+ */
+static bool isWhitespace(char c) {
+	return c == 10 || c == 13 || c == 32 || c == 9 || c == 11;
+}
+
+/**
+ * Checks whether a character is an OUTPUT_WRITE format.
+ *
+ * @param c The character to check.
+ *
+ * @return True, if the character is a format. False otherwise.
+ */
+static bool isFormat(char c) {
+	return c == 'n' || c == 'c' || c == '_' || c == '\\';
+}
+
+static uint32_t addText(Program &program, const std::string &text) {
+	program.texts.push_back(text);
+	return (uint32_t) program.texts.size() - 1;
+}
+
+static uint32_t addOperand(Compiler &compiler, OperandType type, bool negative, uint32_t number, uint32_t nested) {
+	Operand operand;
+	operand.type = type;
+	operand.negative = negative;
+	operand.number = number;
+	operand.nested = nested;
+	operand.position = compiler.script.tell();
+
+	compiler.program.operands.push_back(operand);
+	return (uint32_t) compiler.program.operands.size() - 1;
+}
+
+static uint32_t addConstant(Compiler &compiler, uint32_t number, bool negative) {
+	// The number is truncated to the width of the cells when it is executed.
+	return addOperand(compiler, OPERAND_CONSTANT, false, negative ? 0u - number : number, 0);
+}
+
+static uint32_t addTrap(Compiler &compiler, const char *message) {
+	compiler.failed = true;
+	return addOperand(compiler, OPERAND_TRAP, false, addText(compiler.program, message), 0);
+}
+
+/**
+ * Compiles a [NUM]. Mirrors parseNum(), including its quirks.
+ *
+ * @param compiler The compilation state.
+ *
+ * @return The index of the compiled operand.
+ */
+static uint32_t parseOperand(Compiler &compiler) {
+	ScriptReader &script = compiler.script;
+
+	if (script.get() != NUMBER_START)
+		return addTrap(compiler, "Expected number start");
+
+	bool neg = false; // Negative number.
+	bool val = false; // Value at index.
+	bool ind = false; // At index.
+	bool add = false; // Add.
+	bool sub = false; // Subtract.
+
+	char op = (char) script.peek();
+
+	if (op == NUMBER_END) {
+		script.ignore();
+		return addConstant(compiler, 0, false);
+	}
+	if (op == NUMBER_MODIFIER_NEGATIVE) {
+		script.ignore();
+		neg = true;
+		op = (char) script.peek();
+	}
+	if (op == NUMBER_MODIFIER_VALUE_AT) {
+		script.ignore();
+		val = true;
+		op = (char) script.peek();
+	}
+	if (op == NUMBER_MODIFIER_INDEX) {
+		script.ignore();
+		ind = true;
+		op = (char) script.peek();
+	}
+	if (op == '+') {
+		script.ignore();
+		add = true;
+		op = (char) script.peek();
+	}
+	else if (op == '-') {
+		script.ignore();
+		sub = true;
+		op = (char) script.peek();
+	}
+
+	if (!isdigit((unsigned char) op)) {
+		if (op == NUMBER_END) {
+			script.ignore();
+
+			if (!ind || add || sub)
+				return addTrap(compiler, "Expected number");
+			return addOperand(compiler, val ? OPERAND_RELATIVE_CELL : OPERAND_INDEX, neg, 0, 0);
+		}
+		if (op == NUMBER_START) {
+			uint32_t nested = parseOperand(compiler);
+			OperandType type = OPERAND_NESTED;
+
+			if (ind && val)
+				type = add ? OPERAND_CELL_AT_INDEX_PLUS_NESTED : (sub ? OPERAND_CELL_AT_INDEX_MINUS_NESTED : OPERAND_CELL_AT_NESTED);
+			else if (ind)
+				type = add ? OPERAND_INDEX_PLUS_NESTED : (sub ? OPERAND_INDEX_MINUS_NESTED : OPERAND_NESTED);
+
+			return addOperand(compiler, type, neg, 0, nested);
+		}
+		return addConstant(compiler, 0, false); // Not a number; nothing else is read.
+	}
+
+	script.ignore();
+
+	// Like std::stoi, fail if the number doesn't fit in an int.
+	uint64_t value = op - '0';
+	bool overflow = false;
+
+	while (isdigit((unsigned char) (op = (char) script.get()))) {
+		if (!overflow) {
+			value = value * 10 + (op - '0');
+			overflow = value > INT_MAX;
+		}
+	}
+
+	if (op != NUMBER_END)
+		return addTrap(compiler, "Expected number end");
+	while (script.peek() == NUMBER_END && !script.eof())
+		script.ignore();
+
+	if (overflow)
+		return addTrap(compiler, "stoi");
+
+	uint32_t num = (uint32_t) value;
+
+	if (!ind)
+		return addConstant(compiler, num, neg);
+
+	if (val) {
+		if (add)
+			return addOperand(compiler, OPERAND_RELATIVE_CELL, neg, num, 0);
+		if (sub)
+			return addOperand(compiler, OPERAND_RELATIVE_CELL, neg, 0u - num, 0);
+		return addOperand(compiler, OPERAND_CELL, neg, num, 0);
+	}
+
+	if (add) {
+		if (neg) // The number is discarded, and the next [NUM] is added to the index instead.
+			return addOperand(compiler, OPERAND_INDEX_PLUS_NESTED, true, 0, parseOperand(compiler));
+		return addOperand(compiler, OPERAND_INDEX, false, num, 0);
+	}
+	if (sub)
+		return addOperand(compiler, OPERAND_INDEX, neg, 0u - num, 0);
+	return addConstant(compiler, num, neg);
+}
+
+/**
+ * Checks whether a conditional operator follows. Mirrors the matching done by parseExpression().
+ *
+ * @param script The script reader.
+ * @param word The conditional operator.
+ *
+ * @return True, if the conditional operator was read. False otherwise.
+ */
+template<size_t N>
+static bool matchConjunction(ScriptReader &script, const char (&word)[N]) {
+	std::string conditional_operator;
+
+	for (char c : word)
+		if (script.peek() == c)
+			conditional_operator.push_back((char) script.get());
+	return conditional_operator == word;
+}
+
+/**
+ * Compiles an expression. Mirrors parseExpression().
+ *
+ * @param compiler The compilation state.
+ *
+ * @return The index of the compiled expression.
+ */
+static uint32_t parseCondition(Compiler &compiler) {
+	ScriptReader &script = compiler.script;
+	Program &program = compiler.program;
+
+	uint32_t id = (uint32_t) program.conditions.size();
+	program.conditions.emplace_back();
+
+	Condition condition;
+	condition.relation = RELATION_INVALID;
+	condition.conjunction = CONJUNCTION_NONE;
+	condition.next = 0;
+	condition.short_target = 0;
+	condition.short_skip = 0;
+	condition.left = parseOperand(compiler);
+	condition.right = condition.left;
+	condition.position = script.tell();
+
+	if (!compiler.failed) {
+		std::string relational_operator;
+		while (script.peek() != NUMBER_START && !script.eof())
+			relational_operator.push_back((char) script.get());
+
+		condition.right = parseOperand(compiler);
+		condition.position = script.tell();
+
+		if (relational_operator == RELATIONAL_EQUAL)
+			condition.relation = RELATION_EQUAL;
+		else if (relational_operator == RELATIONAL_NOT_EQUAL)
+			condition.relation = RELATION_NOT_EQUAL;
+		else if (relational_operator == RELATIONAL_GREATER_THAN)
+			condition.relation = RELATION_GREATER_THAN;
+		else if (relational_operator == RELATIONAL_GREATER_THAN_OR_EQUAL)
+			condition.relation = RELATION_GREATER_THAN_OR_EQUAL;
+		else if (relational_operator == RELATIONAL_LESS_THAN)
+			condition.relation = RELATION_LESS_THAN;
+		else if (relational_operator == RELATIONAL_LESS_THAN_OR_EQUAL)
+			condition.relation = RELATION_LESS_THAN_OR_EQUAL;
+		else if (!compiler.failed)
+			compiler.failed = true; // Raised after both numbers are evaluated.
+	}
+
+	// When the end of the script was reached, the stream fails and no conditional operator is read.
+	if (!compiler.failed && !script.eof()) {
+		uint32_t before = script.tell();
+
+		if (matchConjunction(script, CONDITIONAL_AND))
+			condition.conjunction = CONJUNCTION_AND;
+		else {
+			script.seek(before);
+			if (matchConjunction(script, CONDITIONAL_OR))
+				condition.conjunction = CONJUNCTION_OR;
+			else {
+				script.seek(before);
+				if (matchConjunction(script, CONDITIONAL_XOR))
+					condition.conjunction = CONJUNCTION_XOR;
+				else script.seek(before);
+			}
+		}
+
+		if (condition.conjunction != CONJUNCTION_NONE) {
+			if (condition.conjunction == CONJUNCTION_AND)
+				condition.short_target = script.tell(); // The position, until the targets are compiled.
+			condition.next = parseCondition(compiler);
+		}
+	}
+
+	program.conditions[id] = condition;
+	return id;
+}
+
+/**
+ * Finds the position after the end of a skipped uncertainty or loop, like the interpreter does.
+ *
+ * @param source The script source.
+ * @param from The position from which to search.
+ * @param open The character which opens a nested uncertainty or loop.
+ * @param close The character which closes an uncertainty or loop.
+ *
+ * @return The position after the closing character, or the script size if there is none.
+ */
+static uint32_t skipBody(const std::string &source, uint32_t from, char open, char close) {
+	uint32_t open_count = 1;
+
+	for (uint32_t i = from; i < source.size(); ++i) {
+		if (source[i] == open)
+			++open_count;
+		else if (source[i] == close && --open_count == 0)
+			return i + 1;
+	}
+
+	// The interpreter stops searching at the end of the script.
+	return (uint32_t) source.size();
+}
+
+static Operation makeOperation(Opcode code, uint32_t position) {
+	Operation operation;
+	operation.body = nullptr;
+	operation.code = code;
+	operation.modifier = 0;
+	operation.target_form = TARGET_CURRENT;
+	operation.operand_form = FORM_EXPRESSION;
+	operation.position = position;
+	operation.error_position = position;
+	operation.argument = 0;
+	operation.target = 0;
+	operation.value = 0;
+	operation.target_value = 0;
+	operation.multiplier = 0;
+	operation.shift = 0;
+	return operation;
+}
+
+static void trapOperation(Compiler &compiler, Operation &operation, const std::string &message) {
+	operation.code = OPCODE_TRAP;
+	operation.argument = addText(compiler.program, message);
+	operation.error_position = compiler.script.tell();
+	compiler.failed = true;
+}
+
+/**
+ * Compiles an expression which is followed by a body that is skipped if the expression is false.
+ *
+ * @param compiler The compilation state.
+ * @param operation The uncertainty or loop start.
+ * @param open The character which opens a nested uncertainty or loop.
+ * @param close The character which closes an uncertainty or loop.
+ */
+static void compileBranch(Compiler &compiler, Operation &operation, char open, char close) {
+	Program &program = compiler.program;
+
+	operation.argument = parseCondition(compiler);
+	compiler.fixups.push_back({ FIXUP_OPERATION, (uint32_t) program.operations.size(), skipBody(program.source, compiler.script.tell(), open, close) });
+
+	// If AND skips the rest of the expression, execution resumes (or the body is searched for) after AND.
+	for (uint32_t id = operation.argument;; id = program.conditions[id].next) {
+		const Condition &condition = program.conditions[id];
+
+		if (condition.conjunction == CONJUNCTION_AND) {
+			compiler.fixups.push_back({ FIXUP_SHORT_TARGET, id, condition.short_target });
+			compiler.fixups.push_back({ FIXUP_SHORT_SKIP, id, skipBody(program.source, condition.short_target, open, close) });
+		}
+		if (condition.conjunction == CONJUNCTION_NONE)
+			break;
+	}
+}
+
+/**
+ * Compiles the instruction at the current position.
+ *
+ * @param compiler The compilation state.
+ */
+static void compileInstruction(Compiler &compiler) {
+	ScriptReader &script = compiler.script;
+	Program &program = compiler.program;
+
+	Operation operation = makeOperation(OPCODE_TRAP, script.tell());
+	char identifier = (char) script.get();
+
+	switch (identifier) {
+		case '+':
+		case '-':
+			operation.code = identifier == '+' ? OPCODE_VALUE_INCREMENT : OPCODE_VALUE_DECREMENT;
+			operation.error_position = script.tell();
+			break;
+		case '(': {
+			operation.code = OPCODE_VALUE_OPERATION;
+
+			int op = 0;
+			if (script.peek() != NUMBER_START) { // Apply to current index.
+				op = script.get();
+			}
+			else {
+				operation.target_form = TARGET_EXPRESSION;
+				operation.target = parseOperand(compiler);
+				operation.argument = operation.target;
+
+				if (compiler.failed)
+					break;
+				op = script.get();
+			}
+
+			if (op == EOF || !isOperator((char) op)) {
+				operation.error_position = script.tell();
+				compiler.failed = true;
+				break;
+			}
+
+			operation.modifier = (char) op;
+			operation.argument = parseOperand(compiler);
+			operation.error_position = script.tell();
+			script.ignore(); // Ending round bracket.
+			break;
+		}
+		case '>':
+			operation.code = OPCODE_INDEX_INCREMENT;
+			break;
+		case '<':
+			operation.code = OPCODE_INDEX_DECREMENT;
+			break;
+		case '?':
+			operation.code = OPCODE_UNCERTAINTY_START;
+			compileBranch(compiler, operation, '?', '!');
+			break;
+		case '!':
+			operation.code = OPCODE_UNCERTAINTY_END;
+			operation.error_position = script.tell();
+			break;
+		case '{':
+			operation.code = OPCODE_LOOP_START;
+			compileBranch(compiler, operation, '{', '}');
+			break;
+		case '}':
+			operation.code = OPCODE_LOOP_END;
+			operation.error_position = script.tell();
+			break;
+		case '^': {
+			operation.code = OPCODE_OUTPUT_WRITE;
+			operation.error_position = script.tell();
+
+			std::string formats;
+			char format = (char) script.peek();
+
+			while (isFormat(format) && !script.eof()) {
+				script.ignore();
+				formats.push_back(format);
+				format = (char) script.peek();
+			}
+
+			operation.argument = addText(program, formats);
+			break;
+		}
+		case 'V':
+		case 'v':
+		case 'x':
+		case '&':
+		case '|':
+			operation.code = identifier == 'V' ? OPCODE_INPUT_READ : identifier == 'v' ? OPCODE_INPUT_ADD :
+			                 identifier == 'x' ? OPCODE_INPUT_XOR : identifier == '&' ? OPCODE_INPUT_AND : OPCODE_INPUT_OR;
+			operation.error_position = script.tell();
+			break;
+		case 'F': {
+			char mode = (char) script.peek();
+
+			if (mode != 'v' && mode != '^') {
+				trapOperation(compiler, operation, "Expected filename open mode");
+				break;
+			}
+
+			script.ignore();
+			if (script.peek() != '\"') {
+				trapOperation(compiler, operation, "Expected starting quotes");
+				break;
+			}
+			script.ignore();
+
+			std::string filename;
+			while (script.peek() != '\"' && !script.eof())
+				filename.push_back((char) script.get());
+
+			if (script.eof()) {
+				trapOperation(compiler, operation, "Expected ending quotes");
+				break;
+			}
+			script.ignore();
+
+			operation.code = OPCODE_FILE_OPEN;
+			operation.modifier = mode;
+			operation.argument = addText(program, filename);
+			break;
+		}
+		case 'f': {
+			char mode = (char) script.peek();
+
+			if (mode != 'v' && mode != '^') {
+				trapOperation(compiler, operation, "Expected filename close mode");
+				break;
+			}
+			script.ignore();
+
+			operation.code = OPCODE_FILE_CLOSE;
+			operation.modifier = mode;
+			operation.error_position = script.tell();
+			break;
+		}
+		case 'R':
+		case 'W':
+			operation.code = identifier == 'R' ? OPCODE_BULK_READ : OPCODE_BULK_WRITE;
+			operation.argument = parseOperand(compiler);
+			operation.target = operation.argument;
+
+			if (compiler.failed)
+				break;
+			operation.target = parseOperand(compiler);
+			operation.error_position = script.tell();
+			break;
+		case 'S':
+		case 'M':
+		case 'C': {
+			operation.code = identifier == 'S' ? OPCODE_MEMORY_FILL : identifier == 'M' ? OPCODE_MEMORY_MOVE : OPCODE_MEMORY_COMPARE;
+
+			uint32_t *operands[] = { &operation.argument, &operation.target, &operation.value, &operation.target_value };
+			for (uint32_t i = 0; i < (identifier == 'C' ? 4u : 3u) && !compiler.failed; ++i)
+				*operands[i] = parseOperand(compiler);
+			operation.error_position = script.tell();
+			break;
+		}
+		default: {
+			char message[32];
+			snprintf(message, sizeof(message), "%s '%c'", "Invalid instruction", identifier);
+			trapOperation(compiler, operation, message);
+			break;
+		}
+	}
+
+	program.operations.push_back(operation);
+}
+
+/**
+ * Compiles the instructions which are executed sequentially from a position, if they weren't compiled yet.
+ *
+ * @param compiler The compilation state.
+ * @param start The position.
+ *
+ * @return The index of the operation which is executed at the position.
+ */
+static uint32_t compileBlock(Compiler &compiler, uint32_t start) {
+	Program &program = compiler.program;
+	ScriptReader &script = compiler.script;
+	uint32_t first = UINT32_MAX;
+	uint32_t position = start;
+
+	while (true) {
+		while (position < program.source.size() && isWhitespace(program.source[position]))
+			++position;
+
+		auto entry = compiler.entries.find(position);
+		if (entry != compiler.entries.end()) {
+			if (first == UINT32_MAX)
+				return entry->second;
+
+			Operation jump = makeOperation(OPCODE_JUMP, position);
+			jump.target = entry->second;
+			program.operations.push_back(jump);
+			break;
+		}
+
+		if (first == UINT32_MAX)
+			first = (uint32_t) program.operations.size();
+
+		if (position >= program.source.size()) {
+			program.operations.push_back(makeOperation(OPCODE_HALT, position));
+			break;
+		}
+
+		compiler.entries[position] = (uint32_t) program.operations.size();
+		compiler.failed = false;
+
+		script.seek(position);
+		compileInstruction(compiler);
+
+		// An instruction with a syntax error always raises it, so nothing is executed after it.
+		if (compiler.failed)
+			break;
+		// Once the end of the script is reached, the interpreter stops.
+		if (script.eof()) {
+			program.operations.push_back(makeOperation(OPCODE_HALT, (uint32_t) program.source.size()));
+			break;
+		}
+
+		position = script.tell();
+	}
+
+	return first;
+}
+
+void compileScript(const std::string &source, Program &program) {
+	program.source = source;
+	program.operations.clear();
+	program.operands.clear();
+	program.conditions.clear();
+	program.texts.clear();
+
+	Compiler compiler(program);
+	compileBlock(compiler, 0);
+
+	while (!compiler.fixups.empty()) {
+		Fixup fixup = compiler.fixups.back();
+		compiler.fixups.pop_back();
+
+		uint32_t target = compileBlock(compiler, fixup.position);
+		if (fixup.kind == FIXUP_OPERATION)
+			program.operations[fixup.index].target = target;
+		else if (fixup.kind == FIXUP_SHORT_TARGET)
+			program.conditions[fixup.index].short_target = target;
+		else program.conditions[fixup.index].short_skip = target;
+	}
+}
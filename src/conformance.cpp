@@ -0,0 +1,672 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "conformance.h"
+#include "instruction_handler.h"
+#include "compiler.h"
+#include "engine.h"
+#include "optimizer.h"
+
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define X10_FORK
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/// The amount of seconds after which an execution is terminated.
+#define CONFORMANCE_TIMEOUT 1
+/// The input of the corpus scripts.
+#define CONFORMANCE_INPUT "5 7 300 2 9 1 0 255\n"
+
+/**
+ * Executes a script through the reference interpreter.
+ *
+ * @param source The script.
+ * @param initial The initial data pointer.
+ * @param input_text The input.
+ * @param result The variable which will contain the result.
+ */
+static void executeReference(const std::string &source, const std::vector<uint8_t> &initial, const std::string &input_text, ExecutionResult &result) {
+	std::istringstream script(source);
+	std::istringstream input(input_text);
+	std::ostringstream output;
+
+	std::ifstream *file_input = nullptr;
+	std::ofstream *file_output = nullptr;
+
+	std::vector<uint8_t> pointer = initial;
+	uint32_t index = 0;
+	uint32_t uncertainty_count = 0;
+	LoopStack loop_stack = createLoopStack(script);
+
+	try {
+		executeScript(POINTER_INFO_PARAMS);
+	}
+	catch (std::exception &e) {
+		result.failed = true;
+		result.error_position = scriptPosition(script);
+		result.error = e.what();
+	}
+
+	result.output = output.str();
+	result.pointer.assign(pointer.begin(), pointer.end());
+	result.index = index;
+
+	delete file_input;
+	delete file_output;
+}
+
+/**
+ * Executes a script through the compiled engine.
+ *
+ * @tparam TAPE The kind of data pointer.
+ * @tparam OPTIMIZE Whether to optimize the program before executing it.
+ * @tparam TIERED Whether to start executing the program unoptimized, and optimize it once a loop is repeated twice.
+ * @tparam CELL_BITS The width of the cells.
+ * @param source The script.
+ * @param initial The initial data pointer.
+ * @param input_text The input.
+ * @param result The variable which will contain the result.
+ */
+template<TapeKind TAPE, bool OPTIMIZE = false, bool TIERED = false, uint8_t CELL_BITS = CELL_BITS_DEFAULT>
+static void executeCompiled(const std::string &source, const std::vector<uint8_t> &initial, const std::string &input_text, ExecutionResult &result) {
+	typedef typename std::conditional<CELL_BITS == 8, uint8_t, typename std::conditional<CELL_BITS == 16, uint16_t,
+	        typename std::conditional<CELL_BITS == 32, uint32_t, uint64_t>::type>::type>::type Cell;
+
+	std::istringstream input(input_text);
+	std::ostringstream output;
+
+	Program program;
+	std::unique_ptr<ExecutionState> execution = createExecutionState(TAPE, CELL_BITS);
+	ExecutionState &state = *execution;
+
+	std::vector<Cell> cells(initial.begin(), initial.end());
+	state.input = &input;
+	state.output = &output;
+	state.program = &program;
+	state.setPointer((const uint8_t*) cells.data(), cells.size() * sizeof(Cell));
+
+	compileScript(source, program);
+	std::unique_ptr<TieredProgram> tiers(TIERED ? new TieredProgram(program, 2, PassOptions()) : nullptr);
+	state.tiers = tiers.get();
+
+	if (OPTIMIZE)
+		optimizeProgram(program, CELL_BITS);
+	bindProgram(program, TAPE, CELL_BITS, TIERED);
+	prepareExecution(state);
+
+	try {
+		executeProgram(state);
+	}
+	catch (ExecutionError &e) {
+		result.failed = true;
+		result.error_position = e.position;
+		result.error = e.what();
+	}
+	catch (std::bad_alloc &e) {
+		result.exhausted = true;
+	}
+	catch (std::exception &e) {
+		result.failed = true;
+		result.error_position = state.program->operations[state.pc].error_position;
+		result.error = e.what();
+	}
+
+	// Paged data pointers which were padded to billions of cells can't be copied either.
+	try {
+		std::vector<uint8_t> bytes;
+		state.getPointer(bytes);
+		cells.resize(bytes.size() / sizeof(Cell));
+		memcpy(cells.data(), bytes.data(), bytes.size());
+		result.pointer.assign(cells.begin(), cells.end());
+	}
+	catch (std::bad_alloc &e) {
+		result.exhausted = true;
+	}
+
+	result.output = output.str();
+	result.index = state.index;
+
+	delete state.file_input;
+	delete state.file_output;
+}
+
+const std::vector<ConformanceEngine> conformance_engines = {
+	{ "reference", executeReference, 8, true },
+	{ "compiled", executeCompiled<TAPE_DENSE>, 8, false },
+	{ "paged", executeCompiled<TAPE_PAGED>, 8, false },
+	{ "optimized", executeCompiled<TAPE_DENSE, true>, 8, false },
+	{ "tiered", executeCompiled<TAPE_DENSE, false, true>, 8, false },
+	{ "compiled-16", executeCompiled<TAPE_DENSE, false, false, 16>, 16, true },
+	{ "paged-16", executeCompiled<TAPE_PAGED, false, false, 16>, 16, false },
+	{ "optimized-16", executeCompiled<TAPE_DENSE, true, false, 16>, 16, false },
+	{ "tiered-16", executeCompiled<TAPE_DENSE, false, true, 16>, 16, false },
+	{ "compiled-32", executeCompiled<TAPE_DENSE, false, false, 32>, 32, true },
+	{ "paged-32", executeCompiled<TAPE_PAGED, false, false, 32>, 32, false },
+	{ "optimized-32", executeCompiled<TAPE_DENSE, true, false, 32>, 32, false },
+	{ "tiered-32", executeCompiled<TAPE_DENSE, false, true, 32>, 32, false },
+	{ "compiled-64", executeCompiled<TAPE_DENSE, false, false, 64>, 64, true },
+	{ "paged-64", executeCompiled<TAPE_PAGED, false, false, 64>, 64, false },
+	{ "optimized-64", executeCompiled<TAPE_DENSE, true, false, 64>, 64, false },
+	{ "tiered-64", executeCompiled<TAPE_DENSE, false, true, 64>, 64, false }
+};
+
+/**
+ * Gets the engine against which an engine is checked.
+ *
+ * @param engine The engine.
+ *
+ * @return The baseline with the same cell width.
+ */
+static const ConformanceEngine &getBaseline(const ConformanceEngine &engine) {
+	for (const ConformanceEngine &baseline : conformance_engines)
+		if (baseline.baseline && baseline.cell_bits == engine.cell_bits)
+			return baseline;
+	return conformance_engines[0];
+}
+
+/**
+ * Appends a value to a serialized result.
+ *
+ * @param data The serialized result.
+ * @param value The value.
+ */
+template<typename T>
+static void appendValue(std::string &data, T value) {
+	data.append((const char*) &value, sizeof(T));
+}
+
+/**
+ * Appends bytes to a serialized result, prefixed by their amount.
+ *
+ * @param data The serialized result.
+ * @param bytes The bytes.
+ * @param size The amount of bytes.
+ */
+static void appendBytes(std::string &data, const void *bytes, size_t size) {
+	appendValue<uint32_t>(data, (uint32_t) size);
+	data.append((const char*) bytes, size);
+}
+
+/**
+ * Extracts a value from a serialized result.
+ *
+ * @param data The serialized result.
+ * @param offset The offset of the value, which is advanced past it.
+ *
+ * @return The value.
+ */
+template<typename T>
+static T extractValue(const std::string &data, size_t &offset) {
+	T value{};
+	if (offset + sizeof(T) <= data.size())
+		memcpy(&value, data.data() + offset, sizeof(T));
+	offset += sizeof(T);
+	return value;
+}
+
+/**
+ * Extracts bytes from a serialized result.
+ *
+ * @param data The serialized result.
+ * @param offset The offset of the bytes, which is advanced past them.
+ *
+ * @return The bytes.
+ */
+static std::string extractBytes(const std::string &data, size_t &offset) {
+	uint32_t size = extractValue<uint32_t>(data, offset);
+	if (offset > data.size() || size > data.size() - offset)
+		return std::string();
+
+	offset += size;
+	return data.substr(offset - size, size);
+}
+
+/**
+ * Executes a script through an engine. On POSIX, the engine is executed in a child process,
+ * so that crashes and infinite loops are reported instead of stopping the harness.
+ *
+ * @param engine The engine.
+ * @param script The script.
+ * @param pointer The initial data pointer.
+ * @param input The input.
+ * @param result The variable which will contain the result.
+ */
+static void isolate(const ConformanceEngine &engine, const std::string &script, const std::vector<uint8_t> &pointer, const std::string &input, ExecutionResult &result) {
+#ifdef X10_FORK
+	int fds[2];
+	if (pipe(fds) != 0)
+		throw std::runtime_error("Cannot create a pipe");
+
+	pid_t pid = fork();
+	if (pid == -1)
+		throw std::runtime_error("Cannot create a process");
+
+	if (pid == 0) {
+		close(fds[0]);
+		alarm(CONFORMANCE_TIMEOUT);
+
+		ExecutionResult child;
+		try {
+			engine.execute(script, pointer, input, child);
+		}
+		catch (std::bad_alloc &e) {
+			child = ExecutionResult();
+			child.exhausted = true;
+		}
+
+		std::string data;
+		appendBytes(data, child.output.data(), child.output.size());
+		appendBytes(data, child.pointer.data(), child.pointer.size() * sizeof(uint64_t));
+		appendValue<uint32_t>(data, child.index);
+		appendValue<uint8_t>(data, child.failed);
+		appendValue<uint32_t>(data, child.error_position);
+		appendBytes(data, child.error.data(), child.error.size());
+		appendValue<uint8_t>(data, child.exhausted);
+
+		for (size_t written = 0; written < data.size();) {
+			ssize_t count = write(fds[1], data.data() + written, data.size() - written);
+			if (count <= 0)
+				break;
+			written += count;
+		}
+		_exit(EXIT_SUCCESS);
+	}
+
+	close(fds[1]);
+
+	std::string data;
+	char buffer[4096];
+	ssize_t count;
+	while ((count = read(fds[0], buffer, sizeof(buffer))) > 0)
+		data.append(buffer, count);
+	close(fds[0]);
+
+	int status;
+	waitpid(pid, &status, 0);
+
+	if (WIFSIGNALED(status)) {
+		result.signal = WTERMSIG(status);
+		return;
+	}
+
+	size_t offset = 0;
+	result.output = extractBytes(data, offset);
+	std::string pointer_bytes = extractBytes(data, offset);
+	result.pointer.resize(pointer_bytes.size() / sizeof(uint64_t));
+	memcpy(result.pointer.data(), pointer_bytes.data(), result.pointer.size() * sizeof(uint64_t));
+	result.index = extractValue<uint32_t>(data, offset);
+	result.failed = extractValue<uint8_t>(data, offset) != 0;
+	result.error_position = extractValue<uint32_t>(data, offset);
+	result.error = extractBytes(data, offset);
+	result.exhausted = extractValue<uint8_t>(data, offset) != 0;
+#else
+	engine.execute(script, pointer, input, result);
+#endif
+}
+
+/**
+ * Compares the results of two executions.
+ *
+ * @param expected The result of the baseline.
+ * @param actual The result of another engine.
+ *
+ * @return What differs between the results, or nullptr if they match.
+ */
+static const char *compareResults(const ExecutionResult &expected, const ExecutionResult &actual) {
+	if (expected.exhausted || actual.exhausted)
+		return nullptr;
+	if (expected.signal != actual.signal)
+		return "termination";
+	if (expected.signal != 0)
+		return nullptr; // Nothing else was observed.
+	if (expected.output != actual.output)
+		return "output";
+	if (expected.failed != actual.failed || expected.error != actual.error)
+		return "error";
+	if (expected.error_position != actual.error_position)
+		return "error position";
+	if (expected.index != actual.index)
+		return "index";
+	if (expected.pointer != actual.pointer)
+		return "data pointer";
+	return nullptr;
+}
+
+/**
+ * Checks whether an engine diverges from its baseline on a script.
+ *
+ * @param engine The engine.
+ * @param script The script.
+ * @param pointer The initial data pointer.
+ * @param input The input.
+ * @param expected The variable which will contain the result of the baseline.
+ * @param actual The variable which will contain the result of the engine.
+ *
+ * @return What differs between the results, or nullptr if they match.
+ */
+static const char *diverges(const ConformanceEngine &engine, const std::string &script, const std::vector<uint8_t> &pointer, const std::string &input, ExecutionResult &expected, ExecutionResult &actual) {
+	expected = ExecutionResult();
+	actual = ExecutionResult();
+
+	isolate(getBaseline(engine), script, pointer, input, expected);
+	isolate(engine, script, pointer, input, actual);
+
+	return compareResults(expected, actual);
+}
+
+/**
+ * Removes parts of a divergent script for as long as the same difference remains.
+ *
+ * @param engine The engine.
+ * @param script The divergent script, which is minimized.
+ * @param pointer The initial data pointer.
+ * @param input The input.
+ * @param difference What differs between the results.
+ */
+static void minimize(const ConformanceEngine &engine, std::string &script, const std::vector<uint8_t> &pointer, const std::string &input, const char *difference) {
+	ExecutionResult expected, actual;
+
+	size_t chunk = script.size() / 2;
+	while (chunk > 0) {
+		bool removed = false;
+
+		for (size_t start = 0; start < script.size();) {
+			std::string candidate = script;
+			candidate.erase(start, chunk);
+
+			const char *candidate_difference = diverges(engine, candidate, pointer, input, expected, actual);
+			if (candidate_difference != nullptr && strcmp(candidate_difference, difference) == 0) {
+				script = candidate;
+				removed = true;
+			}
+			else start += chunk;
+		}
+
+		if (!removed)
+			chunk /= 2;
+	}
+}
+
+/**
+ * Escapes the characters which cannot be printed.
+ *
+ * @param text The text.
+ *
+ * @return The escaped text.
+ */
+static std::string escape(const std::string &text) {
+	std::string escaped;
+
+	for (char c : text) {
+		if (c == '\n')
+			escaped.append("\\n");
+		else if (c == '\\')
+			escaped.append("\\\\");
+		else if ((uint8_t) c < 32 || (uint8_t) c > 126) {
+			char code[5];
+			snprintf(code, sizeof(code), "\\x%02X", (uint8_t) c);
+			escaped.append(code);
+		}
+		else escaped.push_back(c);
+	}
+
+	return escaped;
+}
+
+/**
+ * Writes a result to a report.
+ *
+ * @param report The stream where to write.
+ * @param name The name of the engine.
+ * @param result The result.
+ */
+static void reportResult(std::ostream &report, const char *name, const ExecutionResult &result) {
+	report << "  " << name << ": ";
+
+	if (result.signal != 0) {
+		report << "terminated by signal " << result.signal << '\n';
+		return;
+	}
+
+	report << "output \"" << escape(result.output) << "\", index " << result.index << ", data pointer [";
+	for (size_t i = 0; i < result.pointer.size(); ++i)
+		report << (i == 0 ? "" : " ") << result.pointer[i];
+	report << ']';
+
+	if (result.failed)
+		report << ", error at " << result.error_position << ": " << result.error;
+	report << '\n';
+}
+
+/// Generates random X10 programs. The programs are well-formed, except for rare syntax errors.
+class ProgramGenerator {
+	public:
+		explicit ProgramGenerator(uint32_t seed) : random(seed) { }
+
+		/// Generates a program.
+		std::string program() {
+			return body(0);
+		}
+
+		/// Generates the initial data pointer, as set by the -n argument.
+		std::vector<uint8_t> pointer() {
+			std::vector<uint8_t> values(1, (uint8_t) between(0, 5));
+			for (uint8_t i = 0; i < values[0]; ++i)
+				values.push_back((uint8_t) between(0, 255));
+			return values;
+		}
+
+		/// Generates the input.
+		std::string input() {
+			std::string text;
+			for (int i = between(0, 8); i > 0; --i)
+				text.append(std::to_string(between(0, 300))).push_back(' ');
+			return text;
+		}
+
+	private:
+		std::mt19937 random;
+
+		int between(int min, int max) {
+			return std::uniform_int_distribution<int>(min, max)(random);
+		}
+
+		bool chance(double probability) {
+			return std::uniform_real_distribution<double>(0.0, 1.0)(random) < probability;
+		}
+
+		template<typename T, size_t N>
+		const T &pick(const T (&items)[N]) {
+			return items[between(0, N - 1)];
+		}
+
+		std::string number(int depth = 0) {
+			static const char *prefixes[] = { "$i+", "$i-", "i+", "i-", "$i", "i", "", "-", "-$i+", "-i+" };
+			static const char *forms[] = { "#", "-#", "i", "-i", "$i", "-$i", "i+#", "i-#", "$i+#", "$i-#", "$i#", "-$i#", "", "-i+#" };
+			static const char *constants[] = { "0", "1", "2", "3", "5", "7", "250", "255", "256", "300", "2147483647", "2147483648" };
+
+			if (depth < 2 && chance(0.08))
+				return std::string("[") + pick(prefixes) + number(depth + 1) + ']';
+
+			std::string form = pick(forms);
+			std::string text = "[";
+			for (char c : form) {
+				if (c == '#')
+					text.append(pick(constants));
+				else text.push_back(c);
+			}
+
+			if (!chance(0.02)) // Rarely, leave the number unterminated.
+				text.push_back(']');
+			return text;
+		}
+
+		std::string condition() {
+			static const char *relations[] = { "EQ", "NEQ", "GT", "GTE", "LT", "LTE" };
+			static const char *conjunctions[] = { "AND", "OR", "XOR" };
+
+			std::string text = number() + (chance(0.02) ? "EQU" : pick(relations)) + number();
+			if (chance(0.25))
+				text.append(pick(conjunctions)).append(condition());
+			return text;
+		}
+
+		std::string body(int depth) {
+			static const char *spaces[] = { " ", "\n", "\t" };
+			static const char *malformed[] = { "!", "}", "Z", ")", "?[1]EQ[0]", "{[0]EQ[1]" };
+
+			std::string text;
+
+			for (int count = between(1, 8); count > 0; --count) {
+				double kind = std::uniform_real_distribution<double>(0.0, 1.0)(random);
+
+				if (kind < 0.15)
+					text.push_back(chance(0.5) ? '+' : '-');
+				else if (kind < 0.35)
+					text.push_back(chance(0.7) ? '>' : '<');
+				else if (kind < 0.55) {
+					text.push_back('(');
+					if (chance(0.25))
+						text.append(number());
+
+					char op = chance(0.01) ? 'q' : "$+-*/%x&|"[between(0, 8)];
+					text.push_back(op);
+
+					if ((op == '/' || op == '%') && chance(0.9))
+						text.append("[" + std::to_string(between(1, 9)) + "]");
+					else text.append(number());
+					text.push_back(')');
+				}
+				else if (kind < 0.65) {
+					text.push_back('^');
+					for (int formats = between(0, 3); formats > 0; --formats)
+						text.push_back("nc_\\"[between(0, 3)]);
+				}
+				else if (kind < 0.72)
+					text.push_back("Vvx&|"[between(0, 4)]);
+				else if (kind < 0.82 && depth < 3)
+					text.append("?").append(condition()).append(body(depth + 1)).append("!");
+				else if (kind < 0.9 && depth < 3) {
+					// A counted loop, which uses a cell far from the cells used by the body. Its counter is sometimes
+					// higher than the amount of copies of an unrolled body, so that the copies are repeated.
+					std::string counter = std::to_string(200 + depth);
+					text.append("([" + counter + "]$[" + std::to_string(between(0, 9)) + "]){[$i" + counter + "]GT[0]");
+					text.append(body(depth + 1));
+					text.append("([" + counter + "]-[1])}");
+				}
+				else if (kind < 0.92)
+					text.append(pick(spaces));
+				else if (kind < 0.93)
+					text.append(pick(malformed));
+				else if (kind < 0.95)
+					text.append(chance(0.5) ? "R" : "W").append(number()).append(number());
+				else if (kind < 0.97) {
+					char memory = "SMC"[between(0, 2)];
+					text.push_back(memory);
+					for (int operands = memory == 'C' ? 4 : 3; operands > 0; --operands)
+						text.append(number());
+				}
+			}
+
+			return text;
+		}
+};
+
+/**
+ * Checks a script through every engine, and reports the divergences.
+ *
+ * @param name The name of the script.
+ * @param script The script.
+ * @param pointer The initial data pointer.
+ * @param input The input.
+ * @param report The stream where to report divergences.
+ *
+ * @return The amount of divergent engines.
+ */
+static uint32_t checkScript(const std::string &name, const std::string &script, const std::vector<uint8_t> &pointer, const std::string &input, std::ostream &report) {
+	uint32_t divergences = 0;
+	ExecutionResult expected, actual;
+
+	for (const ConformanceEngine &engine : conformance_engines) {
+		if (engine.baseline)
+			continue;
+
+		const char *difference = diverges(engine, script, pointer, input, expected, actual);
+		if (difference == nullptr)
+			continue;
+
+		++divergences;
+
+		std::string minimized = script;
+		minimize(engine, minimized, pointer, input, difference);
+		diverges(engine, minimized, pointer, input, expected, actual);
+
+		report << "[DIVERGENCE] " << engine.name << " differs in " << difference << " on " << name << '\n';
+		report << "  script: " << escape(script) << '\n';
+		report << "  minimized: " << escape(minimized) << '\n';
+		report << "  arguments: -n";
+		for (size_t j = 1; j < pointer.size(); ++j)
+			report << ' ' << (uint16_t) pointer[j];
+		report << "\n  input: \"" << escape(input) << "\"\n";
+
+		reportResult(report, getBaseline(engine).name, expected);
+		reportResult(report, engine.name, actual);
+		report.flush();
+	}
+
+	return divergences;
+}
+
+uint32_t checkConformance(const std::vector<std::string> &corpus, uint32_t count, uint32_t seed, std::ostream &report) {
+	uint32_t divergences = 0;
+
+	for (const std::string &file : corpus) {
+		std::ifstream stream(file, std::ios::binary);
+		if (stream.fail()) {
+			report << "[ERROR]: Cannot read '" << file << "'\n";
+			++divergences;
+			continue;
+		}
+
+		std::string script((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+		divergences += checkScript("'" + file + "'", script, std::vector<uint8_t>(1, 0), CONFORMANCE_INPUT, report);
+	}
+
+	for (uint32_t i = 0; i < count; ++i) {
+		ProgramGenerator generator(seed + i);
+
+		std::string script = generator.program();
+		std::vector<uint8_t> pointer = generator.pointer();
+		std::string input = generator.input();
+
+		divergences += checkScript("random program (seed " + std::to_string(seed + i) + ")", script, pointer, input, report);
+	}
+
+	return divergences;
+}
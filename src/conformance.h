@@ -0,0 +1,89 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef X10_CONFORMANCE_H
+#define X10_CONFORMANCE_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// The observable result of executing a script.
+struct ExecutionResult {
+	/// Everything that was written to the output.
+	std::string output;
+	/// The final data pointer, as values.
+	std::vector<uint64_t> pointer;
+	/// The final index.
+	uint32_t index = 0;
+	/// Whether the script raised an error.
+	bool failed = false;
+	/// The position where the error was raised.
+	uint32_t error_position = 0;
+	/// The error.
+	std::string error;
+	/// The signal which terminated the execution (e.g. SIGFPE), or 0.
+	int signal = 0;
+	/// Whether the engine ran out of memory. Wide cells can address billions of cells, which some engines allocate
+	/// and others don't, so such results are not compared.
+	bool exhausted = false;
+};
+
+/// An engine which is checked against the reference interpreter.
+struct ConformanceEngine {
+	/// The name of the engine, as passed to --engine, followed by the cell width if it isn't 8 bits.
+	const char *name;
+	/**
+	 * Executes a script.
+	 *
+	 * @param script The script.
+	 * @param pointer The initial data pointer.
+	 * @param input The input.
+	 * @param result The variable which will contain the result.
+	 */
+	void (*execute)(const std::string &script, const std::vector<uint8_t> &pointer, const std::string &input, ExecutionResult &result);
+	/// The width of the cells.
+	uint8_t cell_bits;
+	/// Whether this engine is the baseline of its cell width, against which the other engines with the same width are checked.
+	bool baseline;
+};
+
+/// The engines. The first one is the reference interpreter, which is the baseline of 8-bit cells. The reference interpreter
+/// only has 8-bit cells, so wider cells are checked against the compiled engine, unoptimized, with the same width.
+extern const std::vector<ConformanceEngine> conformance_engines;
+
+/**
+ * Executes scripts through every engine, and compares the output, the final data pointer and index, and the errors,
+ * with the ones of the baseline of the same cell width. The scripts are the corpus and randomly generated programs.
+ * Divergent programs are minimized and reported.
+ *
+ * @param corpus The script files of the corpus.
+ * @param count The amount of random programs.
+ * @param seed The seed of the first random program.
+ * @param report The stream where to report divergences.
+ *
+ * @return The amount of divergences.
+ */
+uint32_t checkConformance(const std::vector<std::string> &corpus, uint32_t count, uint32_t seed, std::ostream &report);
+
+#endif
@@ -0,0 +1,618 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "daemon.h"
+#include "daemon_protocol.h"
+#include "arguments.h"
+#include "compiler.h"
+#include "engine.h"
+#include "optimizer.h"
+#include "hash.h"
+#include "timerh/timer.h"
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <streambuf>
+#include <thread>
+#include <unordered_map>
+
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/// A compiled script, bound for the tape and the cell width with which it is executed.
+struct CachedProgram {
+	Program program;
+	TapeKind tape;
+};
+
+/// The compiled scripts, by script and options. The least recently used script is evicted when the cache is full.
+class ProgramCache {
+	public:
+		explicit ProgramCache(size_t capacity) : capacity(capacity) { }
+
+		/**
+		 * Finds a compiled script, and marks it as the most recently used one.
+		 *
+		 * @param key The script and the options.
+		 *
+		 * @return The compiled script, or null if it isn't cached.
+		 */
+		std::shared_ptr<const CachedProgram> find(const std::string &key) {
+			std::lock_guard<std::mutex> lock(mutex);
+
+			auto entry = index.find(key);
+			if (entry == index.end())
+				return nullptr;
+
+			entries.splice(entries.begin(), entries, entry->second);
+			return entry->second->second;
+		}
+
+		/**
+		 * Caches a compiled script, evicting the least recently used one if the cache is full.
+		 *
+		 * @param key The script and the options.
+		 * @param program The compiled script.
+		 */
+		void insert(const std::string &key, const std::shared_ptr<const CachedProgram> &program) {
+			std::lock_guard<std::mutex> lock(mutex);
+
+			// Another worker may have compiled the same script meanwhile.
+			if (capacity == 0 || index.find(key) != index.end())
+				return;
+
+			if (entries.size() >= capacity) {
+				index.erase(entries.back().first);
+				entries.pop_back();
+			}
+
+			entries.emplace_front(key, program);
+			index.emplace(key, entries.begin());
+		}
+
+	private:
+		typedef std::list<std::pair<std::string, std::shared_ptr<const CachedProgram>>> EntryList;
+
+		size_t capacity;
+		/// The compiled scripts, from the most recently used one to the least recently used one.
+		EntryList entries;
+		std::unordered_map<std::string, EntryList::iterator> index;
+		std::mutex mutex;
+};
+
+/// The connections which wait for a worker.
+class ConnectionQueue {
+	public:
+		/**
+		 * Queues a connection.
+		 *
+		 * @param connection The socket of the connection.
+		 */
+		void push(int connection) {
+			std::lock_guard<std::mutex> lock(mutex);
+			connections.push_back(connection);
+			available.notify_one();
+		}
+
+		/**
+		 * Takes the next connection. Waits while the queue is empty.
+		 *
+		 * @param connection The variable which will contain the socket of the connection.
+		 *
+		 * @return True, if a connection was taken. False if the queue was closed, and is empty.
+		 */
+		bool pop(int &connection) {
+			std::unique_lock<std::mutex> lock(mutex);
+			available.wait(lock, [this] { return !connections.empty() || closed; });
+
+			if (connections.empty())
+				return false;
+
+			connection = connections.front();
+			connections.pop_front();
+			return true;
+		}
+
+		/// Wakes the workers, which stop once the queue is empty.
+		void close() {
+			std::lock_guard<std::mutex> lock(mutex);
+			closed = true;
+			available.notify_all();
+		}
+
+	private:
+		std::deque<int> connections;
+		bool closed = false;
+
+		std::mutex mutex;
+		/// Signaled when a connection is queued, or when the queue is closed.
+		std::condition_variable available;
+};
+
+/// Raised when the client of a request disconnects.
+class ClientDisconnected : public std::runtime_error {
+	public:
+		ClientDisconnected() : std::runtime_error("The client disconnected") { }
+};
+
+/// An output buffer which sends its contents to the client in frames, once full or when flushed.
+class FrameOutput : public std::streambuf {
+	public:
+		explicit FrameOutput(int socket) : socket(socket) {
+			setp(buffer, buffer + sizeof(buffer));
+		}
+
+		/**
+		 * Sends the buffered output.
+		 *
+		 * @return True, if the output was sent. False if the client disconnected.
+		 */
+		bool send() {
+			size_t size = pptr() - pbase();
+			setp(buffer, buffer + sizeof(buffer));
+
+			return size == 0 || sendFrame(socket, FRAME_OUTPUT, buffer, size);
+		}
+
+	protected:
+		int_type overflow(int_type c) override {
+			if (!send())
+				throw ClientDisconnected();
+
+			if (!traits_type::eq_int_type(c, traits_type::eof())) {
+				*pptr() = traits_type::to_char_type(c);
+				pbump(1);
+			}
+			return traits_type::not_eof(c);
+		}
+
+		int sync() override {
+			if (!send())
+				throw ClientDisconnected();
+			return 0;
+		}
+
+	private:
+		int socket;
+		char buffer[DAEMON_BLOCK_SIZE];
+};
+
+/// An input buffer which asks the client for the next block of input whenever it is empty.
+class FrameInput : public std::streambuf {
+	public:
+		FrameInput(int socket, FrameOutput &output) : socket(socket), output(output) { }
+
+	protected:
+		int_type underflow() override {
+			if (gptr() < egptr())
+				return traits_type::to_int_type(*gptr());
+			if (ended)
+				return traits_type::eof();
+
+			// The output written so far is shown before the client is asked for input, like a terminal would.
+			FrameType type;
+			if (!output.send() || !sendFrame(socket, FRAME_READ, nullptr, 0) || !receiveFrame(socket, type, block) || type != FRAME_INPUT)
+				throw ClientDisconnected();
+
+			if (block.empty()) {
+				ended = true;
+				return traits_type::eof();
+			}
+
+			setg(&block[0], &block[0], &block[0] + block.size());
+			return traits_type::to_int_type(*gptr());
+		}
+
+	private:
+		int socket;
+		FrameOutput &output;
+		/// The last block of input.
+		std::string block;
+		/// Whether the client sent the end of the input.
+		bool ended = false;
+};
+
+/// A request which was received from a client.
+struct DaemonRequest {
+	/// The working directory of the client, against which the script and the files it opens are resolved.
+	std::string directory;
+	/// The arguments of x10, without the name of the program.
+	std::vector<std::string> arguments;
+	/// The body of the script, if it was sent along with the request.
+	std::string body;
+	/// Whether the body of the script was sent.
+	bool has_body = false;
+};
+
+/// Set by SIGINT and SIGTERM.
+static volatile std::sig_atomic_t stop_requested = 0;
+
+/**
+ * Requests the daemon to stop.
+ *
+ * @param signal The signal.
+ */
+static void stopHandler(int signal) {
+	stop_requested = 1;
+}
+
+/**
+ * Receives a request.
+ *
+ * @param socket The socket of the connection.
+ * @param request The variable which will contain the request.
+ *
+ * @return True, if a request was received. False if the connection was closed, or the request is invalid.
+ */
+static bool receiveRequest(int socket, DaemonRequest &request) {
+	FrameType type;
+	std::string payload;
+
+	if (!receiveFrame(socket, type, payload))
+		return false;
+	if (type == FRAME_SCRIPT) {
+		request.body.swap(payload);
+		request.has_body = true;
+
+		if (!receiveFrame(socket, type, payload))
+			return false;
+	}
+	if (type != FRAME_REQUEST || payload.empty() || payload.back() != '\0')
+		return false;
+
+	std::vector<std::string> strings;
+	for (size_t start = 0; start < payload.size(); ) {
+		size_t end = payload.find('\0', start);
+		strings.emplace_back(payload, start, end - start);
+		start = end + 1;
+	}
+
+	request.directory = strings[0];
+	request.arguments.assign(strings.begin() + 1, strings.end());
+	return true;
+}
+
+/**
+ * Finds the compiled script of a request in the cache, or compiles it and caches it.
+ *
+ * @param request The request.
+ * @param script The script, as it was passed to x10.
+ * @param automatic_tape Whether to select the kind of data pointer from the script.
+ * @param tape The kind of data pointer, if it isn't selected from the script.
+ * @param cell_bits The width of the cells.
+ * @param optimize Whether to optimize the script.
+ * @param cache The compiled scripts.
+ *
+ * @return The compiled script, or null if the script file cannot be read.
+ */
+static std::shared_ptr<const CachedProgram> loadProgram(const DaemonRequest &request, const std::string &script, bool automatic_tape, TapeKind tape,
+                                                        uint8_t cell_bits, bool optimize, ProgramCache &cache) {
+	std::string path = script.empty() || script[0] == '/' ? script : request.directory + '/' + script;
+	std::string key = std::to_string(cell_bits) + (optimize ? "o" : "") + (automatic_tape ? "a" : tape == TAPE_PAGED ? "p" : "d");
+
+	if (request.has_body) {
+		uint64_t hash = hashBytes(request.body.data(), request.body.size());
+		key += ":body:" + std::to_string(hash) + ':' + std::to_string(request.body.size());
+	}
+	else {
+		// A script file is compiled again once it is modified.
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+			return nullptr;
+
+#ifdef __linux__
+		uint64_t modified = (uint64_t) info.st_mtim.tv_sec * 1000000000ull + info.st_mtim.tv_nsec;
+#else
+		uint64_t modified = (uint64_t) info.st_mtime;
+#endif
+		key += ":file:" + std::to_string(modified) + ':' + std::to_string(info.st_size) + ':' + std::to_string(info.st_ino) + ':' + path;
+	}
+
+	std::shared_ptr<const CachedProgram> cached = cache.find(key);
+	if (cached != nullptr)
+		return cached;
+
+	std::string source;
+	if (request.has_body)
+		source = request.body;
+	else {
+		std::ifstream file(path, std::ios::binary);
+		if (file.fail())
+			return nullptr;
+		source.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	std::shared_ptr<CachedProgram> compiled = std::make_shared<CachedProgram>();
+	compileScript(source, compiled->program);
+	if (optimize)
+		optimizeProgram(compiled->program, cell_bits);
+
+	compiled->tape = automatic_tape ? (compiled->program.hasWideAddressRange() ? TAPE_PAGED : TAPE_DENSE) : tape;
+	bindProgram(compiled->program, compiled->tape, cell_bits);
+
+	cache.insert(key, compiled);
+	return compiled;
+}
+
+/**
+ * Executes a request, like x10 would execute it with the compiled engine.
+ *
+ * @param socket The socket of the connection.
+ * @param request The request.
+ * @param cache The compiled scripts.
+ * @param output The output of the script.
+ * @param buffer The buffer of the output, which is sent before input is requested.
+ * @param errors The variable which will contain the error written to STDERR, if any.
+ *
+ * @return The exit code.
+ */
+static uint32_t executeRequest(int socket, const DaemonRequest &request, ProgramCache &cache, std::ostream &output, FrameOutput &buffer, std::string &errors) {
+	CHRONOMETER chronometer = time_now();
+
+	bool automatic_tape = true, optimize = true;
+	TapeKind tape = TAPE_DENSE;
+	uint8_t cell_bits = CELL_BITS_DEFAULT;
+
+	size_t first = 0;
+	for (; first < request.arguments.size() && request.arguments[first].compare(0, 2, "--") == 0; ++first) {
+		const std::string &option = request.arguments[first];
+
+		if (!isDaemonOption(option.c_str())) {
+			errors = "[ERROR]: Unsupported option '" + option + "'";
+			return EXIT_FAILURE;
+		}
+
+		if (option == "--no-optimize")
+			optimize = false;
+		else if (option == "--tape=auto")
+			automatic_tape = true;
+		else if (option.compare(0, 7, "--tape=") == 0) {
+			automatic_tape = false;
+			tape = option == "--tape=paged" ? TAPE_PAGED : TAPE_DENSE;
+		}
+		else if (option.compare(0, 12, "--cell-bits=") == 0)
+			cell_bits = (uint8_t) atoi(option.c_str() + 12);
+	}
+
+	if (first >= request.arguments.size()) {
+		errors = "[ERROR]: Invalid arguments";
+		return EXIT_FAILURE;
+	}
+
+	std::shared_ptr<const CachedProgram> cached = loadProgram(request, request.arguments[first], automatic_tape, tape, cell_bits, optimize, cache);
+	if (cached == nullptr) {
+		errors = "[ERROR]: Invalid script file";
+		return EXIT_FAILURE;
+	}
+	const Program &program = cached->program;
+
+	std::vector<char*> argv;
+	for (size_t i = first + 1; i < request.arguments.size(); ++i)
+		argv.push_back(const_cast<char*>(request.arguments[i].c_str()));
+
+	std::unique_ptr<ExecutionState> execution = createExecutionState(cached->tape, cell_bits);
+	ExecutionState &state = *execution;
+
+	FrameInput input_buffer(socket, buffer);
+	std::istream input(&input_buffer);
+	input.exceptions(std::ios::badbit);
+
+	state.input = &input;
+	state.output = &output;
+	state.program = &program;
+	state.directory = request.directory;
+
+	try {
+		initializeState((uint32_t) argv.size(), argv.data(), state);
+	}
+	catch (std::exception &e) {
+		errors = std::string("\n[ERROR]: ") + e.what();
+		return EXIT_FAILURE;
+	}
+
+	prepareExecution(state);
+
+	uint32_t status = EXIT_SUCCESS;
+	try {
+		executeProgram(state);
+
+		std::string time = getf_exec_time_ns(chronometer);
+		output << "\n[INFO] Execution took " << time << '\n';
+	}
+	catch (ClientDisconnected &e) {
+		status = EXIT_FAILURE;
+	}
+	catch (ExecutionError &e) {
+		errors = "\n[ERROR] [Instruction " + std::to_string(e.position) + "]: " + e.what();
+		status = EXIT_FAILURE;
+	}
+	catch (std::exception &e) {
+		errors = "\n[ERROR] [Instruction " + std::to_string(program.operations[state.pc].error_position) + "]: " + e.what();
+		status = EXIT_FAILURE;
+	}
+
+	delete state.file_input;
+	delete state.file_output;
+	state.file_input = nullptr;
+	state.file_output = nullptr;
+
+	return status;
+}
+
+/**
+ * Serves a connection: receives a request, executes it, and closes the connection.
+ *
+ * @param socket The socket of the connection.
+ * @param cache The compiled scripts.
+ */
+static void serveConnection(int socket, ProgramCache &cache) {
+	DaemonRequest request;
+
+	if (receiveRequest(socket, request)) {
+		FrameOutput buffer(socket);
+		std::ostream output(&buffer);
+		output.exceptions(std::ios::badbit);
+
+		std::string errors;
+		uint32_t status = executeRequest(socket, request, cache, output, buffer, errors);
+
+		// STDOUT is written before STDERR, like when x10 exits.
+		if (buffer.send() && (errors.empty() || sendFrame(socket, FRAME_ERROR, errors.data(), errors.size()))) {
+			unsigned char code[4] = { (unsigned char) status, (unsigned char) (status >> 8), (unsigned char) (status >> 16), (unsigned char) (status >> 24) };
+			sendFrame(socket, FRAME_EXIT, code, sizeof(code));
+		}
+	}
+
+	close(socket);
+}
+
+/**
+ * Serves connections until the queue is closed.
+ *
+ * @param queue The connections which wait for a worker.
+ * @param cache The compiled scripts.
+ */
+static void serveConnections(ConnectionQueue &queue, ProgramCache &cache) {
+	int connection;
+	while (queue.pop(connection))
+		serveConnection(connection, cache);
+}
+
+/**
+ * Creates the directory of the socket, readable only by the user, if it doesn't exist.
+ * Otherwise, checks that other users cannot replace the socket in it.
+ *
+ * @param socket The path of the socket.
+ *
+ * @throws std::runtime_error If other users can replace the socket.
+ */
+static void prepareSocketDirectory(const std::string &socket) {
+	size_t separator = socket.rfind('/');
+	std::string directory = separator == std::string::npos ? "." : separator == 0 ? "/" : socket.substr(0, separator);
+
+	mkdir(directory.c_str(), 0700);
+
+	// E.g. /tmp belongs to root and is sticky, while XDG_RUNTIME_DIR belongs to the user.
+	struct stat info;
+	if (lstat(directory.c_str(), &info) != 0 || !S_ISDIR(info.st_mode) || (info.st_uid != geteuid() && info.st_uid != 0) ||
+	    ((info.st_mode & (S_IWGRP | S_IWOTH)) != 0 && (info.st_mode & S_ISVTX) == 0))
+		throw std::runtime_error("Other users can replace the socket in " + directory);
+}
+
+void runDaemon(const DaemonOptions &options) {
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	if (options.socket.size() >= sizeof(address.sun_path))
+		throw std::runtime_error("The path of the socket is too long");
+	memcpy(address.sun_path, options.socket.c_str(), options.socket.size());
+
+	prepareSocketDirectory(options.socket);
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener == -1)
+		throw std::runtime_error("Cannot create the socket");
+
+	// A socket which was left behind by a daemon that didn't stop is replaced, unless a daemon still listens on it.
+	if (connect(listener, (sockaddr*) &address, sizeof(address)) == 0) {
+		close(listener);
+		throw std::runtime_error("Another daemon listens on " + options.socket);
+	}
+	close(listener);
+	unlink(options.socket.c_str());
+
+	// Only the user can connect to the socket, since it executes scripts (and opens their files) with the rights of the daemon.
+	mode_t mask = umask(077);
+	listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	bool bound = listener != -1 && bind(listener, (sockaddr*) &address, sizeof(address)) == 0;
+	umask(mask);
+
+	if (!bound || listen(listener, SOMAXCONN) != 0) {
+		if (listener != -1)
+			close(listener);
+		throw std::runtime_error("Cannot listen on " + options.socket);
+	}
+
+	// The handlers don't restart accept(), so that it returns once a stop is requested.
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = stopHandler;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+	signal(SIGPIPE, SIG_IGN);
+
+	uint32_t jobs = options.jobs != 0 ? options.jobs : std::thread::hardware_concurrency();
+	if (jobs == 0)
+		jobs = 1;
+
+	ProgramCache cache(options.cache_size);
+	ConnectionQueue queue;
+
+	// The workers inherit a mask which blocks the stop signals, so that they are delivered to accept().
+	sigset_t signals, previous;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, &previous);
+
+	std::vector<std::thread> workers;
+	workers.reserve(jobs);
+	for (uint32_t i = 0; i < jobs; ++i)
+		workers.emplace_back(serveConnections, std::ref(queue), std::ref(cache));
+
+	pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+
+	while (!stop_requested) {
+		int connection = accept(listener, nullptr, nullptr);
+
+		if (connection != -1 && !isOwnPeer(connection))
+			close(connection); // E.g. a socket whose permissions were changed.
+		else if (connection != -1)
+			queue.push(connection);
+		else if (errno != EINTR && errno != ECONNABORTED)
+			std::this_thread::sleep_for(std::chrono::milliseconds(10)); // E.g. out of file descriptors, until a connection is closed.
+	}
+
+	close(listener);
+	unlink(options.socket.c_str());
+
+	queue.close();
+	for (std::thread &worker : workers)
+		worker.join();
+}
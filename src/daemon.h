@@ -0,0 +1,57 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef X10_DAEMON_H
+#define X10_DAEMON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// The default amount of compiled scripts kept by the daemon.
+#define DAEMON_CACHE_SIZE 64
+
+/// How the daemon listens, and executes requests.
+struct DaemonOptions {
+	/// The Unix socket on which to listen.
+	std::string socket;
+	/// The amount of worker threads, or 0 for one per core. Each worker serves one connection at a time.
+	uint32_t jobs = 0;
+	/// The amount of compiled scripts which are kept. The least recently used one is evicted first.
+	size_t cache_size = DAEMON_CACHE_SIZE;
+};
+
+/**
+ * Listens on a Unix socket, and executes the requests of the clients in-process, on a pool of worker threads.
+ * Compiled scripts are cached by path, modification time and options (or by body, if the script is sent along with the request).
+ * Output is streamed back in blocks as it is written, and input is requested from the client when the script needs it.
+ * Returns once SIGINT or SIGTERM is received, after the requests in progress are finished.
+ * The socket is only accessible by the user, and connections from other users are closed without being served.
+ *
+ * @param options The options of the daemon.
+ *
+ * @throws std::runtime_error If the daemon cannot listen on the socket, or if other users can replace it.
+ */
+void runDaemon(const DaemonOptions &options);
+
+#endif
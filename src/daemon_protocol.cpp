@@ -0,0 +1,145 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "daemon_protocol.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+std::string getDaemonSocket() {
+	const char *socket = getenv(DAEMON_SOCKET_VARIABLE);
+	if (socket != nullptr && *socket != '\0')
+		return socket;
+
+	const char *runtime = getenv("XDG_RUNTIME_DIR");
+	if (runtime != nullptr && *runtime != '\0')
+		return std::string(runtime) + "/x10d.sock";
+
+	return "/tmp/x10d-" + std::to_string(getuid()) + "/x10d.sock";
+}
+
+bool isOwnPeer(int socket) {
+#ifdef __linux__
+	ucred credentials;
+	socklen_t size = sizeof(credentials);
+	return getsockopt(socket, SOL_SOCKET, SO_PEERCRED, &credentials, &size) == 0 && credentials.uid == geteuid();
+#else
+	uid_t uid;
+	gid_t gid;
+	return getpeereid(socket, &uid, &gid) == 0 && uid == geteuid();
+#endif
+}
+
+bool isDaemonOption(const char *option) {
+	return strcmp(option, "--engine=compiled") == 0 || strcmp(option, "--no-optimize") == 0 ||
+	       strcmp(option, "--tape=dense") == 0 || strcmp(option, "--tape=paged") == 0 || strcmp(option, "--tape=auto") == 0 ||
+	       strcmp(option, "--cell-bits=8") == 0 || strcmp(option, "--cell-bits=16") == 0 ||
+	       strcmp(option, "--cell-bits=32") == 0 || strcmp(option, "--cell-bits=64") == 0;
+}
+
+/**
+ * Sends bytes. Retries interrupted and partial writes.
+ *
+ * @param socket The socket.
+ * @param data The bytes.
+ * @param size The amount of bytes.
+ *
+ * @return True, if every byte was sent.
+ */
+static bool sendBytes(int socket, const char *data, size_t size) {
+	while (size != 0) {
+		ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+		if (sent < 0 && errno == EINTR)
+			continue;
+		if (sent <= 0)
+			return false;
+
+		data += sent;
+		size -= (size_t) sent;
+	}
+
+	return true;
+}
+
+/**
+ * Receives bytes. Retries interrupted and partial reads.
+ *
+ * @param socket The socket.
+ * @param data The buffer.
+ * @param size The amount of bytes.
+ *
+ * @return True, if every byte was received.
+ */
+static bool receiveBytes(int socket, char *data, size_t size) {
+	while (size != 0) {
+		ssize_t received = recv(socket, data, size, 0);
+		if (received < 0 && errno == EINTR)
+			continue;
+		if (received <= 0)
+			return false;
+
+		data += received;
+		size -= (size_t) received;
+	}
+
+	return true;
+}
+
+bool sendFrame(int socket, FrameType type, const void *payload, size_t size) {
+	if (size > DAEMON_FRAME_LIMIT)
+		return false;
+
+	char header[5] = { (char) type, (char) size, (char) (size >> 8), (char) (size >> 16), (char) (size >> 24) };
+
+	// Blocks are sent along with their header, with a single call.
+	if (size <= DAEMON_BLOCK_SIZE) {
+		char frame[sizeof(header) + DAEMON_BLOCK_SIZE];
+		memcpy(frame, header, sizeof(header));
+		if (size != 0)
+			memcpy(frame + sizeof(header), payload, size);
+		return sendBytes(socket, frame, sizeof(header) + size);
+	}
+
+	return sendBytes(socket, header, sizeof(header)) && sendBytes(socket, (const char*) payload, size);
+}
+
+bool receiveFrame(int socket, FrameType &type, std::string &payload) {
+	unsigned char header[5];
+	if (!receiveBytes(socket, (char*) header, sizeof(header)))
+		return false;
+
+	uint32_t size = header[1] | (uint32_t) header[2] << 8 | (uint32_t) header[3] << 16 | (uint32_t) header[4] << 24;
+	if (header[0] > FRAME_EXIT || size > DAEMON_FRAME_LIMIT)
+		return false;
+
+	type = (FrameType) header[0];
+	payload.resize(size);
+	return size == 0 || receiveBytes(socket, &payload[0], size);
+}
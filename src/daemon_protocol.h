@@ -0,0 +1,103 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef X10_DAEMON_PROTOCOL_H
+#define X10_DAEMON_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// The environment variable which overrides the socket of the daemon.
+#define DAEMON_SOCKET_VARIABLE "X10D_SOCKET"
+/// The environment variable which overrides the interpreter the client falls back to.
+#define DAEMON_INTERPRETER_VARIABLE "X10_INTERPRETER"
+/// The largest payload of a frame, in bytes.
+#define DAEMON_FRAME_LIMIT (1u << 24)
+/// The size of the input and output blocks sent in frames, in bytes.
+#define DAEMON_BLOCK_SIZE 65536
+
+/**
+ * The kinds of frames. Every frame is a type byte, followed by the size of the payload (32-bit little endian), and the payload.
+ *
+ * A request is an optional SCRIPT frame, followed by a REQUEST frame. The daemon answers with OUTPUT and ERROR frames,
+ * and sends a READ frame whenever the script needs more input, which the client answers with an INPUT frame.
+ * The last frame of the answer is EXIT.
+ */
+enum FrameType : uint8_t {
+	FRAME_SCRIPT,  // The body of the script, which is then only named by the request. Sent by the client.
+	FRAME_REQUEST, // The working directory and the arguments of x10 (options, script, optional arguments), each ending with '\0'. Sent by the client.
+	FRAME_INPUT,   // A block of input, or the end of the input if empty. Sent by the client.
+	FRAME_READ,    // Asks for the next block of input. Sent by the daemon.
+	FRAME_OUTPUT,  // A block of STDOUT. Sent by the daemon.
+	FRAME_ERROR,   // A block of STDERR. Sent by the daemon.
+	FRAME_EXIT     // The exit code (32-bit little endian). Sent by the daemon.
+};
+
+/**
+ * Gets the socket of the daemon: the value of X10D_SOCKET, or x10d.sock in XDG_RUNTIME_DIR, or x10d.sock in a directory of /tmp
+ * which is specific to the user (see runDaemon).
+ *
+ * @return The path of the socket.
+ */
+std::string getDaemonSocket();
+/**
+ * Checks whether the other end of a connection belongs to the same user, so that neither the daemon nor the client talk to
+ * another user which bound the socket first or connected to it.
+ *
+ * @param socket The socket of the connection.
+ *
+ * @return True, if the other end belongs to the same user. False otherwise, or if it cannot be checked.
+ */
+bool isOwnPeer(int socket);
+/**
+ * Checks whether the daemon executes scripts with an interpreter option. Scripts with other options are executed by x10.
+ *
+ * @param option The option.
+ *
+ * @return True, if the daemon supports the option.
+ */
+bool isDaemonOption(const char *option);
+/**
+ * Sends a frame. Retries interrupted and partial writes.
+ *
+ * @param socket The socket.
+ * @param type The type of the frame.
+ * @param payload The payload.
+ * @param size The size of the payload, in bytes.
+ *
+ * @return True, if the frame was sent. False if the connection was closed.
+ */
+bool sendFrame(int socket, FrameType type, const void *payload, size_t size);
+/**
+ * Receives a frame. Retries interrupted and partial reads.
+ *
+ * @param socket The socket.
+ * @param type The variable which will contain the type of the frame.
+ * @param payload The variable which will contain the payload.
+ *
+ * @return True, if a frame was received. False if the connection was closed, or the frame is invalid.
+ */
+bool receiveFrame(int socket, FrameType &type, std::string &payload);
+
+#endif
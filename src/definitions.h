@@ -29,9 +29,18 @@
 #include <istream>
 #include <ostream>
 
-#define POINTER_INFO std::vector<uint8_t> &pointer, uint32_t &index, std::ifstream &script, std::istream &input, std::ostream &output, std::ifstream *&file_input, std::ofstream *&file_output, std::stack<std::streampos> &loop_stack, uint32_t &uncertainty_count
+/// The loop stack of the interpreter. Backed by a vector, so that it doesn't allocate once its capacity is reserved.
+typedef std::stack<std::streampos, std::vector<std::streampos>> LoopStack;
+
+#define POINTER_INFO std::vector<uint8_t> &pointer, uint32_t &index, std::istream &script, std::istream &input, std::ostream &output, std::ifstream *&file_input, std::ofstream *&file_output, LoopStack &loop_stack, uint32_t &uncertainty_count
 #define POINTER_INFO_PARAMS pointer, index, script, input, output, file_input, file_output, loop_stack, uncertainty_count
 
+#define OPERATION_INFO ExecutionState &state, const Operation &operation
+#define OPERATION_INFO_PARAMS state, operation
+
+/// The amount of cells reserved for the data pointer before execution.
+#define INITIAL_POINTER_CAPACITY 4096
+
 #define NUMBER_START '['
 #define NUMBER_END ']'
 #define NUMBER_MODIFIER_INDEX 'i'
@@ -49,6 +58,16 @@
 #define CONDITIONAL_OR "OR"
 #define CONDITIONAL_XOR "XOR"
 
+#define OPERATOR_SET '$'
+#define OPERATOR_ADD '+'
+#define OPERATOR_SUBTRACT '-'
+#define OPERATOR_MULTIPLY '*'
+#define OPERATOR_DIVIDE '/'
+#define OPERATOR_MODULO '%'
+#define OPERATOR_XOR 'x'
+#define OPERATOR_AND '&'
+#define OPERATOR_OR '|'
+
 typedef void(*Body)(POINTER_INFO);
 
 #endif
\ No newline at end of file
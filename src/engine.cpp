@@ -0,0 +1,1575 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "engine.h"
+#include "operators.h"
+#include "range_map.h"
+#include "trace.h"
+#include "virtual_clock.h"
+#include "timerh/timer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+ExecutionState::ExecutionState() {
+	index = 0;
+	input = nullptr;
+	output = nullptr;
+	file_input = nullptr;
+	file_output = nullptr;
+	uncertainty_count = 0;
+	loop_count = 0;
+	pc = 0;
+	program = nullptr;
+	suspend_before_input = false;
+	trace = nullptr;
+	tiers = nullptr;
+}
+
+volatile std::sig_atomic_t suspend_requested = 0;
+
+const char *ExecutionSuspended::what() const noexcept {
+	return "Execution suspended";
+}
+
+ExecutionState::~ExecutionState() = default;
+
+TieredProgram::TieredProgram(const Program &program, uint32_t threshold, const PassOptions &passes)
+	: optimized(program), passes(passes), threshold(threshold), repetitions(program.operations.size(), 0) {
+	promoted = false;
+	hot_position = 0;
+	promotion_time = 0;
+}
+
+void TieredProgram::report(std::ostream &output) const {
+	if (!promoted) {
+		output << "\n[INFO] Executed in the baseline tier: no loop repeated " << threshold << " times";
+		return;
+	}
+
+	output << "\n[INFO] Promoted to the optimized tier by the loop end at position " << hot_position << ", after " << threshold
+	       << " repetitions: optimized " << repetitions.size() << " operations to " << optimized.operations.size() << " in "
+	       << format_time_ns(promotion_time);
+}
+
+/// Raised by a LOOP_END of a baseline program when its loop becomes hot. Caught by executeProgram().
+class LoopBecameHot {};
+
+ExecutionError::ExecutionError(const std::string &message, uint32_t pos) : std::runtime_error(message) {
+	position = pos;
+}
+
+/// The dense data pointer.
+template<typename Cell>
+using DenseTape = std::vector<Cell>;
+
+/**
+ * Copies the cells of a data pointer, as they are stored in memory.
+ *
+ * @param pointer The data pointer.
+ * @param bytes The variable which will contain the cells.
+ */
+template<typename Cell>
+static void copyTape(const DenseTape<Cell> &pointer, std::vector<uint8_t> &bytes) {
+	bytes.resize(pointer.size() * sizeof(Cell));
+	if (!pointer.empty())
+		memcpy(bytes.data(), pointer.data(), bytes.size());
+}
+
+template<typename Cell>
+static void copyTape(const PagedTape<Cell> &pointer, std::vector<uint8_t> &bytes) {
+	pointer.copy(bytes);
+}
+
+/**
+ * Replaces the cells of a data pointer.
+ *
+ * @param pointer The data pointer.
+ * @param bytes The cells, as they are stored in memory.
+ * @param size The amount of cells.
+ */
+template<typename Cell>
+static void assignTape(DenseTape<Cell> &pointer, const uint8_t *bytes, size_t size) {
+	pointer.reserve(size > INITIAL_POINTER_CAPACITY ? size : INITIAL_POINTER_CAPACITY);
+	pointer.resize(size);
+	if (size != 0)
+		memcpy(pointer.data(), bytes, size * sizeof(Cell));
+}
+
+template<typename Cell>
+static void assignTape(PagedTape<Cell> &pointer, const uint8_t *bytes, size_t size) {
+	pointer.assign(bytes, size);
+}
+
+/**
+ * The state of a program which is being executed, along with its data pointer.
+ *
+ * @tparam Tape The type of the data pointer.
+ */
+template<typename Tape>
+struct TapeState : public ExecutionState {
+	/// The data pointer.
+	Tape pointer;
+
+	size_t getSize() const override {
+		return pointer.size();
+	}
+
+	uint8_t getCellBits() const override {
+		return sizeof(typename Tape::value_type) * 8;
+	}
+
+	void getPointer(std::vector<uint8_t> &bytes) const override {
+		copyTape(pointer, bytes);
+	}
+
+	void setPointer(const uint8_t *bytes, size_t size) override {
+		assignTape(pointer, bytes, size / sizeof(typename Tape::value_type));
+	}
+
+	TapeKind getTapeKind() const override {
+		return std::is_same<Tape, DenseTape<typename Tape::value_type>>::value ? TAPE_DENSE : TAPE_PAGED;
+	}
+
+	uint64_t evaluate(uint32_t operand) override;
+};
+
+/**
+ * Gets the data pointer of an execution state.
+ *
+ * @tparam Tape The type of the data pointer.
+ * @param state The execution state.
+ *
+ * @return The data pointer.
+ */
+template<typename Tape>
+static inline Tape &tapeOf(ExecutionState &state) {
+	return static_cast<TapeState<Tape>&>(state).pointer;
+}
+
+/// The type in which operands are evaluated. It is at least as wide as the index, like the arithmetic done by parseNum().
+template<typename Tape>
+using Value = typename std::conditional<(sizeof(typename Tape::value_type) > sizeof(uint32_t)), typename Tape::value_type, uint32_t>::type;
+
+/**
+ * Widens a number of an operand to the type in which operands are evaluated.
+ * Numbers are compiled to 32 bits, so they are sign-extended in order to keep negative numbers negative.
+ *
+ * @param number The number.
+ *
+ * @return The widened number.
+ */
+template<typename Tape>
+static inline Value<Tape> widen(uint32_t number) {
+	return (Value<Tape>) (int32_t) number;
+}
+
+/**
+ * Raises the error that pointer.at() raises for an invalid index.
+ *
+ * @param pointer The data pointer.
+ * @param index The invalid index.
+ * @param position The position where the error is raised.
+ */
+template<typename Tape>
+[[noreturn]] static void rangeError(const Tape &pointer, uint64_t index, uint32_t position) {
+	try {
+		pointer.at(index);
+	}
+	catch (std::out_of_range &e) {
+		throw ExecutionError(e.what(), position);
+	}
+	throw ExecutionError("Invalid index", position);
+}
+
+/**
+ * Gets the value at an index in order to write it, like pointer.at() does.
+ *
+ * @param pointer The data pointer.
+ * @param index The index.
+ * @param position The position where an error is raised, if the index is invalid.
+ *
+ * @return The value at the index.
+ */
+template<typename Tape>
+static inline typename Tape::value_type &cellAt(Tape &pointer, uint64_t index, uint32_t position) {
+	if (index >= pointer.size())
+		rangeError(pointer, index, position);
+	return pointer[index];
+}
+
+/**
+ * Reads the value at an index, like pointer.at() does.
+ *
+ * @param pointer The data pointer.
+ * @param index The index.
+ * @param position The position where an error is raised, if the index is invalid.
+ *
+ * @return The value at the index.
+ */
+template<typename Tape>
+static inline typename Tape::value_type readCell(const Tape &pointer, uint64_t index, uint32_t position) {
+	if (index >= pointer.size())
+		rangeError(pointer, index, position);
+	return pointer[index];
+}
+
+/**
+ * Evaluates an operand, like parseNum() does.
+ *
+ * @param state The execution state.
+ * @param id The index of the operand.
+ *
+ * @return The value of the operand.
+ */
+template<typename Tape>
+static typename Tape::value_type evaluateOperand(ExecutionState &state, uint32_t id) {
+	const Operand &operand = state.program->operands[id];
+	const Tape &pointer = tapeOf<Tape>(state);
+	Value<Tape> value;
+
+	switch (operand.type) {
+		case OPERAND_CONSTANT:
+			value = widen<Tape>(operand.number);
+			break;
+		case OPERAND_INDEX:
+			value = state.index + widen<Tape>(operand.number);
+			break;
+		case OPERAND_CELL:
+			value = readCell(pointer, operand.number, operand.position);
+			break;
+		case OPERAND_RELATIVE_CELL:
+			value = readCell(pointer, state.index + operand.number, operand.position);
+			break;
+		case OPERAND_NESTED:
+			value = evaluateOperand<Tape>(state, operand.nested);
+			break;
+		case OPERAND_INDEX_PLUS_NESTED:
+			value = state.index + evaluateOperand<Tape>(state, operand.nested);
+			break;
+		case OPERAND_INDEX_MINUS_NESTED:
+			value = state.index - evaluateOperand<Tape>(state, operand.nested);
+			break;
+		case OPERAND_CELL_AT_NESTED:
+			value = readCell(pointer, evaluateOperand<Tape>(state, operand.nested), operand.position);
+			break;
+		case OPERAND_CELL_AT_INDEX_PLUS_NESTED:
+			value = readCell(pointer, state.index + evaluateOperand<Tape>(state, operand.nested), operand.position);
+			break;
+		case OPERAND_CELL_AT_INDEX_MINUS_NESTED:
+			value = readCell(pointer, state.index - evaluateOperand<Tape>(state, operand.nested), operand.position);
+			break;
+		default:
+			throw ExecutionError(state.program->texts[operand.number], operand.position);
+	}
+
+	return (typename Tape::value_type) (operand.negative ? 0u - value : value);
+}
+
+template<typename Tape>
+uint64_t TapeState<Tape>::evaluate(uint32_t operand) {
+	return evaluateOperand<Tape>(*this, operand);
+}
+
+/// Marks an expression which was evaluated without AND skipping the rest of it.
+#define CONDITION_COMPLETE UINT32_MAX
+
+/**
+ * Evaluates an expression, like parseExpression() does.
+ *
+ * @param state The execution state.
+ * @param id The index of the expression.
+ * @param stop The variable which will contain the expression whose AND skipped the rest, if any.
+ *
+ * @return The value of the expression.
+ */
+template<typename Tape>
+static bool evaluateCondition(ExecutionState &state, uint32_t id, uint32_t &stop) {
+	const Condition &condition = state.program->conditions[id];
+
+	typename Tape::value_type left = evaluateOperand<Tape>(state, condition.left);
+	typename Tape::value_type right = evaluateOperand<Tape>(state, condition.right);
+
+	bool expression;
+	switch (condition.relation) {
+		case RELATION_EQUAL: expression = left == right; break;
+		case RELATION_NOT_EQUAL: expression = left != right; break;
+		case RELATION_GREATER_THAN: expression = left > right; break;
+		case RELATION_GREATER_THAN_OR_EQUAL: expression = left >= right; break;
+		case RELATION_LESS_THAN: expression = left < right; break;
+		case RELATION_LESS_THAN_OR_EQUAL: expression = left <= right; break;
+		default: throw ExecutionError("Invalid relational operator", condition.position);
+	}
+
+	switch (condition.conjunction) {
+		case CONJUNCTION_AND:
+			if (!expression) {
+				stop = id;
+				return false;
+			}
+			return evaluateCondition<Tape>(state, condition.next, stop);
+		case CONJUNCTION_OR:
+			return evaluateCondition<Tape>(state, condition.next, stop) || expression; // The next expression is always evaluated.
+		case CONJUNCTION_XOR:
+			return expression != evaluateCondition<Tape>(state, condition.next, stop);
+		default:
+			return expression;
+	}
+}
+
+/**
+ * Evaluates the operand of a VALUE_OPERATION.
+ *
+ * @tparam FORM The form of the operand.
+ * @tparam Tape The type of the data pointer.
+ * @param state The execution state.
+ * @param operation The operation.
+ *
+ * @return The value of the operand.
+ */
+template<OperandForm FORM, typename Tape>
+static inline typename Tape::value_type evaluateForm(OPERATION_INFO) {
+	const Tape &pointer = tapeOf<Tape>(state);
+
+	if constexpr (FORM == FORM_CONSTANT)
+		return (typename Tape::value_type) widen<Tape>(operation.value);
+	else if constexpr (FORM == FORM_INDEX)
+		return (typename Tape::value_type) (state.index + widen<Tape>(operation.value));
+	else if constexpr (FORM == FORM_CELL) {
+		if (operation.value >= pointer.size())
+			rangeError(pointer, operation.value, state.program->operands[operation.argument].position);
+		return pointer[operation.value];
+	}
+	else if constexpr (FORM == FORM_RELATIVE_CELL) {
+		uint32_t index = state.index + operation.value;
+		if (index >= pointer.size())
+			rangeError(pointer, index, state.program->operands[operation.argument].position);
+		return pointer[index];
+	}
+	else return evaluateOperand<Tape>(state, operation.argument);
+}
+
+/**
+ * Evaluates the target of a VALUE_OPERATION. Targets past the highest index are raised as range errors,
+ * instead of padding the data pointer with more cells than an index can address.
+ *
+ * @tparam Tape The type of the data pointer.
+ * @param state The execution state.
+ * @param operation The operation.
+ *
+ * @return The index of the target.
+ */
+template<typename Tape>
+static inline uint32_t evaluateTarget(OPERATION_INFO) {
+	typename Tape::value_type target = evaluateOperand<Tape>(state, operation.target);
+
+	if constexpr (sizeof(target) >= sizeof(uint32_t))
+		if (target >= UINT32_MAX)
+			rangeError(tapeOf<Tape>(state), target, state.program->operands[operation.target].position);
+	return (uint32_t) target;
+}
+
+static void EXECUTE_HALT(OPERATION_INFO) {
+	state.pc = (uint32_t) state.program->operations.size();
+}
+
+static void EXECUTE_TRAP(OPERATION_INFO) {
+	throw ExecutionError(state.program->texts[operation.argument], operation.error_position);
+}
+
+static void EXECUTE_JUMP(OPERATION_INFO) {
+	state.pc = operation.target;
+}
+
+template<typename Tape>
+static void EXECUTE_VALUE_INCREMENT(OPERATION_INFO) {
+	cellAt(tapeOf<Tape>(state), state.index, operation.error_position)++;
+	++state.pc;
+}
+
+template<typename Tape>
+static void EXECUTE_VALUE_DECREMENT(OPERATION_INFO) {
+	cellAt(tapeOf<Tape>(state), state.index, operation.error_position)--;
+	++state.pc;
+}
+
+/**
+ * Raises an error if a VALUE_OPERATION divides or takes the remainder by 0, instead of letting the processor trap.
+ *
+ * @tparam OPERATOR The operator.
+ * @param value The value of the operand.
+ * @param operation The operation.
+ */
+template<char OPERATOR, typename Cell>
+static inline void checkDivisor(Cell value, const Operation &operation) {
+	if constexpr (OPERATOR == OPERATOR_DIVIDE || OPERATOR == OPERATOR_MODULO)
+		if (value == 0)
+			throw ExecutionError("Division by zero", operation.error_position);
+}
+
+/**
+ * Executes a VALUE_OPERATION. Instantiated for every operator, target form and operand form.
+ *
+ * @tparam OPERATOR The operator.
+ * @tparam TARGET The form of the target.
+ * @tparam FORM The form of the operand.
+ * @tparam Tape The type of the data pointer.
+ */
+template<char OPERATOR, TargetForm TARGET, OperandForm FORM, typename Tape>
+static void EXECUTE_VALUE_OPERATION(OPERATION_INFO) {
+	Tape &pointer = tapeOf<Tape>(state);
+
+	if constexpr (TARGET == TARGET_CURRENT) {
+		typename Tape::value_type value = evaluateForm<FORM, Tape>(OPERATION_INFO_PARAMS);
+		checkDivisor<OPERATOR>(value, operation);
+		typename Tape::value_type &cell = cellAt(pointer, state.index, operation.error_position);
+		cell = applyOperator<OPERATOR>(cell, value);
+	}
+	else {
+		uint32_t target = TARGET == TARGET_CONSTANT ? operation.target_value : evaluateTarget<Tape>(OPERATION_INFO_PARAMS);
+		if (pointer.size() <= target)
+			pointer.resize(target + 1); // Pad with 0s until the new index is reached.
+
+		typename Tape::value_type value = evaluateForm<FORM, Tape>(OPERATION_INFO_PARAMS);
+		checkDivisor<OPERATOR>(value, operation);
+		typename Tape::value_type &cell = pointer[target];
+		cell = applyOperator<OPERATOR>(cell, value);
+	}
+	++state.pc;
+}
+
+/// The ways in which a VALUE_OPERATION on 8-bit cells multiplies, divides or takes the remainder by a constant (see reduceOperation()).
+enum Reduction : uint8_t {
+	REDUCTION_SHIFT_LEFT,   // (*[2^shift])
+	REDUCTION_SHIFT_RIGHT,  // (/[2^shift])
+	REDUCTION_MASK,         // (%[multiplier+1]), a power of two
+	REDUCTION_RECIPROCAL,   // (/[N]), as (cell * multiplier) >> shift
+	REDUCTION_REMAINDER     // (%[N]), as cell - (cell / N) * N, with the quotient of REDUCTION_RECIPROCAL
+};
+
+/**
+ * Executes a VALUE_OPERATION on 8-bit cells whose operand is a constant, with shifts, masks and multiplications instead of
+ * multiplying or dividing by the constant.
+ *
+ * @tparam REDUCTION How the constant is applied.
+ * @tparam TARGET The form of the target.
+ * @tparam Tape The type of the data pointer.
+ */
+template<Reduction REDUCTION, TargetForm TARGET, typename Tape>
+static void EXECUTE_REDUCED_OPERATION(OPERATION_INFO) {
+	Tape &pointer = tapeOf<Tape>(state);
+	typename Tape::value_type *cell;
+
+	if constexpr (TARGET == TARGET_CURRENT)
+		cell = &cellAt(pointer, state.index, operation.error_position);
+	else {
+		uint32_t target = TARGET == TARGET_CONSTANT ? operation.target_value : evaluateTarget<Tape>(OPERATION_INFO_PARAMS);
+		if (pointer.size() <= target)
+			pointer.resize(target + 1);
+		cell = &pointer[target];
+	}
+
+	uint32_t value = *cell;
+	if constexpr (REDUCTION == REDUCTION_SHIFT_LEFT)
+		value <<= operation.shift;
+	else if constexpr (REDUCTION == REDUCTION_SHIFT_RIGHT)
+		value >>= operation.shift;
+	else if constexpr (REDUCTION == REDUCTION_MASK)
+		value &= operation.multiplier;
+	else if constexpr (REDUCTION == REDUCTION_RECIPROCAL)
+		value = (value * operation.multiplier) >> operation.shift;
+	else value -= ((value * operation.multiplier) >> operation.shift) * (uint8_t) operation.value;
+
+	*cell = (typename Tape::value_type) value;
+	++state.pc;
+}
+
+template<typename Tape>
+static void EXECUTE_VALUE_OPERATION_INVALID(OPERATION_INFO) {
+	if (operation.target_form != TARGET_CURRENT) {
+		Tape &pointer = tapeOf<Tape>(state);
+
+		uint32_t target = evaluateTarget<Tape>(OPERATION_INFO_PARAMS);
+		if (pointer.size() <= target)
+			pointer.resize(target + 1);
+	}
+	throw ExecutionError("Invalid operator", operation.error_position);
+}
+
+template<typename Tape>
+static void EXECUTE_INDEX_INCREMENT(OPERATION_INFO) {
+	Tape &pointer = tapeOf<Tape>(state);
+
+	++state.index;
+	if (state.index > pointer.size() - 1)
+		pointer.push_back(0);
+	++state.pc;
+}
+
+static void EXECUTE_INDEX_DECREMENT(OPERATION_INFO) {
+	--state.index;
+	++state.pc;
+}
+
+template<typename Tape>
+static void EXECUTE_UNCERTAINTY_START(OPERATION_INFO) {
+	uint32_t stop = CONDITION_COMPLETE;
+
+	if (evaluateCondition<Tape>(state, operation.argument, stop)) {
+		++state.uncertainty_count;
+		state.pc = stop == CONDITION_COMPLETE ? state.pc + 1 : state.program->conditions[stop].short_target;
+	}
+	else state.pc = stop == CONDITION_COMPLETE ? operation.target : state.program->conditions[stop].short_skip; // Skip uncertainty.
+}
+
+static void EXECUTE_UNCERTAINTY_ENTER(OPERATION_INFO) {
+	++state.uncertainty_count;
+	state.pc = operation.target;
+}
+
+static void EXECUTE_UNCERTAINTY_END(OPERATION_INFO) {
+	if (state.uncertainty_count == 0)
+		throw ExecutionError("Unexpected uncertainty end", operation.error_position);
+
+	--state.uncertainty_count;
+	++state.pc;
+}
+
+template<typename Tape>
+static void EXECUTE_LOOP_START(OPERATION_INFO) {
+	state.loop_stack.push_back(state.pc);
+	uint32_t stop = CONDITION_COMPLETE;
+
+	if (evaluateCondition<Tape>(state, operation.argument, stop))
+		state.pc = stop == CONDITION_COMPLETE ? state.pc + 1 : state.program->conditions[stop].short_target;
+	else { // Skip loop.
+		state.loop_stack.pop_back();
+		state.pc = stop == CONDITION_COMPLETE ? operation.target : state.program->conditions[stop].short_skip;
+	}
+}
+
+/**
+ * Applies an operator to a range of cells of the dense data pointer.
+ *
+ * @tparam OPERATOR The operator.
+ * @param pointer The data pointer.
+ * @param start The first index of the range.
+ * @param count The amount of cells.
+ * @param operand The operand.
+ */
+template<char OPERATOR, typename Cell>
+static void applyCells(DenseTape<Cell> &pointer, size_t start, size_t count, Cell operand) {
+	applyRange<OPERATOR, Cell>(pointer.data() + start, count, operand);
+}
+
+/// Applies an operator to a range of cells of the paged data pointer, one page at a time.
+template<char OPERATOR, typename Cell>
+static void applyCells(PagedTape<Cell> &pointer, size_t start, size_t count, Cell operand) {
+	while (count != 0) {
+		size_t chunk = std::min<size_t>(count, PAGE_SIZE - (start & (PAGE_SIZE - 1)));
+
+		applyRange<OPERATOR, Cell>(&pointer[start], chunk, operand);
+		start += chunk;
+		count -= chunk;
+	}
+}
+
+/**
+ * Executes a loop which applies an operator to a range of cells (see Program::isRangeMap()) at once.
+ * The amount of iterations is computed from the index, with the same wraparound as [i].
+ * The loop is executed one iteration at a time instead if it would raise an error, never end,
+ * or read a cell that it also writes.
+ *
+ * @tparam OPERATOR The operator. INCREMENT is executed as OPERATOR_ADD, and DECREMENT as OPERATOR_SUBTRACT.
+ * @tparam Tape The type of the data pointer.
+ */
+template<char OPERATOR, typename Tape>
+static void EXECUTE_RANGE_MAP(OPERATION_INFO) {
+	typedef typename Tape::value_type Cell;
+
+	Tape &pointer = tapeOf<Tape>(state);
+	const Condition &condition = state.program->conditions[operation.argument];
+	const Operation &body = state.program->operations[state.pc + 1];
+
+	Cell index = (Cell) state.index;
+	Cell limit = (Cell) widen<Tape>(state.program->operands[condition.right].number);
+	uint64_t count;
+
+	switch (condition.relation) {
+		case RELATION_LESS_THAN:
+			count = index < limit ? (uint64_t) (Cell) (limit - index) : 0;
+			break;
+		case RELATION_LESS_THAN_OR_EQUAL:
+			count = index <= limit && limit != (Cell) ~(Cell) 0 ? (uint64_t) (Cell) (limit - index) + 1 : 0;
+			break;
+		default:
+			count = (Cell) (limit - index);
+			break;
+	}
+
+	// 64-bit counts may wrap the end around, so they are checked before it.
+	uint64_t end = (uint64_t) state.index + count;
+	if (count == 0 || count >= UINT32_MAX || state.index >= pointer.size() || end >= UINT32_MAX) {
+		EXECUTE_LOOP_START<Tape>(OPERATION_INFO_PARAMS);
+		return;
+	}
+
+	Cell operand = 1;
+	if (body.code == OPCODE_VALUE_OPERATION) {
+		if (body.operand_form == FORM_CONSTANT)
+			operand = (Cell) widen<Tape>(body.value);
+		else if (body.value < pointer.size() && (body.value < state.index || body.value >= end))
+			operand = pointer[body.value];
+		else {
+			EXECUTE_LOOP_START<Tape>(OPERATION_INFO_PARAMS);
+			return;
+		}
+	}
+
+	if (pointer.size() <= end)
+		pointer.resize(end + 1); // The cells added by INDEX_INCREMENT.
+
+	applyCells<OPERATOR, Cell>(pointer, state.index, count, operand);
+	state.index = (uint32_t) end;
+	state.pc = operation.target;
+}
+
+template<typename Tape>
+static void EXECUTE_LOOP_END(OPERATION_INFO) {
+	if (suspend_requested)
+		throw ExecutionSuspended();
+
+	if (state.loop_stack.empty())
+		throw ExecutionError("Unexpected loop end", operation.error_position);
+
+	uint32_t start = state.loop_stack.back();
+	uint32_t stop = CONDITION_COMPLETE;
+
+	if (evaluateCondition<Tape>(state, state.program->operations[start].argument, stop))
+		state.pc = stop == CONDITION_COMPLETE ? start + 1 : state.program->conditions[stop].short_target;
+	else { // End loop.
+		state.loop_stack.pop_back();
+		++state.pc;
+	}
+}
+
+/// A LOOP_END of the baseline tier of a TieredProgram, which counts the repetitions of its loop.
+template<typename Tape>
+static void EXECUTE_BASELINE_LOOP_END(OPERATION_INFO) {
+	uint32_t pc = state.pc;
+	size_t depth = state.loop_stack.size();
+
+	EXECUTE_LOOP_END<Tape>(OPERATION_INFO_PARAMS);
+
+	// The loop is repeated, so the next iteration can start in the optimized tier.
+	if (state.loop_stack.size() == depth && ++state.tiers->repetitions[pc] >= state.tiers->threshold) {
+		state.tiers->hot_position = operation.position;
+		throw LoopBecameHot();
+	}
+}
+
+/**
+ * Checks whether the body of a counted loop may write its counter at the index, in one of its first iterations.
+ *
+ * @param loop The counted loop.
+ * @param index The index at the start of the first iteration.
+ * @param iterations The amount of iterations.
+ *
+ * @return True, if the counter may be written. False otherwise.
+ */
+static bool writesCounter(const CountedLoop &loop, uint32_t index, uint64_t iterations) {
+	for (int64_t offset : loop.offsets) {
+		int64_t distance = (int64_t) loop.counter - ((int64_t) index + offset);
+
+		if (loop.step == 0 ? distance == 0 : distance % loop.step == 0 && distance / loop.step >= 0 && (uint64_t) (distance / loop.step) < iterations)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Executes every iteration of a counted loop whose body only applies constants to constant cells, at once.
+ *
+ * @param pointer The data pointer.
+ * @param loop The counted loop.
+ * @param count The amount of iterations.
+ */
+template<typename Tape>
+static void executeClosedForm(Tape &pointer, const CountedLoop &loop, typename Tape::value_type count) {
+	typedef typename Tape::value_type Cell;
+
+	for (const CellUpdate &update : loop.updates) {
+		if (pointer.size() <= update.cell)
+			pointer.resize(update.cell + 1); // Like the first iteration does.
+
+		Cell &cell = pointer[update.cell];
+		Cell operand = (Cell) update.operand;
+
+		// Multiplied like the operator, so that cells narrower than unsigned don't overflow as int.
+		if (update.modifier == OPERATOR_ADD)
+			cell = applyOperator<OPERATOR_ADD>(cell, applyOperator<OPERATOR_MULTIPLY>(operand, count));
+		else if (update.modifier == OPERATOR_SUBTRACT)
+			cell = applyOperator<OPERATOR_SUBTRACT>(cell, applyOperator<OPERATOR_MULTIPLY>(operand, count));
+		else cell = operand;
+	}
+
+	pointer[loop.counter] = 0;
+}
+
+template<typename Tape>
+static void EXECUTE_COUNTED_LOOP_START(OPERATION_INFO) {
+	typedef typename Tape::value_type Cell;
+
+	const Operation &original = state.program->operations[operation.target];
+	uint32_t stop = CONDITION_COMPLETE;
+
+	// The expression has no AND, so it either enters or skips the loop.
+	if (!evaluateCondition<Tape>(state, operation.argument, stop)) {
+		state.pc = original.target;
+		return;
+	}
+
+	Tape &pointer = tapeOf<Tape>(state);
+	const CountedLoop &loop = state.program->counted_loops[operation.value];
+	Cell count = readCell(pointer, loop.counter, operation.error_position);
+
+	if (!loop.updates.empty()) {
+		executeClosedForm<Tape>(pointer, loop, count);
+		state.pc = original.target;
+		return;
+	}
+
+	// The original loop evaluates the expression again, which has no effect.
+	if (count < loop.unroll || writesCounter(loop, state.index, count)) {
+		state.pc = operation.target;
+		return;
+	}
+
+	state.loop_stack.push_back(state.pc);
+	state.loop_count = count / loop.unroll;
+	++state.pc;
+}
+
+/// Repeats the copies of the body of a counted loop, without evaluating the expression. The original loop executes the rest.
+static void EXECUTE_COUNTED_LOOP_END(OPERATION_INFO) {
+	// Execution is only suspended in programs which are not optimized, which have no counted loops.
+	if (--state.loop_count != 0) {
+		state.pc = operation.target;
+		return;
+	}
+
+	state.loop_stack.pop_back();
+	++state.pc;
+}
+
+template<typename Tape>
+static void EXECUTE_OUTPUT_WRITE(OPERATION_INFO) {
+	std::ostream &output = state.file_output != nullptr ? *state.file_output : *state.output;
+	const std::string &formats = state.program->texts[operation.argument];
+	const Tape &pointer = tapeOf<Tape>(state);
+
+	if (formats.empty())
+		output << (char) readCell(pointer, state.index, operation.error_position);
+
+	for (uint32_t i = 0; i < formats.size(); ++i) {
+		uint32_t position = operation.error_position + i + 1;
+
+		if (formats[i] == 'n')
+			output << (Value<Tape>) readCell(pointer, state.index, position);
+		else if (formats[i] == 'c')
+			output << (char) readCell(pointer, state.index, position);
+		else if (formats[i] == '_')
+			output << ' ';
+		else output << '\n';
+	}
+
+	++state.pc;
+}
+
+/// Writes the text of OUTPUT_WRITE operations whose output is known.
+static void EXECUTE_OUTPUT_TEXT(OPERATION_INFO) {
+	const std::string &text = state.program->texts[operation.argument];
+	(state.file_output != nullptr ? *state.file_output : *state.output).write(text.data(), (std::streamsize) text.size());
+	++state.pc;
+}
+
+/**
+ * Reads a number and applies it to the value at the current index.
+ *
+ * @tparam OPERATOR The operator which applies the number.
+ * @tparam Tape The type of the data pointer.
+ */
+template<char OPERATOR, typename Tape>
+static void EXECUTE_INPUT(OPERATION_INFO) {
+	if (state.suspend_before_input)
+		throw ExecutionSuspended();
+
+	// 8-bit cells read a 16-bit number, like the reference interpreter.
+	typename std::conditional<sizeof(typename Tape::value_type) == 1, uint16_t, typename Tape::value_type>::type num = 0;
+	if (state.trace != nullptr && state.trace->isReplaying())
+		num = (decltype(num)) state.trace->replayInput(state, operation.error_position);
+	else {
+		(state.file_input != nullptr ? *state.file_input : *state.input) >> num;
+		if (state.trace != nullptr)
+			state.trace->recordInput(state, num);
+	}
+
+	typename Tape::value_type &cell = cellAt(tapeOf<Tape>(state), state.index, operation.error_position);
+	cell = applyOperator<OPERATOR>(cell, (typename Tape::value_type) num);
+	++state.pc;
+}
+
+/// The most cells which a bulk read adds at once, before the input has shown that it has as many bytes.
+#define BULK_READ_CHUNK (1u << 16)
+/// The size of the buffer through which cells wider than 8 bits are read and written as bytes.
+#define BULK_BUFFER_SIZE 4096
+
+/**
+ * Gets consecutive cells, which are stored contiguously in memory.
+ *
+ * @param pointer The data pointer.
+ * @param index The first index, which is valid.
+ * @param count The amount of cells, which is reduced to the amount stored contiguously.
+ *
+ * @return The cells.
+ */
+template<typename Cell>
+static inline Cell *cellRun(DenseTape<Cell> &pointer, size_t index, size_t &count) {
+	return pointer.data() + index;
+}
+
+template<typename Cell>
+static inline const Cell *cellRun(const DenseTape<Cell> &pointer, size_t index, size_t &count) {
+	return pointer.data() + index;
+}
+
+/// Gets the cells of the paged data pointer up to the end of the page, which is allocated.
+template<typename Cell>
+static inline Cell *cellRun(PagedTape<Cell> &pointer, size_t index, size_t &count) {
+	count = std::min<size_t>(count, PAGE_SIZE - (index & (PAGE_SIZE - 1)));
+	return &pointer[index];
+}
+
+template<typename Cell>
+static inline const Cell *cellRun(const PagedTape<Cell> &pointer, size_t index, size_t &count) {
+	count = std::min<size_t>(count, PAGE_SIZE - (index & (PAGE_SIZE - 1)));
+	return pointer.run(index);
+}
+
+/**
+ * Reads raw bytes into consecutive cells, one byte per cell. 8-bit cells are read in place, with one read per run of cells.
+ * The data pointer is left with at least as many cells as were requested; the caller removes the ones which weren't read.
+ *
+ * @param pointer The data pointer.
+ * @param index The first index.
+ * @param count The amount of bytes requested.
+ * @param input The input.
+ *
+ * @return The amount of bytes read, which is less than requested only if the input ended.
+ */
+template<typename Tape>
+static size_t readCells(Tape &pointer, size_t index, size_t count, std::istream &input) {
+	typedef typename Tape::value_type Cell;
+	size_t read = 0;
+
+	while (read < count) {
+		// Large counts add cells as they are read, instead of all at once.
+		size_t end = read + std::min<size_t>(count - read, std::max<size_t>(read, BULK_READ_CHUNK));
+		if (pointer.size() < index + end)
+			pointer.resize(index + end);
+
+		while (read < end) {
+			size_t run = end - read;
+			Cell *cells = cellRun(pointer, index + read, run);
+			size_t received;
+
+			if constexpr (sizeof(Cell) == 1) {
+				input.read((char*) cells, (std::streamsize) run);
+				received = (size_t) input.gcount();
+			}
+			else {
+				char bytes[BULK_BUFFER_SIZE];
+				run = std::min<size_t>(run, sizeof(bytes));
+				input.read(bytes, (std::streamsize) run);
+				received = (size_t) input.gcount();
+
+				for (size_t i = 0; i < received; ++i)
+					cells[i] = (uint8_t) bytes[i];
+			}
+
+			read += received;
+			if (received < run)
+				return read;
+		}
+	}
+	return read;
+}
+
+/**
+ * Stores raw bytes in consecutive cells, one byte per cell, adding the cells which are missing.
+ *
+ * @param pointer The data pointer.
+ * @param index The first index.
+ * @param bytes The bytes.
+ * @param size The amount of bytes.
+ */
+template<typename Tape>
+static void storeCells(Tape &pointer, size_t index, const uint8_t *bytes, size_t size) {
+	if (pointer.size() < index + size)
+		pointer.resize(index + size);
+	for (size_t i = 0; i < size; ++i)
+		pointer[index + i] = bytes[i];
+}
+
+/**
+ * Reads up to a number of raw bytes into the cells from the current index, and stores the amount read in the target cell.
+ * The data pointer keeps only the cells which were read, and is padded up to the target.
+ *
+ * @tparam Tape The type of the data pointer.
+ */
+template<typename Tape>
+static void EXECUTE_BULK_READ(OPERATION_INFO) {
+	if (state.suspend_before_input)
+		throw ExecutionSuspended();
+
+	Tape &pointer = tapeOf<Tape>(state);
+	uint64_t count = evaluateOperand<Tape>(state, operation.argument);
+	uint32_t target = evaluateTarget<Tape>(OPERATION_INFO_PARAMS);
+	size_t read = 0;
+
+	if (count != 0) {
+		if (state.index >= pointer.size())
+			rangeError(pointer, state.index, operation.error_position);
+		if (count > UINT32_MAX - state.index)
+			rangeError(pointer, UINT32_MAX, operation.error_position);
+
+		std::istream &input = state.file_input != nullptr ? *state.file_input : *state.input;
+		size_t size = pointer.size();
+
+		if (state.trace != nullptr && state.trace->isReplaying()) {
+			const uint8_t *bytes;
+			read = state.trace->replayBlock(state, operation.error_position, bytes);
+			if (read > count)
+				throw ExecutionError("Invalid trace", operation.error_position);
+			storeCells(pointer, state.index, bytes, read);
+		}
+		else if (state.trace != nullptr) { // The checkpoint is hashed before the bytes are stored.
+			DenseTape<uint8_t> bytes;
+			read = readCells(bytes, 0, (size_t) count, input);
+			state.trace->recordBlock(state, bytes.data(), read);
+			storeCells(pointer, state.index, bytes.data(), read);
+		}
+		else {
+			read = readCells(pointer, state.index, (size_t) count, input);
+			pointer.resize(std::max<size_t>(size, state.index + read));
+		}
+	}
+
+	if (pointer.size() <= target)
+		pointer.resize(target + 1); // Pad with 0s until the new index is reached.
+	pointer[target] = (typename Tape::value_type) read;
+	++state.pc;
+}
+
+/**
+ * Writes the cells in a range to the output, as raw bytes. 8-bit cells are written in place, with one write per run of cells.
+ *
+ * @tparam Tape The type of the data pointer.
+ */
+template<typename Tape>
+static void EXECUTE_BULK_WRITE(OPERATION_INFO) {
+	typedef typename Tape::value_type Cell;
+
+	const Tape &pointer = tapeOf<Tape>(state);
+	uint64_t first = evaluateOperand<Tape>(state, operation.argument);
+	uint64_t last = evaluateOperand<Tape>(state, operation.target);
+
+	if (last <= first) {
+		++state.pc;
+		return;
+	}
+	if (last > pointer.size())
+		rangeError(pointer, last - 1, operation.error_position);
+
+	std::ostream &output = state.file_output != nullptr ? *state.file_output : *state.output;
+	for (size_t index = (size_t) first; index < last;) {
+		size_t run = (size_t) last - index;
+		const Cell *cells = cellRun(pointer, index, run);
+
+		if constexpr (sizeof(Cell) == 1)
+			output.write((const char*) cells, (std::streamsize) run);
+		else {
+			char bytes[BULK_BUFFER_SIZE];
+			run = std::min<size_t>(run, sizeof(bytes));
+
+			for (size_t i = 0; i < run; ++i)
+				bytes[i] = (char) cells[i];
+			output.write(bytes, (std::streamsize) run);
+		}
+		index += run;
+	}
+	++state.pc;
+}
+
+/**
+ * Raises a range error if a range of cells doesn't exist, like pointer.at() does for its last cell.
+ *
+ * @param pointer The data pointer.
+ * @param start The first index of the range.
+ * @param count The amount of cells, which isn't 0.
+ * @param position The position where the error is raised.
+ */
+template<typename Tape>
+static inline void checkRange(const Tape &pointer, uint64_t start, uint64_t count, uint32_t position) {
+	if (start >= pointer.size() || count > pointer.size() - start)
+		rangeError(pointer, start + count - 1, position);
+}
+
+/**
+ * Adds the cells which are missing from a range, which is written. Ranges past the highest index are raised as range errors.
+ *
+ * @param pointer The data pointer.
+ * @param start The first index of the range.
+ * @param count The amount of cells, which isn't 0.
+ * @param position The position where the error is raised.
+ */
+template<typename Tape>
+static inline void growRange(Tape &pointer, uint64_t start, uint64_t count, uint32_t position) {
+	if (start >= UINT32_MAX || count > UINT32_MAX - start)
+		rangeError(pointer, UINT32_MAX, position);
+	if (pointer.size() < start + count)
+		pointer.resize(start + count); // Pad with 0s until the end of the range is reached.
+}
+
+/// Fills a range of cells, one run at a time. std::fill_n() is a memset() for 8-bit cells.
+template<typename Tape>
+static void fillCells(Tape &pointer, size_t start, size_t count, typename Tape::value_type value) {
+	while (count != 0) {
+		size_t run = count;
+		typename Tape::value_type *cells = cellRun(pointer, start, run);
+
+		std::fill_n(cells, run, value);
+		start += run;
+		count -= run;
+	}
+}
+
+/// Copies a range of cells, which may overlap the destination.
+template<typename Cell>
+static void moveCells(DenseTape<Cell> &pointer, size_t destination, size_t source, size_t count) {
+	memmove(pointer.data() + destination, pointer.data() + source, count * sizeof(Cell));
+}
+
+/// Copies a range of cells of the paged data pointer, one chunk within a source and a destination page at a time.
+template<typename Cell>
+static void moveCells(PagedTape<Cell> &pointer, size_t destination, size_t source, size_t count) {
+	const PagedTape<Cell> &cells = pointer;
+	bool forwards = destination < source; // The cells which overlap are copied before they are overwritten.
+
+	while (count != 0) {
+		size_t chunk;
+		if (forwards)
+			chunk = std::min<size_t>({count, PAGE_SIZE - (source & (PAGE_SIZE - 1)), PAGE_SIZE - (destination & (PAGE_SIZE - 1))});
+		else chunk = std::min<size_t>({count, ((source + count - 1) & (PAGE_SIZE - 1)) + 1, ((destination + count - 1) & (PAGE_SIZE - 1)) + 1});
+
+		size_t offset = forwards ? 0 : count - chunk;
+		Cell *to = &pointer[destination + offset]; // Allocated first, in case the source is on the same page.
+		memmove(to, cells.run(source + offset), chunk * sizeof(Cell));
+
+		if (forwards) {
+			destination += chunk;
+			source += chunk;
+		}
+		count -= chunk;
+	}
+}
+
+/**
+ * Compares two ranges of cells, one run at a time.
+ *
+ * @return 0, if the ranges are equal. 1, if the first range is lower. 2, if the first range is greater.
+ */
+template<typename Tape>
+static int compareCells(const Tape &pointer, size_t first, size_t second, size_t count) {
+	typedef typename Tape::value_type Cell;
+
+	while (count != 0) {
+		size_t run = count, other = count;
+		const Cell *left = cellRun(pointer, first, run);
+		const Cell *right = cellRun(pointer, second, other);
+		run = std::min(run, other);
+
+		if constexpr (sizeof(Cell) == 1) {
+			int result = memcmp(left, right, run);
+			if (result != 0)
+				return result < 0 ? 1 : 2;
+		}
+		else {
+			auto difference = std::mismatch(left, left + run, right);
+			if (difference.first != left + run)
+				return *difference.first < *difference.second ? 1 : 2;
+		}
+
+		first += run;
+		second += run;
+		count -= run;
+	}
+	return 0;
+}
+
+/**
+ * Sets the cells of a range to a value, padding the data pointer up to the end of the range.
+ *
+ * @tparam Tape The type of the data pointer.
+ */
+template<typename Tape>
+static void EXECUTE_MEMORY_FILL(OPERATION_INFO) {
+	Tape &pointer = tapeOf<Tape>(state);
+	uint64_t start = evaluateOperand<Tape>(state, operation.argument);
+	uint64_t count = evaluateOperand<Tape>(state, operation.target);
+	typename Tape::value_type value = evaluateOperand<Tape>(state, operation.value);
+
+	if (count != 0) {
+		growRange(pointer, start, count, operation.error_position);
+		fillCells(pointer, (size_t) start, (size_t) count, value);
+	}
+	++state.pc;
+}
+
+/**
+ * Copies a range of cells, which must exist, to a destination, padding the data pointer up to the end of the destination.
+ *
+ * @tparam Tape The type of the data pointer.
+ */
+template<typename Tape>
+static void EXECUTE_MEMORY_MOVE(OPERATION_INFO) {
+	Tape &pointer = tapeOf<Tape>(state);
+	uint64_t destination = evaluateOperand<Tape>(state, operation.argument);
+	uint64_t source = evaluateOperand<Tape>(state, operation.target);
+	uint64_t count = evaluateOperand<Tape>(state, operation.value);
+
+	if (count != 0) {
+		checkRange(pointer, source, count, operation.error_position);
+		growRange(pointer, destination, count, operation.error_position);
+		if (destination != source)
+			moveCells(pointer, (size_t) destination, (size_t) source, (size_t) count);
+	}
+	++state.pc;
+}
+
+/**
+ * Compares two ranges of cells, which must exist, and stores the result in the target cell (see compareCells()).
+ *
+ * @tparam Tape The type of the data pointer.
+ */
+template<typename Tape>
+static void EXECUTE_MEMORY_COMPARE(OPERATION_INFO) {
+	Tape &pointer = tapeOf<Tape>(state);
+	uint64_t first = evaluateOperand<Tape>(state, operation.argument);
+	uint64_t second = evaluateOperand<Tape>(state, operation.target);
+	uint64_t count = evaluateOperand<Tape>(state, operation.value);
+	uint64_t target = evaluateOperand<Tape>(state, operation.target_value);
+	int result = 0;
+
+	if (count != 0) {
+		checkRange(pointer, first, count, operation.error_position);
+		checkRange(pointer, second, count, operation.error_position);
+		result = compareCells(pointer, (size_t) first, (size_t) second, (size_t) count);
+	}
+
+	if (target >= UINT32_MAX)
+		rangeError(pointer, target, state.program->operands[operation.target_value].position);
+	if (pointer.size() <= target)
+		pointer.resize(target + 1); // Pad with 0s until the new index is reached.
+	pointer[target] = (typename Tape::value_type) result;
+	++state.pc;
+}
+
+static void EXECUTE_FILE_OPEN(OPERATION_INFO) {
+	const std::string &filename = state.program->texts[operation.argument];
+	bool replaying = state.trace != nullptr && state.trace->isReplaying(); // Replays don't touch the files.
+	std::string path = state.directory.empty() || filename.empty() || filename[0] == '/' ? filename : state.directory + '/' + filename;
+
+	if (operation.modifier == 'v') {
+		if (state.file_input != nullptr) {
+			state.file_input -> close();
+			delete state.file_input;
+		}
+		state.file_input = replaying ? new std::ifstream() : new std::ifstream(path);
+		state.file_input_name = filename;
+	}
+	else {
+		if (state.file_output != nullptr) {
+			state.file_output -> close();
+			delete state.file_output;
+		}
+		state.file_output = replaying ? new std::ofstream() : new std::ofstream(path);
+		state.file_output_name = filename;
+	}
+	++state.pc;
+}
+
+static void EXECUTE_FILE_CLOSE(OPERATION_INFO) {
+	if (operation.modifier == 'v') {
+		if (state.file_input == nullptr)
+			throw ExecutionError("No file opened with read mode", operation.error_position);
+
+		state.file_input -> close();
+		delete state.file_input;
+		state.file_input = nullptr;
+	}
+	else {
+		if (state.file_output == nullptr)
+			throw ExecutionError("No file opened with write mode", operation.error_position);
+
+		state.file_output -> close();
+		delete state.file_output;
+		state.file_output = nullptr;
+	}
+	++state.pc;
+}
+
+template<char OPERATOR, TargetForm TARGET, typename Tape>
+static OperationBody selectValueOperation(OperandForm form) {
+	switch (form) {
+		case FORM_CONSTANT: return EXECUTE_VALUE_OPERATION<OPERATOR, TARGET, FORM_CONSTANT, Tape>;
+		case FORM_INDEX: return EXECUTE_VALUE_OPERATION<OPERATOR, TARGET, FORM_INDEX, Tape>;
+		case FORM_CELL: return EXECUTE_VALUE_OPERATION<OPERATOR, TARGET, FORM_CELL, Tape>;
+		case FORM_RELATIVE_CELL: return EXECUTE_VALUE_OPERATION<OPERATOR, TARGET, FORM_RELATIVE_CELL, Tape>;
+		default: return EXECUTE_VALUE_OPERATION<OPERATOR, TARGET, FORM_EXPRESSION, Tape>;
+	}
+}
+
+template<char OPERATOR, typename Tape>
+static OperationBody selectValueOperation(TargetForm target, OperandForm form) {
+	switch (target) {
+		case TARGET_CURRENT: return selectValueOperation<OPERATOR, TARGET_CURRENT, Tape>(form);
+		case TARGET_CONSTANT: return selectValueOperation<OPERATOR, TARGET_CONSTANT, Tape>(form);
+		default: return selectValueOperation<OPERATOR, TARGET_EXPRESSION, Tape>(form);
+	}
+}
+
+template<typename Tape>
+static OperationBody selectValueOperation(char op, TargetForm target, OperandForm form) {
+	switch (op) {
+		case OPERATOR_SET: return selectValueOperation<OPERATOR_SET, Tape>(target, form);
+		case OPERATOR_ADD: return selectValueOperation<OPERATOR_ADD, Tape>(target, form);
+		case OPERATOR_SUBTRACT: return selectValueOperation<OPERATOR_SUBTRACT, Tape>(target, form);
+		case OPERATOR_MULTIPLY: return selectValueOperation<OPERATOR_MULTIPLY, Tape>(target, form);
+		case OPERATOR_DIVIDE: return selectValueOperation<OPERATOR_DIVIDE, Tape>(target, form);
+		case OPERATOR_MODULO: return selectValueOperation<OPERATOR_MODULO, Tape>(target, form);
+		case OPERATOR_XOR: return selectValueOperation<OPERATOR_XOR, Tape>(target, form);
+		case OPERATOR_AND: return selectValueOperation<OPERATOR_AND, Tape>(target, form);
+		case OPERATOR_OR: return selectValueOperation<OPERATOR_OR, Tape>(target, form);
+		default: return EXECUTE_VALUE_OPERATION_INVALID<Tape>;
+	}
+}
+
+/**
+ * Selects the body of a LOOP_START, which is specialized if the loop is a range map.
+ *
+ * @param program The program.
+ * @param loop The index of the operation.
+ *
+ * @return The body of the operation.
+ */
+template<typename Tape>
+static OperationBody selectLoopStart(const Program &program, uint32_t loop) {
+	if (!program.isRangeMap(loop))
+		return EXECUTE_LOOP_START<Tape>;
+
+	const Operation &body = program.operations[loop + 1];
+	if (body.code == OPCODE_VALUE_INCREMENT)
+		return EXECUTE_RANGE_MAP<OPERATOR_ADD, Tape>;
+	if (body.code == OPCODE_VALUE_DECREMENT)
+		return EXECUTE_RANGE_MAP<OPERATOR_SUBTRACT, Tape>;
+
+	switch (body.modifier) {
+		case OPERATOR_SET: return EXECUTE_RANGE_MAP<OPERATOR_SET, Tape>;
+		case OPERATOR_ADD: return EXECUTE_RANGE_MAP<OPERATOR_ADD, Tape>;
+		case OPERATOR_SUBTRACT: return EXECUTE_RANGE_MAP<OPERATOR_SUBTRACT, Tape>;
+		case OPERATOR_MULTIPLY: return EXECUTE_RANGE_MAP<OPERATOR_MULTIPLY, Tape>;
+		case OPERATOR_XOR: return EXECUTE_RANGE_MAP<OPERATOR_XOR, Tape>;
+		case OPERATOR_AND: return EXECUTE_RANGE_MAP<OPERATOR_AND, Tape>;
+		default: return EXECUTE_RANGE_MAP<OPERATOR_OR, Tape>;
+	}
+}
+
+template<Reduction REDUCTION, typename Tape>
+static OperationBody selectReducedOperation(TargetForm target) {
+	switch (target) {
+		case TARGET_CURRENT: return EXECUTE_REDUCED_OPERATION<REDUCTION, TARGET_CURRENT, Tape>;
+		case TARGET_CONSTANT: return EXECUTE_REDUCED_OPERATION<REDUCTION, TARGET_CONSTANT, Tape>;
+		default: return EXECUTE_REDUCED_OPERATION<REDUCTION, TARGET_EXPRESSION, Tape>;
+	}
+}
+
+/**
+ * Replaces the body of a VALUE_OPERATION on 8-bit cells which multiplies, divides or takes the remainder by a constant.
+ * Powers of two become shifts and masks. Other divisors N become a multiplication by the reciprocal ceil(2^(8+l) / N),
+ * where 2^l is the lowest power of two above N, which is exact for every 8-bit value. Divisions by 0 keep their error.
+ *
+ * @tparam Tape The type of the data pointer.
+ * @param operation The operation, whose operand is a constant.
+ */
+template<typename Tape>
+static void reduceOperation(Operation &operation) {
+	uint32_t constant = (uint8_t) widen<Tape>(operation.value);
+	uint8_t bits = 0;
+	while ((1u << bits) < constant)
+		++bits;
+	bool power = constant == 1u << bits;
+
+	if (constant == 0 || (operation.modifier == OPERATOR_MULTIPLY && !power))
+		return; // A single multiplication already.
+
+	operation.shift = bits;
+	switch (operation.modifier) {
+		case OPERATOR_MULTIPLY:
+			operation.body = selectReducedOperation<REDUCTION_SHIFT_LEFT, Tape>(operation.target_form);
+			break;
+		case OPERATOR_DIVIDE:
+			if (power) {
+				operation.body = selectReducedOperation<REDUCTION_SHIFT_RIGHT, Tape>(operation.target_form);
+				break;
+			}
+			operation.multiplier = (uint16_t) (((1u << (8 + bits)) + constant - 1) / constant);
+			operation.shift = 8 + bits;
+			operation.body = selectReducedOperation<REDUCTION_RECIPROCAL, Tape>(operation.target_form);
+			break;
+		case OPERATOR_MODULO:
+			if (power) {
+				operation.multiplier = (uint16_t) (constant - 1);
+				operation.body = selectReducedOperation<REDUCTION_MASK, Tape>(operation.target_form);
+				break;
+			}
+			operation.multiplier = (uint16_t) (((1u << (8 + bits)) + constant - 1) / constant);
+			operation.shift = 8 + bits;
+			operation.body = selectReducedOperation<REDUCTION_REMAINDER, Tape>(operation.target_form);
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * Selects the specialized body of a VALUE_OPERATION.
+ *
+ * @param program The program.
+ * @param operation The operation.
+ */
+template<typename Tape>
+static void bindValueOperation(const Program &program, Operation &operation) {
+	if (!isOperator(operation.modifier)) {
+		operation.body = EXECUTE_VALUE_OPERATION_INVALID<Tape>;
+		return;
+	}
+
+	if (operation.target_form != TARGET_CURRENT) {
+		const Operand &target = program.operands[operation.target];
+
+		typename Tape::value_type index = (typename Tape::value_type) widen<Tape>(target.number);
+
+		// Constant targets past the highest index raise their range error when executed.
+		if (target.type == OPERAND_CONSTANT && index < UINT32_MAX) {
+			operation.target_form = TARGET_CONSTANT;
+			operation.target_value = (uint32_t) index;
+		}
+		else operation.target_form = TARGET_EXPRESSION;
+	}
+
+	operation.operand_form = program.getOperandForm(operation.argument);
+	operation.value = program.operands[operation.argument].number;
+	operation.body = selectValueOperation<Tape>(operation.modifier, operation.target_form, operation.operand_form);
+
+	if constexpr (sizeof(typename Tape::value_type) == 1)
+		if (operation.operand_form == FORM_CONSTANT)
+			reduceOperation<Tape>(operation);
+}
+
+/**
+ * Selects the body of every operation of a program, for a type of data pointer.
+ *
+ * @tparam Tape The type of the data pointer.
+ * @param program The program.
+ * @param baseline Whether the LOOP_ENDs count the repetitions of their loops.
+ */
+template<typename Tape>
+static void bindProgram(Program &program, bool baseline) {
+	for (uint32_t i = 0; i < program.operations.size(); ++i) {
+		Operation &operation = program.operations[i];
+
+		switch (operation.code) {
+			case OPCODE_HALT: operation.body = EXECUTE_HALT; break;
+			case OPCODE_TRAP: operation.body = EXECUTE_TRAP; break;
+			case OPCODE_JUMP: operation.body = EXECUTE_JUMP; break;
+			case OPCODE_VALUE_INCREMENT: operation.body = EXECUTE_VALUE_INCREMENT<Tape>; break;
+			case OPCODE_VALUE_DECREMENT: operation.body = EXECUTE_VALUE_DECREMENT<Tape>; break;
+			case OPCODE_VALUE_OPERATION: bindValueOperation<Tape>(program, operation); break;
+			case OPCODE_INDEX_INCREMENT: operation.body = EXECUTE_INDEX_INCREMENT<Tape>; break;
+			case OPCODE_INDEX_DECREMENT: operation.body = EXECUTE_INDEX_DECREMENT; break;
+			case OPCODE_UNCERTAINTY_START: operation.body = EXECUTE_UNCERTAINTY_START<Tape>; break;
+			case OPCODE_UNCERTAINTY_END: operation.body = EXECUTE_UNCERTAINTY_END; break;
+			case OPCODE_LOOP_START: operation.body = selectLoopStart<Tape>(program, i); break;
+			case OPCODE_LOOP_END: operation.body = baseline ? EXECUTE_BASELINE_LOOP_END<Tape> : EXECUTE_LOOP_END<Tape>; break;
+			case OPCODE_OUTPUT_WRITE: operation.body = EXECUTE_OUTPUT_WRITE<Tape>; break;
+			case OPCODE_INPUT_READ: operation.body = EXECUTE_INPUT<OPERATOR_SET, Tape>; break;
+			case OPCODE_INPUT_ADD: operation.body = EXECUTE_INPUT<OPERATOR_ADD, Tape>; break;
+			case OPCODE_INPUT_XOR: operation.body = EXECUTE_INPUT<OPERATOR_XOR, Tape>; break;
+			case OPCODE_INPUT_AND: operation.body = EXECUTE_INPUT<OPERATOR_AND, Tape>; break;
+			case OPCODE_INPUT_OR: operation.body = EXECUTE_INPUT<OPERATOR_OR, Tape>; break;
+			case OPCODE_FILE_OPEN: operation.body = EXECUTE_FILE_OPEN; break;
+			case OPCODE_FILE_CLOSE: operation.body = EXECUTE_FILE_CLOSE; break;
+			case OPCODE_BULK_READ: operation.body = EXECUTE_BULK_READ<Tape>; break;
+			case OPCODE_BULK_WRITE: operation.body = EXECUTE_BULK_WRITE<Tape>; break;
+			case OPCODE_MEMORY_FILL: operation.body = EXECUTE_MEMORY_FILL<Tape>; break;
+			case OPCODE_MEMORY_MOVE: operation.body = EXECUTE_MEMORY_MOVE<Tape>; break;
+			case OPCODE_MEMORY_COMPARE: operation.body = EXECUTE_MEMORY_COMPARE<Tape>; break;
+			case OPCODE_UNCERTAINTY_ENTER: operation.body = EXECUTE_UNCERTAINTY_ENTER; break;
+			case OPCODE_COUNTED_LOOP_START: operation.body = EXECUTE_COUNTED_LOOP_START<Tape>; break;
+			case OPCODE_COUNTED_LOOP_END: operation.body = EXECUTE_COUNTED_LOOP_END; break;
+			case OPCODE_OUTPUT_TEXT: operation.body = EXECUTE_OUTPUT_TEXT; break;
+		}
+	}
+}
+
+/**
+ * Selects the body of every operation of a program, for a type of cells.
+ *
+ * @tparam Cell The type of the cells.
+ * @param program The program.
+ * @param tape The kind of data pointer.
+ * @param baseline Whether the LOOP_ENDs count the repetitions of their loops.
+ */
+template<typename Cell>
+static void bindProgram(Program &program, TapeKind tape, bool baseline) {
+	if (tape == TAPE_PAGED)
+		bindProgram<PagedTape<Cell>>(program, baseline);
+	else bindProgram<DenseTape<Cell>>(program, baseline);
+}
+
+/**
+ * Creates an execution state with an empty data pointer, for a type of cells.
+ *
+ * @tparam Cell The type of the cells.
+ * @param tape The kind of data pointer.
+ *
+ * @return The execution state.
+ */
+template<typename Cell>
+static std::unique_ptr<ExecutionState> createExecutionState(TapeKind tape) {
+	if (tape == TAPE_PAGED)
+		return std::unique_ptr<ExecutionState>(new TapeState<PagedTape<Cell>>());
+	return std::unique_ptr<ExecutionState>(new TapeState<DenseTape<Cell>>());
+}
+
+void bindProgram(Program &program, TapeKind tape, uint8_t cell_bits, bool baseline) {
+	switch (cell_bits) {
+		case 16: bindProgram<uint16_t>(program, tape, baseline); break;
+		case 32: bindProgram<uint32_t>(program, tape, baseline); break;
+		case 64: bindProgram<uint64_t>(program, tape, baseline); break;
+		default: bindProgram<uint8_t>(program, tape, baseline); break;
+	}
+}
+
+std::unique_ptr<ExecutionState> createExecutionState(TapeKind tape, uint8_t cell_bits) {
+	switch (cell_bits) {
+		case 16: return createExecutionState<uint16_t>(tape);
+		case 32: return createExecutionState<uint32_t>(tape);
+		case 64: return createExecutionState<uint64_t>(tape);
+		default: return createExecutionState<uint8_t>(tape);
+	}
+}
+
+void prepareExecution(ExecutionState &state) {
+	const std::vector<Operation> &operations = state.program->operations;
+
+	// Loops are only nested as deep as the amount of loop starts, unless the script is malformed.
+	size_t loop_starts = std::count_if(operations.begin(), operations.end(), [](const Operation &operation) { return operation.code == OPCODE_LOOP_START; });
+	state.loop_stack.reserve(loop_starts + 1);
+}
+
+/**
+ * Optimizes the program of a TieredProgram, and moves an execution state from the baseline tier to the optimized tier.
+ * The optimizer analyzes every execution from the start of the program, including the one in progress, so everything it
+ * assumed about an operation holds when execution moves to it. Removed operations had no effect, and move to the next
+ * operation that was kept. Open loops started at LOOP_STARTs which were executed, so they were kept.
+ *
+ * @param state The execution state, at the start of an iteration of the hot loop.
+ */
+static void promoteProgram(ExecutionState &state) {
+	CHRONOMETER chronometer = time_now();
+	TieredProgram &tiers = *state.tiers;
+	std::vector<uint32_t> moved;
+
+	optimizeProgram(tiers.optimized, state.getCellBits(), tiers.passes, &moved);
+	bindProgram(tiers.optimized, state.getTapeKind(), state.getCellBits());
+
+	state.pc = moved[std::min<size_t>(state.pc, moved.size() - 1)];
+	for (uint32_t &start : state.loop_stack)
+		start = moved[start];
+	state.program = &tiers.optimized;
+
+	tiers.promoted = true;
+	tiers.promotion_time = get_exec_time_ns(chronometer);
+}
+
+void executeProgram(ExecutionState &state) {
+	for (;;) {
+		const Operation *operations = state.program->operations.data();
+		const uint32_t count = (uint32_t) state.program->operations.size();
+
+		try {
+			while (state.pc < count) {
+				const Operation &operation = operations[state.pc];
+				operation.body(OPERATION_INFO_PARAMS);
+			}
+			return;
+		}
+		catch (LoopBecameHot &) {
+			promoteProgram(state);
+		}
+	}
+}
+
+void executeProgram(ExecutionState &state, VirtualClock &clock) {
+	for (;;) {
+		const Operation *operations = state.program->operations.data();
+		const uint32_t count = (uint32_t) state.program->operations.size();
+
+		clock.prepare(*state.program);
+		try {
+			while (state.pc < count) {
+				const Operation &operation = operations[state.pc];
+
+				clock.startOperation();
+				operation.body(OPERATION_INFO_PARAMS);
+				clock.finishOperation();
+			}
+			return;
+		}
+		catch (LoopBecameHot &) {
+			promoteProgram(state); // The LOOP_END only repeated its loop.
+		}
+	}
+}
@@ -0,0 +1,223 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef X10_ENGINE_H
+#define X10_ENGINE_H
+
+#include "program.h"
+#include "optimizer.h"
+#include "tape.h"
+
+#include <csignal>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+
+/// The default width of the cells, in bits. The compiled engine is also instantiated for 16, 32 and 64-bit cells.
+#define CELL_BITS_DEFAULT 8
+/// The default amount of times a loop of a tiered program is repeated before the program is optimized.
+#define TIER_THRESHOLD 1000
+
+/// The kinds of data pointers.
+enum TapeKind : uint8_t {
+	TAPE_DENSE, // A vector which contains every cell.
+	TAPE_PAGED  // Pages which are allocated when they are first written.
+};
+
+class ExecutionTrace;
+class VirtualClock;
+struct TieredProgram;
+
+/// The state of a program which is being executed. The data pointer is kept by the derived state of each kind of data pointer.
+struct ExecutionState {
+	/// The current index.
+	uint32_t index;
+	/// The default stream from which to receive input.
+	std::istream *input;
+	/// The default stream where to output.
+	std::ostream *output;
+	/// The file from which to receive input, if any.
+	std::ifstream *file_input;
+	/// The file where to output, if any.
+	std::ofstream *file_output;
+	/// The name of the file from which to receive input.
+	std::string file_input_name;
+	/// The name of the file where to output.
+	std::string file_output_name;
+	/// The directory against which relative file names are opened, or empty for the current directory.
+	std::string directory;
+	/// The loop stack, which contains the operations that started the open loops.
+	std::vector<uint32_t> loop_stack;
+	/// The amount of open uncertainties.
+	uint32_t uncertainty_count;
+	/// The amount of times the copies of the body of the open counted loop are still executed (see CountedLoop).
+	uint64_t loop_count;
+	/// The operation which is executed next.
+	uint32_t pc;
+	/// The program which is executed.
+	const Program *program;
+	/// Whether to suspend execution before reading input.
+	bool suspend_before_input;
+	/// The trace where input is recorded, or from which it is replayed, if any.
+	ExecutionTrace *trace;
+	/// The tiers of the program, if it starts unoptimized and is optimized once one of its loops becomes hot.
+	TieredProgram *tiers;
+
+	ExecutionState();
+	virtual ~ExecutionState();
+
+	/// Gets the amount of cells of the data pointer.
+	virtual size_t getSize() const = 0;
+	/// Gets the width of the cells of the data pointer, in bits.
+	virtual uint8_t getCellBits() const = 0;
+	/**
+	 * Copies the data pointer.
+	 *
+	 * @param bytes The variable which will contain the cells, as they are stored in memory.
+	 */
+	virtual void getPointer(std::vector<uint8_t> &bytes) const = 0;
+	/**
+	 * Replaces the data pointer.
+	 *
+	 * @param bytes The cells, as they are stored in memory.
+	 * @param size The amount of bytes, which is a multiple of the cell size.
+	 */
+	virtual void setPointer(const uint8_t *bytes, size_t size) = 0;
+	/// Gets the kind of the data pointer.
+	virtual TapeKind getTapeKind() const = 0;
+	/**
+	 * Evaluates an operand of the program, like the operations do.
+	 *
+	 * @param operand The index of the operand.
+	 *
+	 * @return The value of the operand.
+	 *
+	 * @throws ExecutionError If evaluating the operand raises an error.
+	 */
+	virtual uint64_t evaluate(uint32_t operand) = 0;
+};
+
+/**
+ * A program which is executed in two tiers. It starts in the baseline tier, as it was compiled, and every LOOP_END
+ * counts how many times it repeated its loop. Once a LOOP_END repeats its loop threshold times, the program is optimized,
+ * and execution continues in the optimized tier from the next iteration of the loop (see executeProgram()).
+ */
+struct TieredProgram {
+	/// The program of the optimized tier. Before the program is optimized, a copy of the baseline program which is not bound.
+	Program optimized;
+	/// The passes with which the program is optimized.
+	PassOptions passes;
+	/// The amount of times a LOOP_END repeats its loop before the program is optimized.
+	uint32_t threshold;
+	/// The amount of times every LOOP_END of the baseline program repeated its loop.
+	std::vector<uint32_t> repetitions;
+	/// Whether execution continued in the optimized tier.
+	bool promoted;
+	/// The position in the script of the LOOP_END whose loop became hot.
+	uint32_t hot_position;
+	/// The time taken to optimize and bind the program, in nanoseconds.
+	uint64_t promotion_time;
+
+	/**
+	 * @param program The baseline program, which is not bound yet.
+	 * @param threshold The amount of times a LOOP_END repeats its loop before the program is optimized.
+	 * @param passes The passes with which the program is optimized.
+	 */
+	TieredProgram(const Program &program, uint32_t threshold, const PassOptions &passes);
+
+	/**
+	 * Writes whether the program was optimized, and when.
+	 *
+	 * @param output The stream.
+	 */
+	void report(std::ostream &output) const;
+};
+
+/// An error raised while executing a program.
+class ExecutionError : public std::runtime_error {
+	public:
+		/// The position in the script where the error was raised.
+		uint32_t position;
+
+		ExecutionError(const std::string &message, uint32_t pos);
+};
+
+/// Raised when execution is suspended. The execution state can be resumed from the operation at pc.
+class ExecutionSuspended : public std::exception {
+	public:
+		const char *what() const noexcept override;
+};
+
+/// When set (e.g. by a signal handler), execution is suspended at the next loop end.
+extern volatile std::sig_atomic_t suspend_requested;
+
+/**
+ * Selects the body of every operation of a program.
+ * VALUE_OPERATION bodies are specialized for each operator, target form and operand form.
+ *
+ * @param program The program.
+ * @param tape The kind of data pointer of the states which execute the program.
+ * @param cell_bits The width of the cells of the states which execute the program (8, 16, 32 or 64).
+ * @param baseline Whether the program is the baseline tier of a TieredProgram, whose LOOP_ENDs count the repetitions of their loops.
+ */
+void bindProgram(Program &program, TapeKind tape, uint8_t cell_bits = CELL_BITS_DEFAULT, bool baseline = false);
+/**
+ * Creates an execution state with an empty data pointer.
+ *
+ * @param tape The kind of data pointer.
+ * @param cell_bits The width of the cells (8, 16, 32 or 64).
+ *
+ * @return The execution state.
+ */
+std::unique_ptr<ExecutionState> createExecutionState(TapeKind tape, uint8_t cell_bits = CELL_BITS_DEFAULT);
+/**
+ * Reserves the loop stack, so that executing the program doesn't allocate unless loops are nested unusually deep.
+ * The data pointer is reserved when it is set.
+ *
+ * @param state The execution state, which contains the program.
+ */
+void prepareExecution(ExecutionState &state);
+/**
+ * Executes a bound program until it ends. If the program is the baseline tier of a TieredProgram and one of its loops
+ * becomes hot, the program is optimized, and the execution state is moved to the optimized tier on the fly: the operation
+ * which is executed next and the open loops are moved to the same operations of the optimized program.
+ *
+ * @param state The execution state, which contains the program.
+ *
+ * @throws ExecutionError If the program raises an error.
+ * @throws ExecutionSuspended If execution is suspended.
+ */
+void executeProgram(ExecutionState &state);
+/**
+ * Executes a bound program until it ends, like executeProgram() does, and charges every operation to a virtual clock.
+ *
+ * @param state The execution state, which contains the program.
+ * @param clock The virtual clock, which counts the streams of the execution state.
+ *
+ * @throws ExecutionError If the program raises an error.
+ * @throws ExecutionSuspended If execution is suspended.
+ */
+void executeProgram(ExecutionState &state, VirtualClock &clock);
+
+#endif
@@ -0,0 +1,66 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "execution_key.h"
+#include "hash.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define X10_STAT
+#include <sys/stat.h>
+#endif
+
+bool writesFiles(const Program &program) {
+	for (const Operation &operation : program.operations)
+		if (operation.code == OPCODE_FILE_OPEN && operation.modifier == '^')
+			return true;
+	return false;
+}
+
+uint64_t hashExecutionKey(uint32_t version, const Program &program, uint32_t argc, char *argv[], uint8_t cell_bits) {
+	uint64_t hash = hashBytes(&version, sizeof(version));
+	hash = hashBytes(program.source.data(), program.source.size(), hash);
+
+	// The terminators keep ["ab", "c"] apart from ["a", "bc"].
+	for (uint32_t i = 0; i < argc; ++i)
+		hash = hashBytes(argv[i], strlen(argv[i]) + 1, hash);
+	hash = hashBytes(&cell_bits, sizeof(cell_bits), hash);
+
+#ifdef X10_STAT
+	struct stat interpreter;
+	if (stat("/proc/self/exe", &interpreter) == 0) {
+		hash = hashBytes(&interpreter.st_size, sizeof(interpreter.st_size), hash);
+		hash = hashBytes(&interpreter.st_mtime, sizeof(interpreter.st_mtime), hash);
+	}
+#endif
+
+	return hash;
+}
+
+std::string getExecutionKeyFile(const std::string &directory, uint64_t hash, const char *extension) {
+	char name[17];
+	snprintf(name, sizeof(name), "%016llx", (unsigned long long) hash);
+	return (std::filesystem::path(directory) / (name + std::string(extension))).string();
+}
@@ -0,0 +1,63 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef X10_EXECUTION_KEY_H
+#define X10_EXECUTION_KEY_H
+
+#include "program.h"
+
+#include <string>
+
+/**
+ * Checks whether a program opens files for writing. Such programs are neither memoized nor specialized, since replaying them
+ * wouldn't write those files again.
+ *
+ * @param program The compiled script.
+ *
+ * @return True, if the program opens files for writing. False otherwise.
+ */
+bool writesFiles(const Program &program);
+/**
+ * Hashes what identifies the executions of a script: the version of the file format, the script, the arguments, the cell width
+ * and the build of the interpreter, which is identified by its size and its modification time.
+ *
+ * @param version The version of the file format.
+ * @param program The compiled script.
+ * @param argc The amount of arguments which initialize the data pointer.
+ * @param argv The arguments which initialize the data pointer.
+ * @param cell_bits The width of the cells.
+ *
+ * @return The hash.
+ */
+uint64_t hashExecutionKey(uint32_t version, const Program &program, uint32_t argc, char *argv[], uint8_t cell_bits);
+/**
+ * Gets the file of a directory which is named after a hash.
+ *
+ * @param directory The directory.
+ * @param hash The hash.
+ * @param extension The extension of the file.
+ *
+ * @return The path of the file.
+ */
+std::string getExecutionKeyFile(const std::string &directory, uint64_t hash, const char *extension);
+
+#endif
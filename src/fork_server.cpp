@@ -0,0 +1,218 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "fork_server.h"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define X10_FORK
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/// The buffer of STDIN.
+static char input_buffer[FORK_BUFFER_SIZE];
+/// The buffer of STDOUT.
+static char output_buffer[FORK_BUFFER_SIZE];
+
+void prefaultStreams() {
+	setvbuf(stdin, input_buffer, _IOFBF, sizeof(input_buffer));
+	setvbuf(stdout, output_buffer, _IOFBF, sizeof(output_buffer));
+
+	// The buffers are written, so that their pages are mapped before the children are forked.
+	memset(input_buffer, 0, sizeof(input_buffer));
+	memset(output_buffer, 0, sizeof(output_buffer));
+}
+
+#ifdef X10_FORK
+
+/**
+ * Writes a status line to STDOUT, bypassing the buffer of STDOUT, which is inherited by the children.
+ *
+ * @param status The status line, without the line ending.
+ */
+static void writeStatus(std::string status) {
+	status.push_back('\n');
+
+	const char *data = status.data();
+	size_t size = status.size();
+
+	while (size != 0) {
+		ssize_t written = write(STDOUT_FILENO, data, size);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			throw std::runtime_error("Cannot write the status of a job");
+
+		data += written;
+		size -= (size_t) written;
+	}
+}
+
+/**
+ * Reads the next line from the control pipe.
+ *
+ * @param buffer The bytes which were read after the previous line.
+ * @param line The variable which will contain the line, without the line ending.
+ *
+ * @return True, if a line was read. False, if the control pipe was closed.
+ */
+static bool readJob(std::string &buffer, std::string &line) {
+	char block[4096];
+
+	while (true) {
+		size_t end = buffer.find('\n');
+		if (end != std::string::npos) {
+			line.assign(buffer, 0, end);
+			buffer.erase(0, end + 1);
+			return true;
+		}
+
+		ssize_t size = read(STDIN_FILENO, block, sizeof(block));
+		if (size < 0 && errno == EINTR)
+			continue;
+		if (size < 0)
+			throw std::runtime_error("Cannot read the control pipe");
+
+		if (size == 0) {
+			// A last job without a line ending.
+			line.swap(buffer);
+			buffer.clear();
+			return !line.empty();
+		}
+		buffer.append(block, (size_t) size);
+	}
+}
+
+/**
+ * Opens a file of a job.
+ *
+ * @param file The file, or an empty name for /dev/null.
+ * @param flags The flags with which to open the file.
+ *
+ * @return The file descriptor, or -1 if the file cannot be opened.
+ */
+static int openJobFile(const std::string &file, int flags) {
+	return open(file.empty() ? "/dev/null" : file.c_str(), flags | O_CLOEXEC, 0666);
+}
+
+/**
+ * Applies the resource limits in a child.
+ *
+ * @param limits The resource limits.
+ */
+static void applyLimits(const ForkLimits &limits) {
+	if (limits.memory != 0) {
+		struct rlimit memory = { (rlim_t) limits.memory, (rlim_t) limits.memory };
+		setrlimit(RLIMIT_AS, &memory);
+	}
+	if (limits.cpu != 0) {
+		// SIGXCPU ends the child at the soft limit. The hard limit (SIGKILL) is a second later, in case it is ignored.
+		struct rlimit cpu = { (rlim_t) limits.cpu, (rlim_t) limits.cpu + 1 };
+		setrlimit(RLIMIT_CPU, &cpu);
+	}
+}
+
+bool serveForkJobs(const ForkLimits &limits, std::vector<std::string> &arguments) {
+	std::string buffer, line;
+
+	// STDOUT is flushed, so that the children don't write what the parent buffered.
+	fflush(stdout);
+
+	while (readJob(buffer, line)) {
+		std::vector<std::string> fields;
+		for (size_t start = 0; ; ) {
+			size_t end = line.find('\t', start);
+			fields.emplace_back(line, start, end == std::string::npos ? std::string::npos : end - start);
+			if (end == std::string::npos)
+				break;
+			start = end + 1;
+		}
+
+		if (fields.size() < 3) {
+			writeStatus("error Invalid job");
+			continue;
+		}
+
+		const int flags[3] = { O_RDONLY, O_WRONLY | O_CREAT | O_TRUNC, O_WRONLY | O_CREAT | O_TRUNC };
+		int files[3] = { -1, -1, -1 };
+		std::string failure;
+
+		for (int i = 0; i < 3 && failure.empty(); ++i) {
+			files[i] = openJobFile(fields[i], flags[i]);
+			if (files[i] == -1)
+				failure = "error Cannot open " + fields[i] + ": " + strerror(errno);
+		}
+
+		pid_t child = -1;
+		if (failure.empty()) {
+			child = fork();
+			if (child == -1)
+				failure = std::string("error Cannot fork: ") + strerror(errno);
+		}
+
+		if (child == 0) {
+			for (int i = 0; i < 3; ++i)
+				dup2(files[i], i);
+			for (int file : files)
+				close(file);
+
+			applyLimits(limits);
+			arguments.assign(fields.begin() + 3, fields.end());
+			return true;
+		}
+
+		for (int file : files) {
+			if (file != -1)
+				close(file);
+		}
+
+		if (child == -1) {
+			writeStatus(failure);
+			continue;
+		}
+
+		int status;
+		while (waitpid(child, &status, 0) == -1 && errno == EINTR);
+
+		if (WIFSIGNALED(status))
+			writeStatus("signal " + std::to_string(WTERMSIG(status)));
+		else writeStatus("exit " + std::to_string(WEXITSTATUS(status)));
+	}
+
+	return false;
+}
+
+#else
+
+bool serveForkJobs(const ForkLimits &limits, std::vector<std::string> &arguments) {
+	throw std::runtime_error("Fork servers are only supported on POSIX systems");
+}
+
+#endif
@@ -0,0 +1,64 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef X10_FORK_SERVER_H
+#define X10_FORK_SERVER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// The size of the buffers of STDIN and STDOUT, which are faulted in before the first child is forked.
+#define FORK_BUFFER_SIZE 65536
+
+/// The resource limits of every child of a fork server.
+struct ForkLimits {
+	/// The largest address space of a child, in bytes, or 0 for no limit.
+	uint64_t memory = 0;
+	/// The CPU time of a child, in seconds, or 0 for no limit.
+	uint32_t cpu = 0;
+};
+
+/**
+ * Faults in the buffers of STDIN and STDOUT, so that the children of a fork server inherit them instead of allocating them.
+ */
+void prefaultStreams();
+/**
+ * Reads jobs from STDIN (the control pipe), one per line, and forks a child for every job. A job is a tab-separated line
+ * of the input file, the output file and the error file of the child, followed by its optional arguments.
+ * Empty file names are replaced by /dev/null. The child starts with the files as its STDIN, STDOUT and STDERR,
+ * and with the resource limits. Once the child ends, its status is written to STDOUT as a line:
+ * "exit CODE", "signal NUMBER", or "error MESSAGE" if the child couldn't be started.
+ *
+ * Returns in every child, like fork() does. Returns in the parent once the control pipe is closed.
+ *
+ * @param limits The resource limits of every child.
+ * @param arguments The variable which will contain the optional arguments of the job, in the child.
+ *
+ * @return True, in the child. False, in the parent.
+ *
+ * @throws std::runtime_error If the control pipe cannot be read, or if fork servers aren't supported.
+ */
+bool serveForkJobs(const ForkLimits &limits, std::vector<std::string> &arguments);
+
+#endif
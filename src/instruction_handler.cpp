@@ -21,7 +21,13 @@
  */
 
 #include "instruction_handler.h"
+#include "operators.h"
 
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
 #include <string>
 
 std::unordered_map<char, Instruction> instruction_list;
@@ -50,6 +56,13 @@ Instruction INSTRUCTION_INPUT_OR('|', INPUT_OR);
 Instruction INSTRUCTION_FILE_OPEN('F', FILE_OPEN);
 Instruction INSTRUCTION_FILE_CLOSE('f', FILE_CLOSE);
 
+Instruction INSTRUCTION_BULK_READ('R', BULK_READ);
+Instruction INSTRUCTION_BULK_WRITE('W', BULK_WRITE);
+
+Instruction INSTRUCTION_MEMORY_FILL('S', MEMORY_FILL);
+Instruction INSTRUCTION_MEMORY_MOVE('M', MEMORY_MOVE);
+Instruction INSTRUCTION_MEMORY_COMPARE('C', MEMORY_COMPARE);
+
 void initializeInstructions() {
 	instruction_list[INSTRUCTION_VALUE_INCREMENT.getIdentifier()] = INSTRUCTION_VALUE_INCREMENT;
 	instruction_list[INSTRUCTION_VALUE_DECREMENT.getIdentifier()] = INSTRUCTION_VALUE_DECREMENT;
@@ -74,6 +87,13 @@ void initializeInstructions() {
 
     instruction_list[INSTRUCTION_FILE_OPEN.getIdentifier()] = INSTRUCTION_FILE_OPEN;
     instruction_list[INSTRUCTION_FILE_CLOSE.getIdentifier()] = INSTRUCTION_FILE_CLOSE;
+
+	instruction_list[INSTRUCTION_BULK_READ.getIdentifier()] = INSTRUCTION_BULK_READ;
+	instruction_list[INSTRUCTION_BULK_WRITE.getIdentifier()] = INSTRUCTION_BULK_WRITE;
+
+	instruction_list[INSTRUCTION_MEMORY_FILL.getIdentifier()] = INSTRUCTION_MEMORY_FILL;
+	instruction_list[INSTRUCTION_MEMORY_MOVE.getIdentifier()] = INSTRUCTION_MEMORY_MOVE;
+	instruction_list[INSTRUCTION_MEMORY_COMPARE.getIdentifier()] = INSTRUCTION_MEMORY_COMPARE;
 }
 
 bool findInstruction(char id, Instruction &instr) {
@@ -84,6 +104,71 @@ bool findInstruction(char id, Instruction &instr) {
 	return false;
 }
 
+void executeScript(POINTER_INFO) {
+	char current_char;
+
+	while (script.get(current_char)) {
+		// New line, space and tab.
+		if (current_char == 10 || current_char == 13 || current_char == 32 || current_char == 9 || current_char == 11)
+			continue;
+
+		Instruction i;
+		if (findInstruction(current_char, i))
+			i.execute(POINTER_INFO_PARAMS);
+		else throw std::runtime_error(std::string("Invalid instruction '") + current_char + '\'');
+	}
+}
+
+uint32_t scriptPosition(std::istream &script) {
+	if (script.tellg() == -1) {
+		script.clear();
+		script.seekg(0, std::ios::end);
+	}
+	return script.tellg();
+}
+
+LoopStack createLoopStack(std::istream &script) {
+	// Loops are only nested as deep as the amount of loop starts, unless the script is malformed.
+	std::vector<std::streampos> storage;
+	storage.reserve(std::count(std::istreambuf_iterator<char>(script), std::istreambuf_iterator<char>(), '{') + 1);
+
+	script.clear();
+	script.seekg(0);
+	return LoopStack(std::move(storage));
+}
+
+/**
+ * Checks whether the characters read from the script are an operator.
+ *
+ * @param text The characters. Only the first few are stored.
+ * @param length The amount of characters which were read.
+ * @param word The operator.
+ *
+ * @return True, if the characters are the operator. False otherwise.
+ */
+static bool isWord(const char *text, size_t length, const char *word) {
+	return length == strlen(word) && memcmp(text, word, length) == 0;
+}
+
+/**
+ * Reads a conditional operator, matching each of its characters (and the null terminator) in order.
+ *
+ * @param script The script.
+ * @param word The conditional operator.
+ *
+ * @return True, if the conditional operator was read. False otherwise.
+ */
+template<size_t N>
+static bool readConditional(std::istream &script, const char (&word)[N]) {
+	char text[N];
+	size_t length = 0;
+
+	for (char c : word)
+		if (script.peek() == c)
+			text[length++] = script.get();
+	return isWord(text, length, word);
+}
+
 uint8_t parseNum(POINTER_INFO) {
 	// This function expects a NUMBER_START character at the beginning.
 	// That's why characters should be extracted carefully, with peek() instead of get().
@@ -172,11 +257,16 @@ uint8_t parseNum(POINTER_INFO) {
 	else {
 		script.ignore(1); // Not a number start.
 
-		std::string res;
-		res.push_back(op);
+		// Like stoi, fail if the number doesn't fit in an int.
+		uint32_t num = op - '0';
+		bool overflow = false;
 
 		while (isdigit(op = script.get())) {
-			res.push_back(op);
+			if (!overflow) {
+				uint64_t next = (uint64_t) num * 10 + (op - '0');
+				overflow = next > INT_MAX;
+				num = (uint32_t) next;
+			}
 		}
 
 		if(op != NUMBER_END)
@@ -184,7 +274,8 @@ uint8_t parseNum(POINTER_INFO) {
 		while (script.peek() == NUMBER_END && !script.eof())
 			script.ignore(1);
 
-		uint32_t num = stoi(res);
+		if (overflow)
+			throw std::out_of_range("stoi");
 
 		if (ind) {
 			if (val) {
@@ -213,55 +304,55 @@ uint8_t parseNum(POINTER_INFO) {
 bool parseExpression(POINTER_INFO) {
 	uint8_t left = parseNum(POINTER_INFO_PARAMS);
 
-	std::string relational_operator;
-	while (script.peek() != NUMBER_START && !script.eof())
-		relational_operator.push_back(script.get());
+	// Only the first characters are stored, since longer relational operators are invalid anyway.
+	char relational_operator[4];
+	size_t relational_length = 0;
+	while (script.peek() != NUMBER_START && !script.eof()) {
+		char c = script.get();
+		if (relational_length < sizeof(relational_operator))
+			relational_operator[relational_length] = c;
+		++relational_length;
+	}
 
 	uint8_t right = parseNum(POINTER_INFO_PARAMS);
 
 	bool expression;
-	if (relational_operator == RELATIONAL_EQUAL) // Equal.
+	if (isWord(relational_operator, relational_length, RELATIONAL_EQUAL)) // Equal.
 		expression = left == right;
-	else if (relational_operator == RELATIONAL_NOT_EQUAL) // Not Equal.
+	else if (isWord(relational_operator, relational_length, RELATIONAL_NOT_EQUAL)) // Not Equal.
 		expression = left != right;
-	else if (relational_operator == RELATIONAL_GREATER_THAN) // Greater Than.
+	else if (isWord(relational_operator, relational_length, RELATIONAL_GREATER_THAN)) // Greater Than.
 		expression = left > right;
-	else if (relational_operator == RELATIONAL_GREATER_THAN_OR_EQUAL) // Greater Than or Equal.
+	else if (isWord(relational_operator, relational_length, RELATIONAL_GREATER_THAN_OR_EQUAL)) // Greater Than or Equal.
 		expression = left >= right;
-	else if (relational_operator == RELATIONAL_LESS_THAN) // Less Than.
+	else if (isWord(relational_operator, relational_length, RELATIONAL_LESS_THAN)) // Less Than.
 		expression = left < right;
-	else if (relational_operator == RELATIONAL_LESS_THAN_OR_EQUAL) // Less Than or Equal.
+	else if (isWord(relational_operator, relational_length, RELATIONAL_LESS_THAN_OR_EQUAL)) // Less Than or Equal.
 		expression = left <= right;
 	else throw std::runtime_error("Invalid relational operator");
 
-	std::string conditional_operator;
 	std::streampos before = script.tellg();
+	bool conditional_and = false;
+	bool conditional_or = false;
+	bool conditional_xor = false;
 
-	for (char c : CONDITIONAL_AND) // AND.
-		if (script.peek() == c)
-			conditional_operator.push_back(script.get());
-	if (conditional_operator != CONDITIONAL_AND) {
+	conditional_and = readConditional(script, CONDITIONAL_AND); // AND.
+	if (!conditional_and) {
 		script.seekg(before);
-		conditional_operator = "";
-		for (char c : CONDITIONAL_OR) // OR.
-			if (script.peek() == c)
-				conditional_operator.push_back(script.get());
-		if (conditional_operator != CONDITIONAL_OR) {
+		conditional_or = readConditional(script, CONDITIONAL_OR); // OR.
+		if (!conditional_or) {
 			script.seekg(before);
-			conditional_operator = "";
-			for (char c : CONDITIONAL_XOR) // XOR.
-				if (script.peek() == c)
-					conditional_operator.push_back(script.get());
-			if (conditional_operator != CONDITIONAL_XOR)
+			conditional_xor = readConditional(script, CONDITIONAL_XOR); // XOR.
+			if (!conditional_xor)
 				script.seekg(before); // Nothing.
 		}
 	}
 
-	if (conditional_operator == CONDITIONAL_AND)
+	if (conditional_and)
 		return expression && parseExpression(POINTER_INFO_PARAMS);
-	if (conditional_operator == CONDITIONAL_OR)
+	if (conditional_or)
 		return parseExpression(POINTER_INFO_PARAMS) || expression; // Force parse, even if 'expression' is true, to move the stream cursor forwards.
-	if (conditional_operator == CONDITIONAL_XOR)
+	if (conditional_xor)
 		return expression != parseExpression(POINTER_INFO_PARAMS);
 	return expression;
 }
@@ -276,102 +367,23 @@ void VALUE_DECREMENT(POINTER_INFO) {
 
 void VALUE_OPERATION(POINTER_INFO) {
 	char op = 0;
-	if (script.peek() != NUMBER_START) { // Apply to current index.
-		script.get(op);
+	uint32_t target = index;
 
-		switch (op) {
-			case '$': {
-				pointer.at(index) = parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			case '+': {
-				pointer.at(index) += parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			case '-': {
-				pointer.at(index) -= parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			case '*': {
-				pointer.at(index) *= parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			case '/': {
-				pointer.at(index) /= parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			case '%': {
-				pointer.at(index) %= parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			case 'x': {
-				pointer.at(index) ^= parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			case '&': {
-				pointer.at(index) &= parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			case '|': {
-				pointer.at(index) |= parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			default: {
-				throw std::runtime_error("Invalid operator");
-				break;
-			}
-		}
-	}
-	else {
-		uint32_t new_index = parseNum(POINTER_INFO_PARAMS); // New index.
-		while (pointer.size() <= new_index) // Prevents 'invalid vector<t> subscript'.
+	if (script.peek() == NUMBER_START) { // Apply to another index.
+		target = parseNum(POINTER_INFO_PARAMS); // New index.
+		while (pointer.size() <= target) // Prevents 'invalid vector<t> subscript'.
 			pointer.push_back(0); // Pad with 0s until the new index is reached.
+	}
 
-		script.get(op);
+	script.get(op);
 
-		switch (op) {
-			case '$': {
-				pointer.at(new_index) = parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			case '+': {
-				pointer.at(new_index) += parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			case '-': {
-				pointer.at(new_index) -= parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			case '*': {
-				pointer.at(new_index) *= parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			case '/': {
-				pointer.at(new_index) /= parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			case '%': {
-				pointer.at(index) %= parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			case 'x': {
-				pointer.at(new_index) ^= parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			case '&': {
-				pointer.at(new_index) &= parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			case '|': {
-				pointer.at(new_index) |= parseNum(POINTER_INFO_PARAMS);
-				break;
-			}
-			default: {
-				throw std::runtime_error("Invalid operator");
-				break;
-			}
-		}
-	}
+	if (!isOperator(op))
+		throw std::runtime_error("Invalid operator");
+
+	uint8_t value = parseNum(POINTER_INFO_PARAMS);
+	if ((op == OPERATOR_DIVIDE || op == OPERATOR_MODULO) && value == 0)
+		throw std::runtime_error("Division by zero");
+	pointer.at(target) = applyOperator(op, pointer.at(target), value);
 
 	script.ignore(1); // Ending round bracket.
 }
@@ -389,7 +401,7 @@ void INDEX_DECREMENT(POINTER_INFO) {
 void UNCERTAINTY_START(POINTER_INFO) {
 	if (!parseExpression(POINTER_INFO_PARAMS)) { // Skip uncertainty.
 		int open_count = 1;
-		while (open_count > 0) {
+		while (open_count > 0 && !script.fail()) {
 			char c = script.get();
 			if (c == '?')
 				open_count++;
@@ -413,7 +425,7 @@ void LOOP_START(POINTER_INFO) {
 	if (!parseExpression(POINTER_INFO_PARAMS)) { // Skip loop.
 		loop_stack.pop(); // Remove the position from the stack.
 		uint32_t open_count = 1;
-		while (open_count > 0)
+		while (open_count > 0 && !script.fail())
 		{
 			char c = script.get();
 			if (c == '{')
@@ -426,6 +438,9 @@ void LOOP_START(POINTER_INFO) {
 
 void LOOP_END(POINTER_INFO)
 {
+	if (loop_stack.empty())
+		throw std::runtime_error("Unexpected loop end");
+
 	uint32_t after_loop = script.tellg();
 
 	script.seekg(loop_stack.top());
@@ -516,12 +531,16 @@ void FILE_OPEN(POINTER_INFO) {
     script.ignore(1);
 
     if(mode == 'v') {
-        if(file_input != nullptr)
+        if(file_input != nullptr) {
             file_input -> close();
+            delete file_input;
+        }
         file_input = new std::ifstream(filename);
     } else {
-        if(file_output != nullptr)
+        if(file_output != nullptr) {
             file_output -> close();
+            delete file_output;
+        }
         file_output = new std::ofstream(filename);
     }
 }
@@ -547,4 +566,80 @@ void FILE_CLOSE(POINTER_INFO) {
             file_output = nullptr;
         } else throw std::runtime_error("No file opened with write mode");
     }
-}
\ No newline at end of file
+}
+
+void BULK_READ(POINTER_INFO) {
+	uint8_t count = parseNum(POINTER_INFO_PARAMS);
+	uint8_t target = parseNum(POINTER_INFO_PARAMS);
+	std::istream &stream = file_input != nullptr ? *file_input : input;
+	size_t read = 0;
+
+	if (count != 0) {
+		pointer.at(index);
+
+		// The bytes are read straight into the data pointer, which only keeps the cells that were read.
+		size_t size = pointer.size();
+		pointer.resize(std::max<size_t>(size, index + count));
+		stream.read((char*) pointer.data() + index, count);
+		read = (size_t) stream.gcount();
+		pointer.resize(std::max<size_t>(size, index + read));
+	}
+
+	while (pointer.size() <= target) // Pad with 0s until the new index is reached.
+		pointer.push_back(0);
+	pointer.at(target) = (uint8_t) read;
+}
+
+void BULK_WRITE(POINTER_INFO) {
+	uint8_t first = parseNum(POINTER_INFO_PARAMS);
+	uint8_t last = parseNum(POINTER_INFO_PARAMS);
+
+	if (last > first) {
+		pointer.at(last - 1);
+		(file_output != nullptr ? (*file_output) : output).write((const char*) pointer.data() + first, last - first);
+	}
+}
+
+void MEMORY_FILL(POINTER_INFO) {
+	uint8_t start = parseNum(POINTER_INFO_PARAMS);
+	uint8_t count = parseNum(POINTER_INFO_PARAMS);
+	uint8_t value = parseNum(POINTER_INFO_PARAMS);
+
+	if (count == 0)
+		return;
+	if (pointer.size() < (size_t) start + count) // Pad with 0s until the end of the range is reached.
+		pointer.resize((size_t) start + count);
+	memset(pointer.data() + start, value, count);
+}
+
+void MEMORY_MOVE(POINTER_INFO) {
+	uint8_t destination = parseNum(POINTER_INFO_PARAMS);
+	uint8_t source = parseNum(POINTER_INFO_PARAMS);
+	uint8_t count = parseNum(POINTER_INFO_PARAMS);
+
+	if (count == 0)
+		return;
+
+	pointer.at(source + count - 1);
+	if (pointer.size() < (size_t) destination + count)
+		pointer.resize((size_t) destination + count);
+	memmove(pointer.data() + destination, pointer.data() + source, count);
+}
+
+void MEMORY_COMPARE(POINTER_INFO) {
+	uint8_t first = parseNum(POINTER_INFO_PARAMS);
+	uint8_t second = parseNum(POINTER_INFO_PARAMS);
+	uint8_t count = parseNum(POINTER_INFO_PARAMS);
+	uint8_t target = parseNum(POINTER_INFO_PARAMS);
+	int result = 0;
+
+	if (count != 0) {
+		pointer.at(first + count - 1);
+		pointer.at(second + count - 1);
+		result = memcmp(pointer.data() + first, pointer.data() + second, count);
+	}
+
+	while (pointer.size() <= target) // Pad with 0s until the new index is reached.
+		pointer.push_back(0);
+	pointer.at(target) = result == 0 ? 0 : result < 0 ? 1 : 2;
+}
@@ -46,6 +46,10 @@ extern void initializeInstructions();
  */
 bool findInstruction(char id, Instruction &instr);
 
+void executeScript(POINTER_INFO);
+uint32_t scriptPosition(std::istream &script);
+LoopStack createLoopStack(std::istream &script);
+
 uint8_t parseNum(POINTER_INFO);
 bool parseExpression(POINTER_INFO);
 
@@ -73,6 +77,13 @@ void INPUT_OR(POINTER_INFO);
 void FILE_OPEN(POINTER_INFO);
 void FILE_CLOSE(POINTER_INFO);
 
+void BULK_READ(POINTER_INFO);
+void BULK_WRITE(POINTER_INFO);
+
+void MEMORY_FILL(POINTER_INFO);
+void MEMORY_MOVE(POINTER_INFO);
+void MEMORY_COMPARE(POINTER_INFO);
+
 extern Instruction INSTRUCTION_VALUE_INCREMENT; // Increment char value at current index.
 extern Instruction INSTRUCTION_VALUE_DECREMENT; // Decrement char value at current index.
 extern Instruction INSTRUCTION_VALUE_OPERATION; // Execute an operation on value at current index.
@@ -97,4 +108,11 @@ extern Instruction INSTRUCTION_INPUT_OR; // OR input with value from current ind
 extern Instruction INSTRUCTION_FILE_OPEN; // Redirect input or output to file.
 extern Instruction INSTRUCTION_FILE_CLOSE; // Stop redirecting input or output to file.
 
+extern Instruction INSTRUCTION_BULK_READ; // Read raw bytes from input to values from current index.
+extern Instruction INSTRUCTION_BULK_WRITE; // Write a range of values to output as raw bytes.
+
+extern Instruction INSTRUCTION_MEMORY_FILL; // Set a range of values to a value.
+extern Instruction INSTRUCTION_MEMORY_MOVE; // Copy a range of values to another index.
+extern Instruction INSTRUCTION_MEMORY_COMPARE; // Compare two ranges of values.
+
 #endif
\ No newline at end of file
@@ -21,12 +21,96 @@
  */
 
 #include "instruction_handler.h"
+#include "arguments.h"
+#include "compiler.h"
+#include "engine.h"
+#include "optimizer.h"
+#include "record_map.h"
+#include "pipeline.h"
+#include "snapshot.h"
+#include "specialization.h"
+#include "memoization.h"
+#include "execution_key.h"
+#include "profiler.h"
+#include "trace.h"
+#include "fork_server.h"
+#include "conformance.h"
+#include "allocation_counter.h"
+#include "perf_counters.h"
+#include "virtual_clock.h"
 #include "timerh/timer.h"
 
+#include <csignal>
 #include <cstdio>
 #include <cstdarg>
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <iterator>
+
+/// The engines which can execute a script.
+enum ExecutionEngine {
+	ENGINE_REFERENCE, // Interprets the script character by character.
+	ENGINE_COMPILED   // Compiles the script, and then executes it.
+};
+
+/// The options which come before the script file.
+struct InterpreterOptions {
+	/// The engine which executes the script.
+	ExecutionEngine engine = ENGINE_COMPILED;
+	/// The kind of data pointer used by the compiled engine.
+	TapeKind tape = TAPE_DENSE;
+	/// Whether to select the kind of data pointer from the script.
+	bool automatic_tape = true;
+	/// The width of the cells used by the compiled engine, in bits.
+	uint8_t cell_bits = CELL_BITS_DEFAULT;
+	/// Whether to optimize the compiled program.
+	bool optimize = true;
+	/// The passes of the optimizer which are run, and where their time is written.
+	PassOptions passes;
+	/// Whether to write the compiled program to STDERR before it is executed.
+	bool dump_ir = false;
+	/// Whether to start executing the script unoptimized, and optimize it once one of its loops becomes hot.
+	bool tiered = false;
+	/// The amount of times a loop is repeated before a tiered script is optimized.
+	uint32_t tier_threshold = TIER_THRESHOLD;
+	/// Whether to count hardware events while the script is executed.
+	bool perf_counters = false;
+	/// Whether to charge every executed operation to a virtual clock.
+	bool virtual_clock = false;
+	/// The file where to write the samples of the profiler, if any.
+	const char *profile = nullptr;
+	/// The file where to record the input, if any.
+	const char *record = nullptr;
+	/// The file from which to replay the input, if any.
+	const char *replay = nullptr;
+	/// The amount of values read between the checkpoints of a recorded trace, or 0 for no checkpoints.
+	uint32_t checkpoint = 0;
+	/// The file where to save a snapshot when execution is suspended, if any.
+	const char *snapshot = nullptr;
+	/// Whether to suspend execution before reading input.
+	bool snapshot_before_input = false;
+	/// The snapshot from which to restore the execution state, if any.
+	const char *restore = nullptr;
+	/// The directory of the specializations of scripts for their arguments, if any.
+	const char *specialize = nullptr;
+	/// Where to memoize the executions which don't read input.
+	MemoOptions memoize;
+	/// Whether to compile the script once, and then execute the jobs read from STDIN in forked children.
+	bool fork_server = false;
+	/// The resource limits of every child of the fork server.
+	ForkLimits limits;
+	/// How to split the input into records, if the script is mapped over them.
+	MapOptions map;
+	/// Whether to execute the scripts as the stages of a pipeline, each on its own thread.
+	bool pipeline = false;
+	/// Whether to check the engines against the reference interpreter, instead of executing a script.
+	bool conformance = false;
+	/// The amount of random programs to check.
+	uint32_t conformance_count = 0;
+	/// The seed of the first random program.
+	uint32_t seed = 1;
+};
 
 /**
  * Writes an error to STDERR and terminates the program with the status code 1.
@@ -61,15 +145,78 @@ bool openFile(const char* file, std::ifstream &script);
  */
 void closeFiles(std::ifstream *&file_input, std::ofstream *&file_output);
 /**
- * Interprets a script.
+ * Initializes the data pointer of an execution state from the command-line arguments.
+ * Writes an error and terminates the program if the arguments are invalid.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv The command-line arguments.
+ * @param state The execution state, whose cell width is used.
+ */
+void initializeArguments(uint32_t argc, char *argv[], ExecutionState &state);
+/**
+ * Writes an error raised while executing a script, and terminates the program.
+ *
+ * @param position The position in the script where the error was raised.
+ * @param what The error.
+ */
+void executionError(uint32_t position, const char *what);
+/**
+ * Interprets a script character by character.
  *
  * @param script The script to interpret, as a file input stream.
  * @param input The stream from which to receive input.
  * @param output The stream where to output.
  * @param argc The number of command-line arguments.
  * @param argv The command-line arguments.
+ * @param options The interpreter options.
+ */
+void interpret(std::ifstream &script, std::istream &input, std::ostream &output, uint32_t argc, char *argv[], const InterpreterOptions &options);
+/**
+ * Requests the suspension of the execution when a signal is received.
+ *
+ * @param signal The signal.
+ */
+void suspendHandler(int signal);
+/**
+ * Stops the profiler and writes its samples, and ends the recorded trace, if any.
+ *
+ * @param state The execution state, which contains the program.
+ * @param options The interpreter options.
+ */
+void finishExecution(ExecutionState &state, const InterpreterOptions &options);
+/**
+ * Compiles a script, and then executes it.
+ *
+ * @param script The script to execute, as a file input stream.
+ * @param input The stream from which to receive input.
+ * @param output The stream where to output.
+ * @param argc The number of command-line arguments.
+ * @param argv The command-line arguments.
+ * @param options The interpreter options.
  */
-void interpret(std::ifstream &script, std::istream &input, std::ostream &output, uint32_t argc, char *argv[]);
+void interpretCompiled(std::ifstream &script, std::istream &input, std::ostream &output, uint32_t argc, char *argv[], const InterpreterOptions &options);
+/**
+ * Compiles a script, and then executes it once for every record of the map input.
+ * Terminates the program with the status code 1 if any record raises an error.
+ *
+ * @param script The script to execute, as a file input stream.
+ * @param output The stream where to output.
+ * @param argc The number of command-line arguments.
+ * @param argv The command-line arguments.
+ * @param options The interpreter options.
+ */
+void mapCompiled(std::ifstream &script, std::ostream &output, uint32_t argc, char *argv[], const InterpreterOptions &options);
+/**
+ * Compiles scripts, and then executes them as the stages of a pipeline.
+ * Terminates the program with the status code 1 if any stage raises an error.
+ *
+ * @param count The number of scripts.
+ * @param scripts The script files, in stage order.
+ * @param input The stream from which the first stage receives input.
+ * @param output The stream where the last stage outputs.
+ * @param options The interpreter options.
+ */
+void pipelineCompiled(uint32_t count, char *scripts[], std::istream &input, std::ostream &output, const InterpreterOptions &options);
 
 /**
  * The main function.
@@ -80,117 +227,586 @@ void interpret(std::ifstream &script, std::istream &input, std::ostream &output,
  * @return The program exit code.
  */
 int main(int argc, char *argv[]) {
-	if (argc < 2)
+	InterpreterOptions options;
+
+	// Interpreter options come before the script file.
+	int first = 1;
+	for (; first < argc && strncmp(argv[first], "--", 2) == 0; ++first) {
+		const char *option = argv[first];
+
+		if (strcmp(option, "--engine=reference") == 0)
+			options.engine = ENGINE_REFERENCE;
+		else if (strcmp(option, "--engine=compiled") == 0)
+			options.engine = ENGINE_COMPILED;
+		else if (strcmp(option, "--tape=dense") == 0) {
+			options.tape = TAPE_DENSE;
+			options.automatic_tape = false;
+		}
+		else if (strcmp(option, "--tape=paged") == 0) {
+			options.tape = TAPE_PAGED;
+			options.automatic_tape = false;
+		}
+		else if (strcmp(option, "--tape=auto") == 0)
+			options.automatic_tape = true;
+		else if (strcmp(option, "--cell-bits=8") == 0 || strcmp(option, "--cell-bits=16") == 0 ||
+		         strcmp(option, "--cell-bits=32") == 0 || strcmp(option, "--cell-bits=64") == 0)
+			options.cell_bits = (uint8_t) atoi(option + 12);
+		else if (strcmp(option, "--no-optimize") == 0)
+			options.optimize = false;
+		else if (strncmp(option, "--disable-pass=", 15) == 0 && findPass(option + 15) != PASS_COUNT)
+			options.passes.enabled[findPass(option + 15)] = false;
+		else if (strncmp(option, "--unroll=", 9) == 0 && isdigit(option[9]) && atoi(option + 9) > 0)
+			options.passes.unroll = (uint32_t) strtoul(option + 9, nullptr, 10);
+		else if (strcmp(option, "--time-passes") == 0)
+			options.passes.timing = &std::cerr;
+		else if (strcmp(option, "--dump-ir") == 0)
+			options.dump_ir = true;
+		else if (strcmp(option, "--tiered") == 0)
+			options.tiered = true;
+		else if (strncmp(option, "--tier-threshold=", 17) == 0 && isdigit(option[17]) && atoi(option + 17) > 0)
+			options.tier_threshold = (uint32_t) strtoul(option + 17, nullptr, 10);
+		else if (strcmp(option, "--perf-counters") == 0)
+			options.perf_counters = true;
+		else if (strcmp(option, "--virtual-clock") == 0)
+			options.virtual_clock = true;
+		else if (strncmp(option, "--profile=", 10) == 0 && option[10] != '\0')
+			options.profile = option + 10;
+		else if (strncmp(option, "--record=", 9) == 0 && option[9] != '\0')
+			options.record = option + 9;
+		else if (strncmp(option, "--replay=", 9) == 0 && option[9] != '\0')
+			options.replay = option + 9;
+		else if (strncmp(option, "--checkpoint=", 13) == 0 && isdigit(option[13]))
+			options.checkpoint = (uint32_t) strtoul(option + 13, nullptr, 10);
+		else if (strncmp(option, "--map=", 6) == 0 && option[6] != '\0')
+			options.map.input = option + 6;
+		else if (strncmp(option, "--delimiter=", 12) == 0 && option[12] != '\0' && option[13] == '\0')
+			options.map.delimiter = option[12];
+		else if (strcmp(option, "--delimiter=\\n") == 0)
+			options.map.delimiter = '\n';
+		else if (strcmp(option, "--delimiter=\\t") == 0)
+			options.map.delimiter = '\t';
+		else if (strcmp(option, "--delimiter=\\0") == 0)
+			options.map.delimiter = '\0';
+		else if (strncmp(option, "--record-size=", 14) == 0 && isdigit(option[14]) && atoi(option + 14) > 0)
+			options.map.record_size = (size_t) strtoull(option + 14, nullptr, 10);
+		else if (strncmp(option, "--jobs=", 7) == 0 && isdigit(option[7]))
+			options.map.jobs = (uint32_t) strtoul(option + 7, nullptr, 10);
+		else if (strcmp(option, "--pipeline") == 0)
+			options.pipeline = true;
+		else if (strncmp(option, "--snapshot=", 11) == 0 && option[11] != '\0')
+			options.snapshot = option + 11;
+		else if (strcmp(option, "--snapshot-before-input") == 0)
+			options.snapshot_before_input = true;
+		else if (strncmp(option, "--restore=", 10) == 0 && option[10] != '\0')
+			options.restore = option + 10;
+		else if (strncmp(option, "--specialize=", 13) == 0 && option[13] != '\0')
+			options.specialize = option + 13;
+		else if (strncmp(option, "--memoize=", 10) == 0 && option[10] != '\0')
+			options.memoize.directory = option + 10;
+		else if (strncmp(option, "--memoize-size=", 15) == 0 && isdigit(option[15]))
+			options.memoize.size = strtoull(option + 15, nullptr, 10) << 20;
+		else if (strcmp(option, "--fork-server") == 0)
+			options.fork_server = true;
+		else if (strncmp(option, "--memory-limit=", 15) == 0 && isdigit(option[15]))
+			options.limits.memory = strtoull(option + 15, nullptr, 10) << 20;
+		else if (strncmp(option, "--cpu-limit=", 12) == 0 && isdigit(option[12]))
+			options.limits.cpu = (uint32_t) strtoul(option + 12, nullptr, 10);
+		else if (strncmp(option, "--conformance=", 14) == 0 && isdigit(option[14])) {
+			options.conformance = true;
+			options.conformance_count = (uint32_t) strtoul(option + 14, nullptr, 10);
+		}
+		else if (strncmp(option, "--seed=", 7) == 0 && isdigit(option[7]))
+			options.seed = (uint32_t) strtoul(option + 7, nullptr, 10);
+		else error(formatString(32u + strlen(option), "%s '%s'", "[ERROR]: Invalid option", option).c_str());
+	}
+
+	if (options.snapshot_before_input && options.snapshot == nullptr)
+		error("[ERROR]: --snapshot-before-input requires --snapshot");
+	if (options.engine == ENGINE_REFERENCE && (options.snapshot != nullptr || options.restore != nullptr))
+		error("[ERROR]: Snapshots require the compiled engine");
+	if (options.engine == ENGINE_REFERENCE && options.cell_bits != CELL_BITS_DEFAULT)
+		error("[ERROR]: Wide cells require the compiled engine");
+	if ((options.dump_ir || options.passes.timing != nullptr) && options.engine == ENGINE_REFERENCE)
+		error("[ERROR]: --dump-ir and --time-passes require the compiled engine");
+	if (options.specialize != nullptr && (std::count(options.passes.enabled, options.passes.enabled + PASS_COUNT, false) != 0 || options.passes.unroll != UNROLL_FACTOR))
+		error("[ERROR]: --disable-pass and --unroll cannot be used with --specialize");
+	if (options.tiered && (options.engine == ENGINE_REFERENCE || options.map.input != nullptr || !options.optimize))
+		error("[ERROR]: --tiered requires the compiled engine and the optimizer, without --map");
+	if (options.tiered && (options.snapshot != nullptr || options.restore != nullptr || options.specialize != nullptr || options.profile != nullptr))
+		error("[ERROR]: --tiered cannot be used with snapshots, --specialize or --profile");
+	if (options.tier_threshold != TIER_THRESHOLD && !options.tiered)
+		error("[ERROR]: --tier-threshold requires --tiered");
+	if (options.virtual_clock && (options.engine == ENGINE_REFERENCE || options.map.input != nullptr))
+		error("[ERROR]: --virtual-clock requires the compiled engine, without --map");
+	if (options.virtual_clock && (options.snapshot != nullptr || options.restore != nullptr || options.specialize != nullptr || options.memoize.directory != nullptr))
+		error("[ERROR]: --virtual-clock cannot be used with snapshots, --specialize or --memoize");
+	if (options.map.input != nullptr && options.engine == ENGINE_REFERENCE)
+		error("[ERROR]: --map requires the compiled engine");
+	if (options.map.input != nullptr && (options.snapshot != nullptr || options.restore != nullptr))
+		error("[ERROR]: --map cannot be used with snapshots");
+	if (options.pipeline && (options.engine == ENGINE_REFERENCE || options.map.input != nullptr))
+		error("[ERROR]: --pipeline requires the compiled engine, without --map");
+	if (options.pipeline && (options.snapshot != nullptr || options.restore != nullptr || options.record != nullptr || options.replay != nullptr ||
+	                         options.specialize != nullptr || options.memoize.directory != nullptr || options.profile != nullptr))
+		error("[ERROR]: --pipeline cannot be used with snapshots, traces, --specialize, --memoize or --profile");
+	if (options.pipeline && (options.fork_server || options.tiered || options.virtual_clock))
+		error("[ERROR]: --pipeline cannot be used with --fork-server, --tiered or --virtual-clock");
+	if (options.specialize != nullptr && options.engine == ENGINE_REFERENCE)
+		error("[ERROR]: --specialize requires the compiled engine");
+	if (options.specialize != nullptr && (options.snapshot != nullptr || options.restore != nullptr || options.map.input != nullptr))
+		error("[ERROR]: --specialize cannot be used with snapshots or --map");
+	if (options.memoize.directory != nullptr && (options.engine == ENGINE_REFERENCE || options.map.input != nullptr))
+		error("[ERROR]: --memoize requires the compiled engine, without --map");
+	if (options.memoize.directory != nullptr && (options.snapshot != nullptr || options.restore != nullptr || options.specialize != nullptr ||
+	                                             options.record != nullptr || options.replay != nullptr || options.profile != nullptr))
+		error("[ERROR]: --memoize cannot be used with snapshots, traces, --specialize or --profile");
+	if (options.memoize.size != MEMO_CACHE_SIZE && options.memoize.directory == nullptr)
+		error("[ERROR]: --memoize-size requires --memoize");
+	if (options.profile != nullptr && (options.engine == ENGINE_REFERENCE || options.map.input != nullptr))
+		error("[ERROR]: --profile requires the compiled engine, without --map");
+	if ((options.record != nullptr || options.replay != nullptr) && (options.engine == ENGINE_REFERENCE || options.map.input != nullptr))
+		error("[ERROR]: Traces require the compiled engine, without --map");
+	if ((options.record != nullptr || options.replay != nullptr) && (options.snapshot != nullptr || options.restore != nullptr || options.specialize != nullptr))
+		error("[ERROR]: Traces cannot be used with snapshots or --specialize");
+	if (options.record != nullptr && options.replay != nullptr)
+		error("[ERROR]: --record cannot be used with --replay");
+	if (options.checkpoint != 0 && options.record == nullptr)
+		error("[ERROR]: --checkpoint requires --record");
+	if (options.fork_server && (options.engine == ENGINE_REFERENCE || options.map.input != nullptr))
+		error("[ERROR]: --fork-server requires the compiled engine, without --map");
+	if (options.fork_server && (options.snapshot != nullptr || options.restore != nullptr || options.record != nullptr ||
+	                            options.replay != nullptr || options.profile != nullptr))
+		error("[ERROR]: --fork-server cannot be used with snapshots, traces or --profile");
+	if ((options.limits.memory != 0 || options.limits.cpu != 0) && !options.fork_server)
+		error("[ERROR]: Resource limits require --fork-server");
+
+	if (options.conformance) {
+		initializeInstructions();
+
+		// The other arguments are the scripts of the corpus.
+		std::vector<std::string> corpus(argv + first, argv + argc);
+		uint32_t divergences = checkConformance(corpus, options.conformance_count, options.seed, std::cout);
+
+		std::cout << "[INFO] Checked " << corpus.size() + options.conformance_count << " scripts against "
+		          << std::count_if(conformance_engines.begin(), conformance_engines.end(), [](const ConformanceEngine &engine) { return !engine.baseline; })
+		          << " engines, " << divergences << " divergences\n";
+		exit(divergences == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	if (options.pipeline) {
+		// The other arguments are the scripts of the stages, which take no arguments.
+		if (argc - first < 2)
+			error("[ERROR]: --pipeline requires at least two scripts");
+
+		initializeInstructions();
+		pipelineCompiled((uint32_t) (argc - first), argv + first, std::cin, std::cout, options);
+		exit(EXIT_SUCCESS);
+	}
+
+	if (argc - first < 1)
 		error("[ERROR]: Invalid arguments");
 
-	const char *scriptFile = *(argv + 1);
+	const char *scriptFile = *(argv + first);
 
 	std::ifstream script;
 
 	if (!openFile(scriptFile, script))
 		error("[ERROR]: Invalid script file");
 
-	// Ignore the name and script file.
-	argc -= 2;
-	argv += 2;
+	// Ignore the name, options and script file.
+	argc -= first + 1;
+	argv += first + 1;
+
+	if (options.fork_server && argc != 0)
+		error("[ERROR]: --fork-server takes the optional arguments from the jobs");
 
 	// Initialize instruction list.
     initializeInstructions();
-	interpret(script, std::cin, std::cout, argc, argv);
+
+	if (options.engine == ENGINE_REFERENCE)
+		interpret(script, std::cin, std::cout, argc, argv, options);
+	else if (options.map.input != nullptr)
+		mapCompiled(script, std::cout, argc, argv, options);
+	else interpretCompiled(script, std::cin, std::cout, argc, argv, options);
 	script.close();
 
 	exit(EXIT_SUCCESS);
 }
 
-void interpret(std::ifstream &script, std::istream &input, std::ostream &output, uint32_t argc, char *argv[]) {
+void initializeArguments(uint32_t argc, char *argv[], ExecutionState &state) {
+	try {
+		initializeState(argc, argv, state);
+	}
+	catch (std::exception &e) {
+		std::string err = "\n[ERROR]: ";
+		err.append(e.what());
+		error(err.c_str());
+	}
+}
+
+void interpret(std::ifstream &script, std::istream &input, std::ostream &output, uint32_t argc, char *argv[], const InterpreterOptions &options) {
     CHRONOMETER chronometer = time_now();
 
     std::ifstream *file_input = nullptr;
     std::ofstream *file_output = nullptr;
 
+	std::vector<uint8_t> pointer;
+	try {
+		initializePointer(argc, argv, pointer);
+	}
+	catch (std::exception &e) {
+		std::string err = "\n[ERROR]: ";
+		err.append(e.what());
+		error(err.c_str());
+	}
+
 	try {
 		// Pointer info.
-        char current_char;
         uint32_t index = 0;
-		std::vector<uint8_t> pointer;
         uint32_t uncertainty_count = 0;
-		std::stack<std::streampos> loop_stack;
+		LoopStack loop_stack = createLoopStack(script);
+
+		PerfCounters counters(options.perf_counters);
+		uint64_t allocations = getAllocationCount();
+		counters.start();
+		executeScript(POINTER_INFO_PARAMS);
+		counters.stop();
+		reportAllocations(output, allocations);
+		counters.report(output, "reference");
 
+        std::string time = getf_exec_time_ns(chronometer);
+		output << formatString(25 + time.size(), "\n%s %s\n", "[INFO] Execution took", time.c_str());
+	}
+	catch (std::exception &e) {
+		executionError(scriptPosition(script), e.what());
+	}
+
+    closeFiles(file_input, file_output);
+}
+
+void suspendHandler(int signal) {
+	suspend_requested = 1;
+}
+
+void finishExecution(ExecutionState &state, const InterpreterOptions &options) {
+	try {
+		if (options.profile != nullptr) {
+			stopProfiler();
+			writeProfile(options.profile, *state.program);
+		}
+		if (state.trace != nullptr)
+			state.trace->finish();
+	}
+	catch (std::exception &e) {
+		std::string err = "\n[ERROR]: ";
+		err.append(e.what());
+		error(err.c_str());
+	}
+}
+
+void interpretCompiled(std::ifstream &script, std::istream &input, std::ostream &output, uint32_t argc, char *argv[], const InterpreterOptions &options) {
+	CHRONOMETER chronometer = time_now();
+
+	Program program;
+	compileScript(std::string(std::istreambuf_iterator<char>(script), std::istreambuf_iterator<char>()), program);
+
+	// A tiered program is optimized once one of its loops becomes hot, from a copy which is not bound.
+	std::unique_ptr<TieredProgram> tiers;
+	if (options.tiered)
+		tiers.reset(new TieredProgram(program, options.tier_threshold, options.passes));
+
+	// Snapshots contain operation indices, so they are taken from and restored to the program as it was compiled.
+	if (options.optimize && !options.tiered && options.snapshot == nullptr && options.restore == nullptr)
+		optimizeProgram(program, options.cell_bits, options.passes);
+	if (options.dump_ir)
+		program.dump(std::cerr);
+
+	TapeKind tape = options.automatic_tape ? (program.hasWideAddressRange() ? TAPE_PAGED : TAPE_DENSE) : options.tape;
+	bindProgram(program, tape, options.cell_bits, options.tiered);
+
+	std::unique_ptr<ExecutionState> execution = createExecutionState(tape, options.cell_bits);
+	ExecutionState &state = *execution;
+
+	state.input = &input;
+	state.output = &output;
+	state.program = &program;
+	state.tiers = tiers.get();
+
+	// A fork server compiles the script once, and continues in a child for every job, with the arguments of the job.
+	std::vector<std::string> job;
+	std::vector<char*> job_arguments;
+	if (options.fork_server) {
+		// The children inherit the tape, the loop stack and the buffers of STDIN and STDOUT, which are faulted in once.
+		if (tape == TAPE_DENSE) {
+			std::vector<uint8_t> cells(INITIAL_POINTER_CAPACITY * (options.cell_bits / 8));
+			state.setPointer(cells.data(), cells.size());
+		}
+		prepareExecution(state);
+		prefaultStreams();
+
+		bool forked = false;
 		try {
-			if (argc < 1) {
-                pointer.push_back(0);
-            }
-			else {
-				// As numbers.
-				if (strcmp(argv[0], "-n") == 0 || strcmp(argv[0], "-N") == 0) {
-					argc--;
-					argv++;
-
-					pointer.push_back(argc);
-
-					for (uint32_t i = 0; i < argc; ++i)
-						pointer.push_back(atoi(argv[i]));
-				}
-				// As characters.
-				else if (strcmp(argv[0], "-c") == 0 || strcmp(argv[0], "-C") == 0) {
-					argc--;
-					argv++;
-
-					pointer.push_back(argc);
-
-					for (uint32_t i = 0; i < argc; ++i)
-						pointer.push_back(*argv[i]);
-				}
-				// As a string.
-				else if (strcmp(argv[0], "-s") == 0 || strcmp(argv[0], "-S") == 0) {
-					argc--;
-					argv++;
-
-					std::string buffer;
-					for (uint32_t i = 0; i < argc; ++i)
-						buffer.append(argv[i]);
-
-					pointer.push_back(buffer.length());
-
-					for (char c : buffer)
-						pointer.push_back(c);
-				}
-				else throw std::runtime_error(formatString(19u + strlen(argv[0]), "%s '%s'", "Invalid argument", argv[0]));
-			}
+			forked = serveForkJobs(options.limits, job);
 		}
 		catch (std::exception &e) {
 			std::string err = "\n[ERROR]: ";
 			err.append(e.what());
 			error(err.c_str());
 		}
+		if (!forked)
+			return;
 
-		while (script.get(current_char)) {
-			// New line, space and tab.
-			if (current_char == 10 || current_char == 13 || current_char == 32 || current_char == 9 || current_char == 11)
-				continue;
+		for (std::string &argument : job)
+			job_arguments.push_back(const_cast<char*>(argument.c_str()));
+		argc = (uint32_t) job_arguments.size();
+		argv = job_arguments.data();
+		chronometer = time_now();
+	}
+
+	// A memoized execution for the same arguments replaces the whole execution, since it didn't read input.
+	std::string memo;
+	if (options.memoize.directory != nullptr && !writesFiles(program)) {
+		memo = getMemoFile(options.memoize.directory, program, argc, argv, options.cell_bits);
+
+		MemoResult result;
+		if (loadMemo(memo.c_str(), output, result)) {
+			if (result.failed)
+				executionError(result.position, result.error.c_str());
 
-			Instruction i;
-			if (findInstruction(current_char, i))
-				i.execute(POINTER_INFO_PARAMS);
-			else throw std::runtime_error(formatString(23, "%s '%c'", "Invalid instruction", current_char));
+			std::string time = getf_exec_time_ns(chronometer);
+			output << formatString(25 + time.size(), "\n%s %s\n", "[INFO] Execution took", time.c_str());
+			return;
 		}
+	}
 
-        std::string time = getf_exec_time_ns(chronometer);
-		output << formatString(24 + time.size(), "\n%s %s\n", "[INFO] Execution took", time.c_str());
+	// A specialization for the same arguments replaces the execution until the first input.
+	std::string specialization;
+	bool specialized = false;
+	if (options.specialize != nullptr && !writesFiles(program)) {
+		specialization = getSpecializationFile(options.specialize, program, argc, argv, options.cell_bits, options.optimize);
+
+		try {
+			specialized = loadSpecialization(specialization.c_str(), state);
+		}
+		catch (std::exception &e) {
+			std::string err = "\n[ERROR]: ";
+			err.append(e.what());
+			error(err.c_str());
+		}
+	}
+
+	std::unique_ptr<ExecutionTrace> trace;
+	try {
+		if (options.record != nullptr)
+			trace = ExecutionTrace::record(options.record, program, options.cell_bits, argc, argv, options.checkpoint);
+		else if (options.replay != nullptr)
+			trace = ExecutionTrace::replay(options.replay, program, options.cell_bits);
 	}
 	catch (std::exception &e) {
-	    if(script.tellg() == -1) {
-	        script.clear();
-            script.seekg(0, std::ios::end);
-        }
-		std::string err = "\n[ERROR] [Instruction ";
-		err.append(std::to_string(script.tellg()));
-		err.append("]: ");
+		std::string err = "\n[ERROR]: ";
 		err.append(e.what());
 		error(err.c_str());
 	}
+	state.trace = trace.get();
 
-    closeFiles(file_input, file_output);
+	// A replayed trace contains the arguments it was recorded with.
+	std::vector<char*> arguments;
+	if (options.replay != nullptr) {
+		for (const std::string &argument : trace->getArguments())
+			arguments.push_back(const_cast<char*>(argument.c_str()));
+		argc = (uint32_t) arguments.size();
+		argv = arguments.data();
+	}
+
+	// A restored snapshot replaces the data pointer.
+	if (options.restore == nullptr && !specialized)
+		initializeArguments(argc, argv, state);
+
+	if (options.restore != nullptr) {
+		try {
+			loadSnapshot(options.restore, state);
+		}
+		catch (std::exception &e) {
+			std::string err = "\n[ERROR]: ";
+			err.append(e.what());
+			error(err.c_str());
+		}
+	}
+
+	if (options.snapshot != nullptr) {
+		state.suspend_before_input = options.snapshot_before_input;
+
+		signal(SIGTERM, suspendHandler);
+#ifdef SIGUSR1
+		signal(SIGUSR1, suspendHandler);
+#endif
+	}
+
+	prepareExecution(state);
+
+	// The clock counts the input and the output from here on.
+	std::unique_ptr<VirtualClock> clock(options.virtual_clock ? new VirtualClock(state) : nullptr);
+
+	if (options.profile != nullptr) {
+		try {
+			startProfiler(state);
+		}
+		catch (std::exception &e) {
+			std::string err = "\n[ERROR]: ";
+			err.append(e.what());
+			error(err.c_str());
+		}
+	}
+
+	try {
+		PerfCounters counters(options.perf_counters);
+		uint64_t allocations = getAllocationCount();
+		counters.start();
+		if (!specialization.empty() && !specialized) {
+			std::string setup = specializeProgram(state);
+
+			// The execution continues without being cached.
+			try {
+				saveSpecialization(specialization.c_str(), state, setup);
+			}
+			catch (std::exception &e) {
+				std::cerr << "\n[WARNING]: " << e.what() << '\n';
+			}
+		}
+		if (!memo.empty())
+			executeMemoized(state, memo, options.memoize);
+		else if (clock != nullptr)
+			executeProgram(state, *clock);
+		else executeProgram(state);
+		counters.stop();
+		finishExecution(state, options);
+		reportAllocations(output, allocations);
+		counters.report(output, tape == TAPE_PAGED ? "compiled, paged" : "compiled");
+		if (tiers != nullptr)
+			tiers->report(output);
+		if (clock != nullptr)
+			clock->report(output);
+
+		std::string time = getf_exec_time_ns(chronometer);
+		output << formatString(25 + time.size(), "\n%s %s\n", "[INFO] Execution took", time.c_str());
+	}
+	catch (ExecutionSuspended &e) {
+		finishExecution(state, options);
+
+		try {
+			saveSnapshot(options.snapshot, state);
+		}
+		catch (std::exception &e) {
+			std::string err = "\n[ERROR]: ";
+			err.append(e.what());
+			error(err.c_str());
+		}
+		output << "\n[INFO] Snapshot saved to " << options.snapshot << '\n';
+	}
+	catch (ExecutionError &e) {
+		finishExecution(state, options);
+		executionError(e.position, e.what());
+	}
+	catch (std::exception &e) {
+		finishExecution(state, options);
+		executionError(state.program->operations[state.pc].error_position, e.what());
+	}
+
+	closeFiles(state.file_input, state.file_output);
+}
+
+void mapCompiled(std::ifstream &script, std::ostream &output, uint32_t argc, char *argv[], const InterpreterOptions &options) {
+	CHRONOMETER chronometer = time_now();
+
+	Program program;
+	compileScript(std::string(std::istreambuf_iterator<char>(script), std::istreambuf_iterator<char>()), program);
+	if (options.optimize)
+		optimizeProgram(program, options.cell_bits, options.passes);
+	if (options.dump_ir)
+		program.dump(std::cerr);
+
+	MapOptions map = options.map;
+	map.tape = options.automatic_tape ? (program.hasWideAddressRange() ? TAPE_PAGED : TAPE_DENSE) : options.tape;
+	map.cell_bits = options.cell_bits;
+	bindProgram(program, map.tape, map.cell_bits);
+
+	// Every record starts with the data pointer initialized from the arguments.
+	std::vector<uint8_t> initial;
+	{
+		std::unique_ptr<ExecutionState> state = createExecutionState(map.tape, map.cell_bits);
+		initializeArguments(argc, argv, *state);
+		state->getPointer(initial);
+	}
+
+	MapResult result;
+	PerfCounters counters(options.perf_counters);
+	try {
+		counters.start();
+		result = mapRecords(program, initial, map, output, std::cerr);
+		counters.stop();
+	}
+	catch (std::exception &e) {
+		std::string err = "\n[ERROR]: ";
+		err.append(e.what());
+		error(err.c_str());
+	}
+
+	std::string time = getf_exec_time_ns(chronometer);
+	counters.report(output, map.tape == TAPE_PAGED ? "compiled, paged, map" : "compiled, map");
+	output << "\n[INFO] Mapped " << result.records << " records, " << result.failed << " failed\n";
+	output << formatString(25 + time.size(), "%s %s\n", "[INFO] Execution took", time.c_str());
+
+	if (result.failed != 0) {
+		output.flush();
+		exit(EXIT_FAILURE);
+	}
+}
+
+void pipelineCompiled(uint32_t count, char *scripts[], std::istream &input, std::ostream &output, const InterpreterOptions &options) {
+	CHRONOMETER chronometer = time_now();
+
+	// The stages refer to the programs, which don't move once they are all compiled.
+	std::vector<Program> programs(count);
+	std::vector<PipelineStage> stages(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		std::ifstream script;
+		if (!openFile(scripts[i], script))
+			error("[ERROR]: Invalid script file");
+
+		compileScript(std::string(std::istreambuf_iterator<char>(script), std::istreambuf_iterator<char>()), programs[i]);
+		script.close();
+		if (options.optimize)
+			optimizeProgram(programs[i], options.cell_bits, options.passes);
+		if (options.dump_ir)
+			programs[i].dump(std::cerr);
+
+		stages[i].program = &programs[i];
+		stages[i].tape = options.automatic_tape ? (programs[i].hasWideAddressRange() ? TAPE_PAGED : TAPE_DENSE) : options.tape;
+		bindProgram(programs[i], stages[i].tape, options.cell_bits);
+	}
+
+	PerfCounters counters(options.perf_counters);
+	counters.start();
+	PipelineResult result = runPipeline(stages, options.cell_bits, input, output, std::cerr);
+	counters.stop();
+
+	std::string time = getf_exec_time_ns(chronometer);
+	counters.report(output, "compiled, pipeline");
+	output << "\n[INFO] Executed " << count << " stages, " << result.failed << " failed\n";
+	output << formatString(25 + time.size(), "%s %s\n", "[INFO] Execution took", time.c_str());
+
+	if (result.failed != 0) {
+		output.flush();
+		exit(EXIT_FAILURE);
+	}
+}
+
+void executionError(uint32_t position, const char *what) {
+	std::string err = "\n[ERROR] [Instruction ";
+	err.append(std::to_string(position));
+	err.append("]: ");
+	err.append(what);
+	error(err.c_str());
 }
 
 void error(const char *text) {
@@ -202,10 +818,12 @@ std::string formatString(uint16_t count, const char *format, ...) {
 	va_list argp;
 	va_start(argp, format);
 
-	char *buffer = (char*)malloc(count);
-	vsprintf(buffer, format, argp);
+	std::string buffer(count, '\0');
+	int length = vsnprintf(&buffer[0], count, format, argp);
+	va_end(argp);
 
-	return std::string(buffer);
+	buffer.resize(length < 0 ? 0 : std::min<size_t>(length, count > 0 ? count - 1u : 0u));
+	return buffer;
 }
 
 bool openFile(const char* file, std::ifstream &script) {
@@ -229,4 +847,5 @@ void closeFiles(std::ifstream *&file_input, std::ofstream *&file_output) {
         delete file_output;
         file_output = nullptr;
     }
-}
\ No newline at end of file
+}
+
@@ -0,0 +1,97 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "mapped_file.h"
+
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define X10_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() {
+	contents = nullptr;
+	length = 0;
+	mapped = false;
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::open(const char *file) {
+	close();
+
+#ifdef X10_MMAP
+	int fd = ::open(file, O_RDONLY);
+	if (fd == -1)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+		length = (size_t) info.st_size;
+
+		if (length == 0) {
+			::close(fd);
+			contents = buffer.data();
+			return true;
+		}
+
+		void *address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+
+		if (address != MAP_FAILED) {
+			contents = (const uint8_t*) address;
+			mapped = true;
+			return true;
+		}
+	}
+	else ::close(fd);
+#endif
+
+	// Not mappable (e.g. a pipe), so read it.
+	std::ifstream stream(file, std::ios::binary);
+	if (stream.fail())
+		return false;
+
+	buffer.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	contents = buffer.data();
+	length = buffer.size();
+	return true;
+}
+
+void MappedFile::close() {
+#ifdef X10_MMAP
+	if (mapped)
+		munmap((void*) contents, length);
+#endif
+
+	contents = nullptr;
+	length = 0;
+	mapped = false;
+	buffer.clear();
+}
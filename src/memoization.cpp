@@ -0,0 +1,297 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "memoization.h"
+#include "execution_key.h"
+#include "hash.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#ifdef __linux__
+#define X10_SENDFILE
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#endif
+
+/// The size of the header of a memoized execution: the magic, the version, whether it failed, the position and the length of the error, and the length of the output.
+#define MEMO_HEADER_SIZE 28
+
+/// Forwards the output of an execution to another buffer, and keeps a copy of it until it grows past a limit.
+class MemoBuffer : public std::streambuf {
+	public:
+		MemoBuffer(std::streambuf *target, uint64_t limit) : target(target), limit(limit), complete(true) {
+			setp(buffer, buffer + sizeof(buffer));
+		}
+
+		/// Whether the whole output was kept.
+		bool isComplete() const { return complete; }
+		/// The output which was kept.
+		const std::string &getOutput() const { return output; }
+
+	protected:
+		int overflow(int c) override {
+			if (!forward())
+				return EOF;
+			if (c != EOF) {
+				*pptr() = (char) c;
+				pbump(1);
+			}
+			return c == EOF ? 0 : c;
+		}
+
+		int sync() override {
+			return forward() && target->pubsync() == 0 ? 0 : -1;
+		}
+
+	private:
+		std::streambuf *target;
+		uint64_t limit;
+		bool complete;
+		std::string output;
+		char buffer[MEMO_BUFFER_SIZE];
+
+		/// Forwards the buffered output, and keeps a copy of it.
+		bool forward() {
+			size_t size = (size_t) (pptr() - pbase());
+			if (complete && output.size() + size <= limit)
+				output.append(pbase(), size);
+			else { // Too large to be memoized.
+				complete = false;
+				std::string().swap(output);
+			}
+
+			setp(buffer, buffer + sizeof(buffer));
+			return target->sputn(buffer, (std::streamsize) size) == (std::streamsize) size;
+		}
+};
+
+std::string getMemoFile(const std::string &directory, const Program &program, uint32_t argc, char *argv[], uint8_t cell_bits) {
+	// Executions are not shared between builds of the interpreter.
+	return getExecutionKeyFile(directory, hashExecutionKey(MEMO_VERSION, program, argc, argv, cell_bits), MEMO_EXTENSION);
+}
+
+/**
+ * Writes a range of a file to STDOUT with sendfile(), which copies it inside the kernel.
+ *
+ * @param file The file.
+ * @param offset The offset of the range.
+ * @param length The length of the range.
+ *
+ * @return True, if the range was written. False, if nothing was written and the range can be written otherwise.
+ */
+static bool sendOutput(const char *file, size_t offset, size_t length) {
+#ifdef X10_SENDFILE
+	int fd = open(file, O_RDONLY);
+	if (fd == -1)
+		return false;
+
+	off_t position = (off_t) offset;
+	size_t sent = 0;
+	while (sent < length) {
+		ssize_t count = sendfile(STDOUT_FILENO, fd, &position, length - sent);
+		if (count <= 0)
+			break;
+		sent += (size_t) count;
+	}
+
+	close(fd);
+	return sent != 0 || length == 0;
+#else
+	return false;
+#endif
+}
+
+bool loadMemo(const char *file, std::ostream &output, MemoResult &result) {
+	MappedFile memo;
+	if (!memo.open(file))
+		return false;
+
+	const uint8_t *data = memo.data();
+	size_t size = memo.size();
+	uint32_t version, failed, error_length;
+	uint64_t length;
+
+	if (size < MEMO_HEADER_SIZE || memcmp(data, MEMO_MAGIC, 4) != 0)
+		return false;
+	memcpy(&version, data + 4, sizeof(version));
+	memcpy(&failed, data + 8, sizeof(failed));
+	memcpy(&result.position, data + 12, sizeof(result.position));
+	memcpy(&error_length, data + 16, sizeof(error_length));
+	memcpy(&length, data + 20, sizeof(length));
+	if (version != MEMO_VERSION || error_length > size - MEMO_HEADER_SIZE || length != size - MEMO_HEADER_SIZE - error_length)
+		return false;
+
+	result.failed = failed != 0;
+	result.error.assign((const char*) data + MEMO_HEADER_SIZE, error_length);
+
+	// The modification time orders the executions from the least recently used one.
+	std::error_code error;
+	std::filesystem::last_write_time(file, std::filesystem::file_time_type::clock::now(), error);
+
+	size_t offset = MEMO_HEADER_SIZE + error_length;
+	if (output.rdbuf() == std::cout.rdbuf()) {
+		output.flush();
+		fflush(stdout);
+		if (sendOutput(file, offset, (size_t) length))
+			return true;
+	}
+	output.write((const char*) data + offset, (std::streamsize) length);
+	return true;
+}
+
+/**
+ * Removes the least recently used executions of a directory, until the size of the executions is within a limit.
+ *
+ * @param directory The directory of the memoized executions.
+ * @param limit The size limit.
+ */
+static void trimMemos(const std::filesystem::path &directory, uint64_t limit) {
+	struct Memo {
+		std::filesystem::file_time_type time;
+		uint64_t size;
+		std::filesystem::path path;
+	};
+
+	std::vector<Memo> memos;
+	uint64_t total = 0;
+	std::error_code error;
+
+	for (std::filesystem::directory_iterator i(directory, error), end; !error && i != end; i.increment(error)) {
+		if (i->path().extension() != MEMO_EXTENSION)
+			continue;
+
+		std::error_code entry_error;
+		Memo memo = { i->last_write_time(entry_error), 0, i->path() };
+		memo.size = i->file_size(entry_error);
+		if (entry_error)
+			continue; // Removed by another execution.
+
+		total += memo.size;
+		memos.push_back(memo);
+	}
+
+	if (total <= limit)
+		return;
+
+	std::sort(memos.begin(), memos.end(), [](const Memo &a, const Memo &b) { return a.time < b.time; });
+	for (size_t i = 0; i < memos.size() && total > limit; ++i) {
+		std::error_code entry_error;
+		std::filesystem::remove(memos[i].path, entry_error);
+		total -= memos[i].size;
+	}
+}
+
+/**
+ * Writes a memoized execution. The execution is written to a temporary file first, which then replaces the file.
+ * Failures are ignored, since executions are only memoized to speed up the next ones.
+ *
+ * @param file The memoized execution file.
+ * @param output The output of the execution.
+ * @param failed Whether the execution raised an error.
+ * @param position The position of the error.
+ * @param message The error.
+ * @param options The memoization options.
+ */
+static void saveMemo(const std::string &file, const std::string &output, bool failed, uint32_t position, const std::string &message,
+                     const MemoOptions &options) {
+	if (MEMO_HEADER_SIZE + message.size() + output.size() > options.size)
+		return;
+
+	std::error_code error;
+	std::filesystem::create_directories(options.directory, error);
+
+	// Concurrent executions write the same file, so each one writes its own temporary file.
+	std::string temporary = file + ".tmp" + std::to_string(std::random_device()());
+	std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+	if (stream.fail())
+		return;
+
+	uint32_t version = MEMO_VERSION, fail = failed ? 1 : 0, error_length = (uint32_t) message.size();
+	uint64_t length = output.size();
+	stream.write(MEMO_MAGIC, 4);
+	stream.write((const char*) &version, sizeof(version));
+	stream.write((const char*) &fail, sizeof(fail));
+	stream.write((const char*) &position, sizeof(position));
+	stream.write((const char*) &error_length, sizeof(error_length));
+	stream.write((const char*) &length, sizeof(length));
+	stream.write(message.data(), message.size());
+	stream.write(output.data(), output.size());
+
+	stream.close();
+	if (stream.fail()) {
+		std::filesystem::remove(temporary, error);
+		return;
+	}
+
+	std::filesystem::rename(temporary, file, error);
+	if (error)
+		std::filesystem::remove(temporary, error);
+	else trimMemos(options.directory, options.size);
+}
+
+void executeMemoized(ExecutionState &state, const std::string &file, const MemoOptions &options) {
+	std::ostream *output = state.output;
+	MemoBuffer buffer(output->rdbuf(), options.size);
+	std::ostream memo(&buffer);
+
+	state.output = &memo;
+	state.suspend_before_input = true;
+
+	auto restore = [&]() {
+		memo.flush();
+		state.output = output;
+		state.suspend_before_input = false;
+	};
+
+	try {
+		executeProgram(state);
+	}
+	catch (ExecutionSuspended &e) {
+		// The program reads input next, so it continues without being memoized.
+		restore();
+		executeProgram(state);
+		return;
+	}
+	catch (ExecutionError &e) {
+		restore();
+		if (buffer.isComplete())
+			saveMemo(file, buffer.getOutput(), true, e.position, e.what(), options);
+		throw;
+	}
+	catch (...) {
+		restore();
+		throw;
+	}
+
+	restore();
+	if (buffer.isComplete())
+		saveMemo(file, buffer.getOutput(), false, 0, std::string(), options);
+}
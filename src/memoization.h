@@ -0,0 +1,96 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef X10_MEMOIZATION_H
+#define X10_MEMOIZATION_H
+
+#include "engine.h"
+
+#include <string>
+
+/// The first bytes of a memoized execution file.
+#define MEMO_MAGIC "X10M"
+/// The version of the memoized execution format.
+#define MEMO_VERSION 1u
+/// The extension of memoized execution files.
+#define MEMO_EXTENSION ".x10m"
+/// The default size limit of the memoized executions of a directory, in bytes.
+#define MEMO_CACHE_SIZE (64ull << 20)
+/// The size of the buffer through which the output of a memoized execution is captured.
+#define MEMO_BUFFER_SIZE 4096
+
+/// Where to memoize executions which don't read input, and how much to keep.
+struct MemoOptions {
+	/// The directory of the memoized executions, if any.
+	const char *directory = nullptr;
+	/// The size limit of the directory. The least recently used executions are removed when it is exceeded.
+	uint64_t size = MEMO_CACHE_SIZE;
+};
+
+/// The result of a memoized execution.
+struct MemoResult {
+	/// Whether the execution raised an error.
+	bool failed = false;
+	/// The position of the error.
+	uint32_t position = 0;
+	/// The error.
+	std::string error;
+};
+
+/**
+ * Gets the file which contains the memoized execution of a script for a set of arguments.
+ * The name of the file is the hash of the script, the arguments, the cell width and the interpreter executable.
+ *
+ * @param directory The directory of the memoized executions.
+ * @param program The compiled script.
+ * @param argc The amount of arguments which initialize the data pointer.
+ * @param argv The arguments which initialize the data pointer.
+ * @param cell_bits The width of the cells.
+ *
+ * @return The path of the memoized execution file.
+ */
+std::string getMemoFile(const std::string &directory, const Program &program, uint32_t argc, char *argv[], uint8_t cell_bits);
+/**
+ * Writes the output of a memoized execution, if there is one, and marks it as recently used.
+ * When the output is STDOUT, it is sent straight from the file with sendfile() where supported.
+ *
+ * @param file The memoized execution file.
+ * @param output The output.
+ * @param result The variable which will contain the result of the execution.
+ *
+ * @return True, if the execution was memoized. False, if the file doesn't exist or is invalid.
+ */
+bool loadMemo(const char *file, std::ostream &output, MemoResult &result);
+/**
+ * Executes a program, and memoizes its output and its result if it ends without reading input.
+ * Executions which read input continue as usual, from the input instruction.
+ *
+ * @param state The execution state, which is initialized from the arguments.
+ * @param file The memoized execution file.
+ * @param options The memoization options.
+ *
+ * @throws ExecutionError If the program raises an error, which is memoized as well.
+ */
+void executeMemoized(ExecutionState &state, const std::string &file, const MemoOptions &options);
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef X10_OPERATORS_H
+#define X10_OPERATORS_H
+
+#include "definitions.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+// Operators are also applied to SIMD vectors, by functions compiled for other instruction sets.
+// They must be inlined there, since vectors aren't passed the same way between instruction sets.
+#ifdef __GNUC__
+#define OPERATOR_INLINE inline __attribute__((always_inline))
+#else
+#define OPERATOR_INLINE inline
+#endif
+
+/**
+ * Applies a VALUE_OPERATION operator to a value.
+ * This is the single definition of the operators, shared by every execution engine.
+ *
+ * @tparam OPERATOR The operator to apply (see OPERATOR_*).
+ * @tparam Cell The type of the value.
+ * @param value The value on which the operation is executed.
+ * @param operand The [NUM] operand of the operation.
+ *
+ * @return The result of the operation.
+ */
+template<char OPERATOR, typename Cell>
+OPERATOR_INLINE Cell applyOperator(Cell value, Cell operand) {
+	// Cells narrower than unsigned are promoted to int, which can overflow when multiplied.
+	typedef typename std::conditional<(sizeof(Cell) < sizeof(unsigned)), unsigned, Cell>::type Arithmetic;
+
+	if constexpr (OPERATOR == OPERATOR_SET)
+		return operand;
+	else if constexpr (OPERATOR == OPERATOR_ADD)
+		return value + operand;
+	else if constexpr (OPERATOR == OPERATOR_SUBTRACT)
+		return value - operand;
+	else if constexpr (OPERATOR == OPERATOR_MULTIPLY)
+		return (Arithmetic) value * operand;
+	else if constexpr (OPERATOR == OPERATOR_DIVIDE)
+		return value / operand;
+	else if constexpr (OPERATOR == OPERATOR_MODULO)
+		return value % operand;
+	else if constexpr (OPERATOR == OPERATOR_XOR)
+		return value ^ operand;
+	else if constexpr (OPERATOR == OPERATOR_AND)
+		return value & operand;
+	else {
+		static_assert(OPERATOR == OPERATOR_OR, "Invalid operator");
+		return value | operand;
+	}
+}
+
+/**
+ * Checks whether a character is a VALUE_OPERATION operator.
+ *
+ * @param op The character to check.
+ *
+ * @return True, if the character is an operator. False otherwise.
+ */
+inline bool isOperator(char op) {
+	switch (op) {
+		case OPERATOR_SET:
+		case OPERATOR_ADD:
+		case OPERATOR_SUBTRACT:
+		case OPERATOR_MULTIPLY:
+		case OPERATOR_DIVIDE:
+		case OPERATOR_MODULO:
+		case OPERATOR_XOR:
+		case OPERATOR_AND:
+		case OPERATOR_OR:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/**
+ * Applies a VALUE_OPERATION operator, which is only known at runtime, to a value.
+ *
+ * @param op The operator to apply (see OPERATOR_*).
+ * @param value The value on which the operation is executed.
+ * @param operand The [NUM] operand of the operation.
+ *
+ * @return The result of the operation.
+ */
+inline uint8_t applyOperator(char op, uint8_t value, uint8_t operand) {
+	switch (op) {
+		case OPERATOR_SET: return applyOperator<OPERATOR_SET>(value, operand);
+		case OPERATOR_ADD: return applyOperator<OPERATOR_ADD>(value, operand);
+		case OPERATOR_SUBTRACT: return applyOperator<OPERATOR_SUBTRACT>(value, operand);
+		case OPERATOR_MULTIPLY: return applyOperator<OPERATOR_MULTIPLY>(value, operand);
+		case OPERATOR_DIVIDE: return applyOperator<OPERATOR_DIVIDE>(value, operand);
+		case OPERATOR_MODULO: return applyOperator<OPERATOR_MODULO>(value, operand);
+		case OPERATOR_XOR: return applyOperator<OPERATOR_XOR>(value, operand);
+		case OPERATOR_AND: return applyOperator<OPERATOR_AND>(value, operand);
+		case OPERATOR_OR: return applyOperator<OPERATOR_OR>(value, operand);
+		default: throw std::runtime_error("Invalid operator");
+	}
+}
+
+#endif
@@ -0,0 +1,1032 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "optimizer.h"
+#include "operators.h"
+
+#include "timerh/timer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+/// What is known about the execution state before an operation.
+struct KnownState {
+	/// Whether the operation can be reached.
+	bool reachable = false;
+	/// Whether the index is known.
+	bool index_known = false;
+	/// The index, if known.
+	uint32_t index = 0;
+	/// The known values, by index.
+	std::map<uint32_t, uint64_t> cells;
+
+	/**
+	 * Merges the state of another path into this one. Only what is known on both paths stays known.
+	 *
+	 * @param other The state of the other path.
+	 *
+	 * @return True, if this state changed. False otherwise.
+	 */
+	bool merge(const KnownState &other) {
+		if (!other.reachable)
+			return false;
+		if (!reachable) {
+			*this = other;
+			return true;
+		}
+
+		bool changed = false;
+		if (index_known && (!other.index_known || other.index != index)) {
+			index_known = false;
+			changed = true;
+		}
+		for (auto cell = cells.begin(); cell != cells.end();) {
+			auto match = other.cells.find(cell->first);
+			if (match == other.cells.end() || match->second != cell->second) {
+				cell = cells.erase(cell);
+				changed = true;
+			}
+			else ++cell;
+		}
+		return changed;
+	}
+
+	/**
+	 * Records that a cell was written. Known cells exist, since writing a cell which doesn't exist raises an error.
+	 *
+	 * @param known Whether the index of the cell is known.
+	 * @param cell The index of the cell.
+	 * @param value_known Whether the value is known.
+	 * @param value The value.
+	 */
+	void write(bool known, uint32_t cell, bool value_known, uint64_t value) {
+		if (!known) {
+			cells.clear(); // Any cell may have been written.
+			return;
+		}
+		if (value_known)
+			cells[cell] = value;
+		else cells.erase(cell);
+	}
+};
+
+/// The state of the optimization.
+class Optimizer {
+	public:
+		Optimizer(Program &program, uint8_t cell_bits, std::vector<uint32_t> *moved) : program(program), states(program.operations.size() + 2), relocations(moved) {
+			cell_mask = cell_bits >= 64 ? UINT64_MAX : (1ull << cell_bits) - 1;
+			value_mask = cell_bits > 32 ? UINT64_MAX : UINT32_MAX;
+
+			loop_repeat = (uint32_t) program.operations.size() + 1;
+			for (uint32_t pc = 0; pc < program.operations.size(); ++pc)
+				if (program.operations[pc].code == OPCODE_LOOP_START)
+					loop_starts.push_back(pc);
+		}
+
+		/// Computes the known state before every operation.
+		void analyze();
+		/// Folds the operations whose outcome is known, and propagates known values into operands.
+		void fold();
+		/// Removes the value operations which always leave their cell with the value it already has.
+		void removeRedundantStores();
+		/// Replaces the OUTPUT_WRITE operations whose output is known with OUTPUT_TEXT, joining the ones which are only
+		/// separated by index operations.
+		void foldOutput();
+		/// Removes the operations which can't be reached.
+		void removeUnreachable();
+		/**
+		 * Replaces every counted loop with a counted loop whose body is copied, followed by the original loop.
+		 *
+		 * @param factor The amount of copies of the body.
+		 */
+		void unrollLoops(uint32_t factor);
+
+	private:
+		Program &program;
+		/// The known state before every operation, followed by the state at the end of the program and the state at loop_repeat.
+		std::vector<KnownState> states;
+		/// The bits of a cell.
+		uint64_t cell_mask;
+		/// The bits of the type in which operands are evaluated (see Value in engine.cpp).
+		uint64_t value_mask;
+		/// The LOOP_START operations.
+		std::vector<uint32_t> loop_starts;
+		/// The node where every LOOP_END merges its state before repeating a loop. Loops are matched at runtime,
+		/// so a LOOP_END may repeat any loop; merging them once keeps the analysis linear in the amount of loops.
+		uint32_t loop_repeat;
+		/// The operation to which every operation of the unoptimized program moved, if needed.
+		std::vector<uint32_t> *relocations;
+
+		bool evaluateOperand(const KnownState &state, uint32_t id, uint64_t &value) const;
+		bool evaluateCondition(const KnownState &state, uint32_t id, bool &result, uint32_t &stop) const;
+		bool decideBranch(const KnownState &state, const Operation &operation, bool &result, uint32_t &next) const;
+		void execute(KnownState &state, const Operation &operation) const;
+		void successors(uint32_t pc, const KnownState &state, std::vector<uint32_t> &next) const;
+		bool fitsConstant(uint64_t value) const;
+		uint32_t addConstant(uint64_t value, uint32_t position);
+		bool formatOutput(const KnownState &state, const Operation &operation, std::string &text) const;
+		bool findCountedLoop(uint32_t start, uint32_t &end, CountedLoop &loop) const;
+		void removeOperations(const std::vector<bool> &kept);
+		void relocate(const std::vector<uint32_t> &moved);
+};
+
+/**
+ * Evaluates an operand, like evaluateOperand() in the engine does, if its value is known.
+ *
+ * @param state The known state.
+ * @param id The index of the operand.
+ * @param value The variable which will contain the value.
+ *
+ * @return True, if the value is known. False otherwise.
+ */
+bool Optimizer::evaluateOperand(const KnownState &state, uint32_t id, uint64_t &value) const {
+	const Operand &operand = program.operands[id];
+	uint64_t number = (uint64_t) (int64_t) (int32_t) operand.number & value_mask;
+	uint64_t nested = 0;
+
+	switch (operand.type) {
+		case OPERAND_NESTED:
+		case OPERAND_INDEX_PLUS_NESTED:
+		case OPERAND_INDEX_MINUS_NESTED:
+		case OPERAND_CELL_AT_NESTED:
+		case OPERAND_CELL_AT_INDEX_PLUS_NESTED:
+		case OPERAND_CELL_AT_INDEX_MINUS_NESTED:
+			if (!evaluateOperand(state, operand.nested, nested))
+				return false;
+			break;
+		default:
+			break;
+	}
+
+	uint64_t cell;
+	switch (operand.type) {
+		case OPERAND_CONSTANT:
+			value = number;
+			break;
+		case OPERAND_INDEX:
+			if (!state.index_known)
+				return false;
+			value = (state.index + number) & value_mask;
+			break;
+		case OPERAND_NESTED:
+			value = nested;
+			break;
+		case OPERAND_INDEX_PLUS_NESTED:
+		case OPERAND_INDEX_MINUS_NESTED:
+			if (!state.index_known)
+				return false;
+			value = (operand.type == OPERAND_INDEX_PLUS_NESTED ? state.index + nested : state.index - nested) & value_mask;
+			break;
+		case OPERAND_CELL:
+		case OPERAND_RELATIVE_CELL:
+		case OPERAND_CELL_AT_NESTED:
+		case OPERAND_CELL_AT_INDEX_PLUS_NESTED:
+		case OPERAND_CELL_AT_INDEX_MINUS_NESTED: {
+			if (operand.type == OPERAND_CELL)
+				cell = operand.number;
+			else if (operand.type == OPERAND_CELL_AT_NESTED)
+				cell = nested;
+			else if (!state.index_known)
+				return false;
+			else if (operand.type == OPERAND_RELATIVE_CELL)
+				cell = (uint32_t) (state.index + operand.number);
+			else cell = (operand.type == OPERAND_CELL_AT_INDEX_PLUS_NESTED ? state.index + nested : state.index - nested) & value_mask;
+
+			auto known = cell <= UINT32_MAX ? state.cells.find((uint32_t) cell) : state.cells.end();
+			if (known == state.cells.end())
+				return false;
+			value = known->second;
+			break;
+		}
+		default:
+			return false; // Traps raise their error.
+	}
+
+	value = (operand.negative ? 0 - value : value) & value_mask & cell_mask;
+	return true;
+}
+
+/**
+ * Evaluates an expression, like evaluateCondition() in the engine does, if its value is known.
+ *
+ * @param state The known state.
+ * @param id The index of the expression.
+ * @param result The variable which will contain the value of the expression.
+ * @param stop The variable which will contain the expression whose AND skipped the rest, if any.
+ *
+ * @return True, if the value is known. False otherwise.
+ */
+bool Optimizer::evaluateCondition(const KnownState &state, uint32_t id, bool &result, uint32_t &stop) const {
+	const Condition &condition = program.conditions[id];
+	uint64_t left, right;
+
+	if (condition.relation == RELATION_INVALID || !evaluateOperand(state, condition.left, left) || !evaluateOperand(state, condition.right, right))
+		return false;
+
+	bool expression;
+	switch (condition.relation) {
+		case RELATION_EQUAL: expression = left == right; break;
+		case RELATION_NOT_EQUAL: expression = left != right; break;
+		case RELATION_GREATER_THAN: expression = left > right; break;
+		case RELATION_GREATER_THAN_OR_EQUAL: expression = left >= right; break;
+		case RELATION_LESS_THAN: expression = left < right; break;
+		default: expression = left <= right; break;
+	}
+
+	bool next;
+	switch (condition.conjunction) {
+		case CONJUNCTION_AND:
+			if (!expression) {
+				stop = id;
+				result = false;
+				return true;
+			}
+			return evaluateCondition(state, condition.next, result, stop);
+		case CONJUNCTION_OR:
+			if (!evaluateCondition(state, condition.next, next, stop))
+				return false;
+			result = next || expression;
+			return true;
+		case CONJUNCTION_XOR:
+			if (!evaluateCondition(state, condition.next, next, stop))
+				return false;
+			result = expression != next;
+			return true;
+		default:
+			result = expression;
+			return true;
+	}
+}
+
+/**
+ * Decides where an UNCERTAINTY_START or a LOOP_START continues, if its expression is known.
+ *
+ * @param state The known state before the operation.
+ * @param operation The operation.
+ * @param result The variable which will contain the value of the expression.
+ * @param next The variable which will contain the operation executed next.
+ *
+ * @return True, if the expression is known. False otherwise.
+ */
+bool Optimizer::decideBranch(const KnownState &state, const Operation &operation, bool &result, uint32_t &next) const {
+	uint32_t stop = UINT32_MAX;
+	if (!evaluateCondition(state, operation.argument, result, stop))
+		return false;
+
+	uint32_t pc = (uint32_t) (&operation - program.operations.data());
+	if (stop == UINT32_MAX)
+		next = result ? pc + 1 : operation.target;
+	else next = result ? program.conditions[stop].short_target : program.conditions[stop].short_skip;
+	return true;
+}
+
+/**
+ * Updates the known state after an operation, assuming it doesn't raise an error.
+ *
+ * @param state The known state.
+ * @param operation The operation.
+ */
+void Optimizer::execute(KnownState &state, const Operation &operation) const {
+	uint64_t value = 0, operand = 0;
+	auto current = state.index_known ? state.cells.find(state.index) : state.cells.end();
+	bool known = current != state.cells.end();
+
+	switch (operation.code) {
+		case OPCODE_VALUE_INCREMENT:
+		case OPCODE_VALUE_DECREMENT:
+			if (known)
+				value = (current->second + (operation.code == OPCODE_VALUE_INCREMENT ? 1 : cell_mask)) & cell_mask;
+			state.write(state.index_known, state.index, known, value);
+			break;
+		case OPCODE_VALUE_OPERATION: {
+			if (!isOperator(operation.modifier))
+				break; // Raises an error.
+
+			bool target_known = state.index_known;
+			uint64_t target = state.index;
+
+			if (operation.target_form != TARGET_CURRENT) {
+				// Targets past the highest index raise an error, after which nothing is executed.
+				target_known = evaluateOperand(state, operation.target, target) && target < UINT32_MAX;
+				current = target_known ? state.cells.find((uint32_t) target) : state.cells.end();
+				known = current != state.cells.end();
+			}
+
+			bool operand_known = evaluateOperand(state, operation.argument, operand);
+			bool value_known = operand_known && (operation.modifier == OPERATOR_SET || known);
+
+			if (value_known && operation.modifier != OPERATOR_SET) {
+				uint64_t old = current->second;
+				switch (operation.modifier) {
+					case OPERATOR_ADD: value = old + operand; break;
+					case OPERATOR_SUBTRACT: value = old - operand; break;
+					case OPERATOR_MULTIPLY: value = old * operand; break;
+					case OPERATOR_DIVIDE:
+					case OPERATOR_MODULO:
+						if (operand == 0)
+							value_known = false; // The division raises its own error.
+						else value = operation.modifier == OPERATOR_DIVIDE ? old / operand : old % operand;
+						break;
+					case OPERATOR_XOR: value = old ^ operand; break;
+					case OPERATOR_AND: value = old & operand; break;
+					default: value = old | operand; break;
+				}
+			}
+			else value = operand;
+
+			state.write(target_known, (uint32_t) target, value_known, value & cell_mask);
+			break;
+		}
+		case OPCODE_INDEX_INCREMENT:
+			++state.index;
+			break;
+		case OPCODE_INDEX_DECREMENT:
+			--state.index;
+			break;
+		case OPCODE_INPUT_READ:
+		case OPCODE_INPUT_ADD:
+		case OPCODE_INPUT_XOR:
+		case OPCODE_INPUT_AND:
+		case OPCODE_INPUT_OR:
+			state.write(state.index_known, state.index, false, 0);
+			break;
+		case OPCODE_BULK_READ:
+		case OPCODE_MEMORY_FILL:
+		case OPCODE_MEMORY_MOVE:
+			state.write(false, 0, false, 0); // A range of cells.
+			break;
+		case OPCODE_MEMORY_COMPARE: {
+			uint64_t target = 0;
+			bool target_known = evaluateOperand(state, operation.target_value, target) && target < UINT32_MAX;
+			state.write(target_known, (uint32_t) target, false, 0);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+/**
+ * Gets the operations which can be executed after an operation.
+ *
+ * @param pc The index of the operation.
+ * @param state The known state before the operation.
+ * @param next The variable which will contain the operations.
+ */
+void Optimizer::successors(uint32_t pc, const KnownState &state, std::vector<uint32_t> &next) const {
+	next.clear();
+
+	if (pc == loop_repeat) {
+		for (uint32_t start : loop_starts) {
+			if (!states[start].reachable)
+				continue;
+
+			next.push_back(start + 1);
+			for (uint32_t id = program.operations[start].argument;; id = program.conditions[id].next) {
+				const Condition &condition = program.conditions[id];
+				if (condition.conjunction == CONJUNCTION_AND)
+					next.push_back(condition.short_target);
+				if (condition.conjunction == CONJUNCTION_NONE)
+					break;
+			}
+		}
+		return;
+	}
+
+	const Operation &operation = program.operations[pc];
+
+	switch (operation.code) {
+		case OPCODE_HALT:
+		case OPCODE_TRAP:
+			break;
+		case OPCODE_JUMP:
+		case OPCODE_UNCERTAINTY_ENTER:
+			next.push_back(operation.target);
+			break;
+		case OPCODE_UNCERTAINTY_START:
+		case OPCODE_LOOP_START: {
+			bool result;
+			uint32_t decided;
+
+			if (decideBranch(state, operation, result, decided)) {
+				next.push_back(decided);
+				break;
+			}
+
+			next.push_back(pc + 1);
+			next.push_back(operation.target);
+			for (uint32_t id = operation.argument;; id = program.conditions[id].next) {
+				const Condition &condition = program.conditions[id];
+				if (condition.conjunction == CONJUNCTION_AND) {
+					next.push_back(condition.short_target);
+					next.push_back(condition.short_skip);
+				}
+				if (condition.conjunction == CONJUNCTION_NONE)
+					break;
+			}
+			break;
+		}
+		case OPCODE_LOOP_END:
+			next.push_back(pc + 1);
+			next.push_back(loop_repeat);
+			break;
+		case OPCODE_COUNTED_LOOP_START:
+			next.push_back(pc + 1);
+			next.push_back(operation.target);
+			next.push_back(program.operations[operation.target].target);
+			break;
+		case OPCODE_COUNTED_LOOP_END:
+			next.push_back(pc + 1);
+			next.push_back(operation.target);
+			break;
+		default:
+			next.push_back(pc + 1);
+			break;
+	}
+}
+
+void Optimizer::analyze() {
+	std::vector<uint32_t> worklist, next;
+	std::vector<bool> queued(states.size(), false);
+
+	states[0].reachable = true;
+	states[0].index_known = true;
+	worklist.push_back(0);
+	queued[0] = true;
+
+	while (!worklist.empty()) {
+		uint32_t pc = worklist.back();
+		worklist.pop_back();
+		queued[pc] = false;
+
+		if (pc == program.operations.size())
+			continue;
+
+		KnownState state = states[pc];
+		successors(pc, state, next);
+		if (pc != loop_repeat)
+			execute(state, program.operations[pc]);
+
+		for (uint32_t successor : next) {
+			if (successor >= states.size())
+				continue;
+
+			bool reached = states[successor].reachable;
+			if (!states[successor].merge(state) || queued[successor])
+				continue;
+
+			worklist.push_back(successor);
+			queued[successor] = true;
+
+			// A loop which is reached for the first time can be repeated by every LOOP_END.
+			if (!reached && successor < program.operations.size() && program.operations[successor].code == OPCODE_LOOP_START &&
+			    states[loop_repeat].reachable && !queued[loop_repeat]) {
+				worklist.push_back(loop_repeat);
+				queued[loop_repeat] = true;
+			}
+		}
+	}
+}
+
+/**
+ * Checks whether a value is compiled to the same constant, since numbers are compiled to 32 bits and sign-extended.
+ *
+ * @param value The value.
+ *
+ * @return True, if the value can be a constant. False otherwise.
+ */
+bool Optimizer::fitsConstant(uint64_t value) const {
+	return value_mask == UINT32_MAX || (int64_t) value == (int64_t) (int32_t) (uint32_t) value;
+}
+
+/**
+ * Adds a constant operand.
+ *
+ * @param value The value of the operand.
+ * @param position The position reported by the operand.
+ *
+ * @return The index of the operand.
+ */
+uint32_t Optimizer::addConstant(uint64_t value, uint32_t position) {
+	Operand operand;
+	operand.type = OPERAND_CONSTANT;
+	operand.negative = false;
+	operand.number = (uint32_t) value; // Truncated to the cell width when executed, like every constant.
+	operand.nested = 0;
+	operand.position = position;
+
+	program.operands.push_back(operand);
+	return (uint32_t) program.operands.size() - 1;
+}
+
+void Optimizer::fold() {
+	for (uint32_t pc = 0; pc < program.operations.size(); ++pc) {
+		Operation &operation = program.operations[pc];
+		const KnownState &state = states[pc];
+		if (!state.reachable)
+			continue;
+
+		bool result;
+		uint32_t next;
+		uint64_t value;
+
+		switch (operation.code) {
+			case OPCODE_UNCERTAINTY_START:
+				if (decideBranch(state, operation, result, next)) {
+					operation.code = result ? OPCODE_UNCERTAINTY_ENTER : OPCODE_JUMP;
+					operation.target = next;
+				}
+				break;
+			case OPCODE_LOOP_START:
+				// Only the first evaluation is known; the expression is evaluated again by LOOP_END.
+				if (decideBranch(state, operation, result, next) && !result) {
+					operation.code = OPCODE_JUMP;
+					operation.target = next;
+				}
+				break;
+			case OPCODE_VALUE_OPERATION: {
+				if (!isOperator(operation.modifier))
+					break;
+
+				if (operation.target_form != TARGET_CURRENT && program.operands[operation.target].type != OPERAND_CONSTANT &&
+				    evaluateOperand(state, operation.target, value) && value < UINT32_MAX && fitsConstant(value))
+					operation.target = addConstant(value, program.operands[operation.target].position);
+
+				// Padding the data pointer for the target doesn't change the known cells, so the operand is evaluated in the same state.
+				if (program.operands[operation.argument].type != OPERAND_CONSTANT && evaluateOperand(state, operation.argument, value) && fitsConstant(value))
+					operation.argument = addConstant(value, program.operands[operation.argument].position);
+				break;
+			}
+			default:
+				break;
+		}
+	}
+}
+
+void Optimizer::removeUnreachable() {
+	std::vector<Operation> &operations = program.operations;
+	std::vector<bool> reachable(operations.size() + 1, false);
+	std::vector<uint32_t> worklist = { 0 }, next;
+	KnownState unknown;
+
+	// Folded branches only have one successor now, so reachability is recomputed without the known state.
+	while (!worklist.empty()) {
+		uint32_t pc = worklist.back();
+		worklist.pop_back();
+
+		if (pc >= operations.size() || reachable[pc])
+			continue;
+		reachable[pc] = true;
+
+		if (operations[pc].code == OPCODE_LOOP_END) {
+			worklist.push_back(pc + 1); // The loop itself is reachable from its LOOP_START.
+			continue;
+		}
+		successors(pc, unknown, next);
+		worklist.insert(worklist.end(), next.begin(), next.end());
+	}
+
+	removeOperations(reachable);
+}
+
+void Optimizer::removeRedundantStores() {
+	std::vector<bool> kept(program.operations.size(), true);
+	bool removed = false;
+
+	for (uint32_t pc = 0; pc < program.operations.size(); ++pc) {
+		const Operation &operation = program.operations[pc];
+		const KnownState &state = states[pc];
+		if (!state.reachable || operation.code != OPCODE_VALUE_OPERATION || !isOperator(operation.modifier))
+			continue;
+
+		// Only constants are certain not to raise an error when evaluated.
+		uint64_t target = state.index;
+		if (program.operands[operation.argument].type != OPERAND_CONSTANT)
+			continue;
+		if (operation.target_form == TARGET_CURRENT ? !state.index_known :
+		    program.operands[operation.target].type != OPERAND_CONSTANT || !evaluateOperand(state, operation.target, target) || target >= UINT32_MAX)
+			continue;
+
+		// Known cells exist, so writing them neither pads the data pointer nor raises an error.
+		auto old = state.cells.find((uint32_t) target);
+		if (old == state.cells.end())
+			continue;
+
+		KnownState after = state;
+		execute(after, operation);
+		auto value = after.cells.find((uint32_t) target);
+		if (value != after.cells.end() && value->second == old->second) {
+			kept[pc] = false;
+			removed = true;
+		}
+	}
+
+	if (removed)
+		removeOperations(kept);
+}
+
+/**
+ * Writes the output of an OUTPUT_WRITE, like the engine does, if it is known.
+ *
+ * @param state The known state before the operation.
+ * @param operation The operation.
+ * @param text The string to which the output is appended.
+ *
+ * @return True, if the output is known. False otherwise, in which case the text is unchanged.
+ */
+bool Optimizer::formatOutput(const KnownState &state, const Operation &operation, std::string &text) const {
+	const std::string &formats = program.texts[operation.argument];
+	uint64_t value = 0;
+
+	// Known cells exist, so reading them doesn't raise an error. Spaces and newlines don't read the cell.
+	if (formats.empty() || formats.find_first_of("nc") != std::string::npos) {
+		auto cell = state.index_known ? state.cells.find(state.index) : state.cells.end();
+		if (cell == state.cells.end())
+			return false;
+		value = cell->second;
+	}
+
+	if (formats.empty())
+		text.push_back((char) value);
+
+	for (char format : formats) {
+		if (format == 'n')
+			text.append(std::to_string(value)); // Known values are already truncated to the cell width.
+		else if (format == 'c')
+			text.push_back((char) value);
+		else if (format == '_')
+			text.push_back(' ');
+		else text.push_back('\n');
+	}
+	return true;
+}
+
+void Optimizer::foldOutput() {
+	std::vector<Operation> &operations = program.operations;
+	std::vector<bool> kept(operations.size(), true);
+	bool removed = false;
+
+	// Operations which are jumped to can be reached without the output before them, so they start a new text.
+	std::vector<bool> targeted(operations.size() + 1, false);
+	for (const Operation &operation : operations) {
+		switch (operation.code) {
+			case OPCODE_JUMP:
+			case OPCODE_UNCERTAINTY_ENTER:
+			case OPCODE_UNCERTAINTY_START:
+			case OPCODE_LOOP_START:
+			case OPCODE_COUNTED_LOOP_START:
+			case OPCODE_COUNTED_LOOP_END:
+				targeted[std::min<size_t>(operation.target, operations.size())] = true;
+				break;
+			default:
+				break;
+		}
+	}
+	for (const Condition &condition : program.conditions) {
+		targeted[std::min<size_t>(condition.short_target, operations.size())] = true;
+		targeted[std::min<size_t>(condition.short_skip, operations.size())] = true;
+	}
+
+	uint32_t text = UINT32_MAX; // The OUTPUT_TEXT to which known output is appended, if any.
+	for (uint32_t pc = 0; pc < operations.size(); ++pc) {
+		Operation &operation = operations[pc];
+		if (targeted[pc])
+			text = UINT32_MAX;
+
+		std::string output;
+		if (operation.code == OPCODE_OUTPUT_WRITE && states[pc].reachable && formatOutput(states[pc], operation, output)) {
+			if (text != UINT32_MAX) {
+				program.texts[operations[text].argument].append(output);
+				kept[pc] = false;
+				removed = true;
+				continue;
+			}
+
+			program.texts.push_back(output);
+			operation.code = OPCODE_OUTPUT_TEXT;
+			operation.argument = (uint32_t) program.texts.size() - 1;
+			text = pc;
+		}
+		else if (operation.code != OPCODE_INDEX_INCREMENT && operation.code != OPCODE_INDEX_DECREMENT)
+			text = UINT32_MAX;
+	}
+
+	if (removed)
+		removeOperations(kept);
+}
+
+/**
+ * Removes operations, and moves the jumps to the operations which are kept.
+ *
+ * @param kept Whether every operation is kept.
+ */
+void Optimizer::removeOperations(const std::vector<bool> &kept) {
+	std::vector<Operation> &operations = program.operations;
+
+	// Every operation moves to the first operation kept at or after it.
+	std::vector<uint32_t> moved(operations.size() + 1);
+	uint32_t count = 0;
+	for (uint32_t pc = 0; pc < operations.size(); ++pc) {
+		moved[pc] = count;
+		if (kept[pc])
+			operations[count++] = operations[pc];
+	}
+	moved[operations.size()] = count;
+	operations.resize(count);
+
+	relocate(moved);
+}
+
+/**
+ * Moves the jumps, and the operations of the unoptimized program, to where their targets moved.
+ *
+ * @param moved The index to which every operation moved, followed by the new end of the program.
+ */
+void Optimizer::relocate(const std::vector<uint32_t> &moved) {
+	if (relocations != nullptr)
+		for (uint32_t &pc : *relocations)
+			pc = moved[pc];
+
+	for (Operation &operation : program.operations) {
+		switch (operation.code) {
+			case OPCODE_JUMP:
+			case OPCODE_UNCERTAINTY_ENTER:
+			case OPCODE_UNCERTAINTY_START:
+			case OPCODE_LOOP_START:
+			case OPCODE_COUNTED_LOOP_START:
+			case OPCODE_COUNTED_LOOP_END:
+				operation.target = moved[std::min<size_t>(operation.target, moved.size() - 1)];
+				break;
+			default:
+				break;
+		}
+	}
+	for (Condition &condition : program.conditions) {
+		condition.short_target = moved[std::min<size_t>(condition.short_target, moved.size() - 1)];
+		condition.short_skip = moved[std::min<size_t>(condition.short_skip, moved.size() - 1)];
+	}
+}
+
+/**
+ * Checks whether a loop is a counted loop (see CountedLoop): {[$iK]GT[0] ... }, or NEQ instead of GT, whose body only contains
+ * value, index and output operations, and decrements K exactly once, with ([K]-[1]). No other operation may write K at a
+ * constant index; the cells written at the index are checked when the loop starts.
+ *
+ * @param start The index of the LOOP_START operation.
+ * @param end The variable which will contain the index of the LOOP_END operation.
+ * @param loop The variable which will contain the counted loop, except for the amount of copies of the body.
+ *
+ * @return True, if the loop is a counted loop. False otherwise.
+ */
+bool Optimizer::findCountedLoop(uint32_t start, uint32_t &end, CountedLoop &loop) const {
+	const std::vector<Operation> &operations = program.operations;
+	const Condition &condition = program.conditions[operations[start].argument];
+	const Operand &counter = program.operands[condition.left];
+	KnownState unknown;
+	uint64_t target, operand;
+
+	if (condition.conjunction != CONJUNCTION_NONE || counter.type != OPERAND_CELL || counter.negative)
+		return false;
+	if ((condition.relation != RELATION_GREATER_THAN && condition.relation != RELATION_NOT_EQUAL) ||
+	    !evaluateOperand(unknown, condition.right, operand) || operand != 0)
+		return false;
+
+	loop.counter = counter.number;
+	loop.step = 0;
+	loop.offsets.clear();
+	loop.updates.clear();
+
+	bool closed = true;
+	uint32_t decrements = 0;
+	uint32_t pc = start + 1;
+
+	for (; pc < operations.size() && operations[pc].code != OPCODE_LOOP_END; ++pc) {
+		const Operation &operation = operations[pc];
+
+		switch (operation.code) {
+			case OPCODE_INDEX_INCREMENT:
+			case OPCODE_INDEX_DECREMENT:
+				loop.step += operation.code == OPCODE_INDEX_INCREMENT ? 1 : -1;
+				closed = false;
+				break;
+			case OPCODE_VALUE_INCREMENT:
+			case OPCODE_VALUE_DECREMENT:
+				loop.offsets.push_back(loop.step);
+				closed = false;
+				break;
+			case OPCODE_OUTPUT_WRITE:
+			case OPCODE_OUTPUT_TEXT:
+			case OPCODE_BULK_WRITE:
+				closed = false;
+				break;
+			case OPCODE_VALUE_OPERATION: {
+				if (!isOperator(operation.modifier))
+					return false;
+				if (operation.target_form == TARGET_CURRENT) {
+					loop.offsets.push_back(loop.step);
+					closed = false;
+					break;
+				}
+
+				// Targets past the highest index raise an error.
+				if (program.operands[operation.target].type != OPERAND_CONSTANT || !evaluateOperand(unknown, operation.target, target) || target >= UINT32_MAX)
+					return false;
+
+				bool constant = program.operands[operation.argument].type == OPERAND_CONSTANT && evaluateOperand(unknown, operation.argument, operand);
+				if (target == loop.counter) {
+					if (operation.modifier != OPERATOR_SUBTRACT || !constant || operand != 1)
+						return false;
+					++decrements;
+					break;
+				}
+
+				bool updated = std::any_of(loop.updates.begin(), loop.updates.end(), [target](const CellUpdate &update) { return update.cell == target; });
+				if (!constant || updated || (operation.modifier != OPERATOR_SET && operation.modifier != OPERATOR_ADD && operation.modifier != OPERATOR_SUBTRACT))
+					closed = false;
+				else loop.updates.push_back({ (uint32_t) target, operation.modifier, operand });
+				break;
+			}
+			default:
+				return false;
+		}
+	}
+
+	if (pc >= operations.size() || operations[start].target != pc + 1 || decrements != 1)
+		return false;
+	if (!closed)
+		loop.updates.clear();
+
+	end = pc;
+	return true;
+}
+
+void Optimizer::unrollLoops(uint32_t factor) {
+	std::vector<Operation> &operations = program.operations;
+	std::vector<uint32_t> moved(operations.size() + 1);
+	std::vector<uint32_t> starts, ends;
+	std::vector<CountedLoop> loops;
+	uint32_t count = 0;
+
+	for (uint32_t pc = 0; pc < operations.size(); ++pc) {
+		CountedLoop loop;
+		uint32_t end;
+
+		if (operations[pc].code != OPCODE_LOOP_START || !findCountedLoop(pc, end, loop)) {
+			moved[pc] = count++;
+			continue;
+		}
+
+		uint32_t length = end - pc - 1;
+		loop.unroll = std::max<uint32_t>(1, std::min<uint32_t>(factor, UNROLL_MAX_OPERATIONS / length));
+
+		// The original loop follows the copies. Jumps into the loop move to the original loop, which doesn't need the counter.
+		uint32_t original = count + loop.unroll * length + 2;
+		for (uint32_t i = pc; i <= end; ++i)
+			moved[i] = original + (i - pc);
+		count = original + (end - pc + 1);
+
+		starts.push_back(pc);
+		ends.push_back(end);
+		loops.push_back(loop);
+		pc = end;
+	}
+	moved[operations.size()] = count;
+
+	if (loops.empty())
+		return;
+	relocate(moved);
+
+	std::vector<Operation> unrolled;
+	unrolled.reserve(count);
+	for (uint32_t pc = 0, next = 0; pc < operations.size(); ++pc) {
+		if (next == starts.size() || pc != starts[next]) {
+			unrolled.push_back(operations[pc]);
+			continue;
+		}
+
+		uint32_t end = ends[next];
+		uint32_t first = (uint32_t) unrolled.size() + 1;
+		uint32_t id = (uint32_t) program.counted_loops.size();
+
+		Operation counted = operations[pc];
+		counted.code = OPCODE_COUNTED_LOOP_START;
+		counted.target = moved[pc];
+		counted.value = id;
+		unrolled.push_back(counted);
+
+		for (uint32_t copy = 0; copy < loops[next].unroll; ++copy)
+			unrolled.insert(unrolled.end(), operations.begin() + pc + 1, operations.begin() + end);
+
+		Operation repeat = operations[end];
+		repeat.code = OPCODE_COUNTED_LOOP_END;
+		repeat.target = first;
+		repeat.value = id;
+		unrolled.push_back(repeat);
+
+		unrolled.insert(unrolled.end(), operations.begin() + pc, operations.begin() + end + 1);
+		program.counted_loops.push_back(loops[next]);
+
+		pc = end;
+		++next;
+	}
+
+	operations.swap(unrolled);
+}
+
+/// A pass of the optimizer.
+struct PassInfo {
+	/// The name of the pass, as used by --disable-pass.
+	const char *name;
+	/// Runs the pass on a program.
+	void (*run)(Program &program, uint8_t cell_bits, const PassOptions &options, std::vector<uint32_t> *moved);
+};
+
+static void runFold(Program &program, uint8_t cell_bits, const PassOptions &, std::vector<uint32_t> *moved) {
+	Optimizer optimizer(program, cell_bits, moved);
+	optimizer.analyze();
+	optimizer.fold();
+}
+
+static void runStores(Program &program, uint8_t cell_bits, const PassOptions &, std::vector<uint32_t> *moved) {
+	// Folding propagates new constants, so the program is analyzed again.
+	Optimizer optimizer(program, cell_bits, moved);
+	optimizer.analyze();
+	optimizer.removeRedundantStores();
+}
+
+static void runOutput(Program &program, uint8_t cell_bits, const PassOptions &, std::vector<uint32_t> *moved) {
+	Optimizer optimizer(program, cell_bits, moved);
+	optimizer.analyze();
+	optimizer.foldOutput();
+}
+
+static void runUnreachable(Program &program, uint8_t cell_bits, const PassOptions &, std::vector<uint32_t> *moved) {
+	Optimizer optimizer(program, cell_bits, moved);
+	optimizer.removeUnreachable();
+}
+
+static void runLoops(Program &program, uint8_t cell_bits, const PassOptions &options, std::vector<uint32_t> *moved) {
+	Optimizer optimizer(program, cell_bits, moved);
+	optimizer.unrollLoops(options.unroll);
+}
+
+/// The passes, in the order of OptimizationPass.
+static const PassInfo passes[PASS_COUNT] = {
+	{ "fold", runFold },
+	{ "stores", runStores },
+	{ "output", runOutput },
+	{ "unreachable", runUnreachable },
+	{ "loops", runLoops }
+};
+
+const char *getPassName(OptimizationPass pass) {
+	return passes[pass].name;
+}
+
+OptimizationPass findPass(const char *name) {
+	for (uint8_t pass = 0; pass < PASS_COUNT; ++pass)
+		if (strcmp(passes[pass].name, name) == 0)
+			return (OptimizationPass) pass;
+	return PASS_COUNT;
+}
+
+void optimizeProgram(Program &program, uint8_t cell_bits, const PassOptions &options, std::vector<uint32_t> *moved) {
+	if (moved != nullptr) {
+		moved->resize(program.operations.size() + 1);
+		for (uint32_t pc = 0; pc < moved->size(); ++pc)
+			(*moved)[pc] = pc;
+	}
+
+	for (uint8_t pass = 0; pass < PASS_COUNT; ++pass) {
+		if (!options.enabled[pass])
+			continue;
+
+		CHRONOMETER chronometer = time_now();
+		passes[pass].run(program, cell_bits, options, moved);
+
+		if (options.timing) {
+			std::string time = getf_exec_time_ns(chronometer);
+			*options.timing << "[INFO] Pass " << passes[pass].name << " took " << time << " (" << program.operations.size() << " operations left)\n";
+		}
+	}
+}
@@ -0,0 +1,86 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef X10_OPTIMIZER_H
+#define X10_OPTIMIZER_H
+
+#include "program.h"
+
+#include <ostream>
+
+/// The default amount of copies of the body of a counted loop.
+#define UNROLL_FACTOR 4
+/// The most operations which the copies of the body of a counted loop can have together.
+#define UNROLL_MAX_OPERATIONS 64
+
+/// The passes of the optimizer, in the order in which they run.
+enum OptimizationPass : uint8_t {
+	/// Folds the uncertainties and loops whose expressions are known, and propagates known values into operands.
+	PASS_FOLD,
+	/// Removes the value operations which leave a known cell unchanged.
+	PASS_STORES,
+	/// Precomputes the output of the OUTPUT_WRITE operations whose cells are known, and joins them into texts.
+	PASS_OUTPUT,
+	/// Removes the operations which can no longer be reached.
+	PASS_UNREACHABLE,
+	/// Unrolls the counted loops (see CountedLoop). It runs last, since the other passes don't analyze counted loops.
+	PASS_LOOPS,
+	PASS_COUNT
+};
+
+/// The passes which are run, and how they are reported.
+struct PassOptions {
+	/// Whether each pass is run.
+	bool enabled[PASS_COUNT] = { true, true, true, true, true };
+	/// The amount of copies of the body of a counted loop. 1 keeps one copy, which is still repeated without evaluating the expression.
+	uint32_t unroll = UNROLL_FACTOR;
+	/// The stream to which the time taken by each pass is written, if any.
+	std::ostream *timing = nullptr;
+};
+
+/// Gets the name of a pass.
+const char *getPassName(OptimizationPass pass);
+/**
+ * Finds a pass by its name.
+ *
+ * @param name The name.
+ *
+ * @return The pass, or PASS_COUNT if there is no pass with that name.
+ */
+OptimizationPass findPass(const char *name);
+
+/**
+ * Optimizes a compiled program with a dataflow analysis, which tracks the index and the values of the cells
+ * that are known at every operation. Uncertainties and loops whose expressions are known are folded into jumps,
+ * operands whose values are known become constants, redundant writes and operations which can no longer be reached are removed,
+ * known output is written as precomputed text, and counted loops are unrolled.
+ * The program behaves exactly like before, including its errors and their positions.
+ *
+ * @param program The program, which is not bound yet.
+ * @param cell_bits The width of the cells of the states which execute the program (8, 16, 32 or 64).
+ * @param options The passes which are run.
+ * @param moved The variable which will contain the index to which every operation moved, if any. Removed operations
+ *              move to the first operation kept after them, and the end of the program moves to the new end.
+ */
+void optimizeProgram(Program &program, uint8_t cell_bits, const PassOptions &options = PassOptions(), std::vector<uint32_t> *moved = nullptr);
+
+#endif
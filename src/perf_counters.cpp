@@ -0,0 +1,159 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "perf_counters.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/// The names of the events, as reported.
+static const char *event_names[PERF_EVENT_COUNT] = { "cycles", "instructions", "branch misses", "L1 data misses", "LLC misses" };
+
+#ifdef __linux__
+
+PerfCounters::PerfCounters(bool enabled) : enabled(enabled) {
+	static const uint32_t types[PERF_EVENT_COUNT] = {
+		PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE
+	};
+	static const uint64_t configs[PERF_EVENT_COUNT] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_BRANCH_MISSES,
+		PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+		PERF_COUNT_HW_CACHE_MISSES
+	};
+
+	for (uint8_t event = 0; event < PERF_EVENT_COUNT; ++event) {
+		descriptors[event] = -1;
+		counts[event] = 0;
+		counted[event] = false;
+		if (!enabled)
+			continue;
+
+		perf_event_attr attributes;
+		memset(&attributes, 0, sizeof(attributes));
+		attributes.size = sizeof(attributes);
+		attributes.type = types[event];
+		attributes.config = configs[event];
+		attributes.disabled = 1;
+		attributes.inherit = 1; // Count the threads of --map.
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		descriptors[event] = (int) syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+		if (descriptors[event] != -1 || !failure.empty())
+			continue;
+
+		if (errno == ENOENT || errno == EOPNOTSUPP)
+			failure = "The processor doesn't expose the event";
+		else if (errno == EACCES || errno == EPERM)
+			failure = "Not permitted by /proc/sys/kernel/perf_event_paranoid";
+		else failure = strerror(errno);
+	}
+}
+
+PerfCounters::~PerfCounters() {
+	for (int descriptor : descriptors)
+		if (descriptor != -1)
+			close(descriptor);
+}
+
+void PerfCounters::start() {
+	for (int descriptor : descriptors) {
+		if (descriptor != -1) {
+			ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+			ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+}
+
+void PerfCounters::stop() {
+	for (int descriptor : descriptors)
+		if (descriptor != -1)
+			ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+
+	for (uint8_t event = 0; event < PERF_EVENT_COUNT; ++event) {
+		uint64_t values[3]; // The count, the time enabled and the time running.
+		if (descriptors[event] == -1 || read(descriptors[event], values, sizeof(values)) != sizeof(values) || values[2] == 0)
+			continue;
+
+		// Counters which shared the hardware with other counters only ran for part of the time.
+		counts[event] = values[2] < values[1] ? (uint64_t) ((double) values[0] * values[1] / values[2]) : values[0];
+		counted[event] = true;
+	}
+}
+
+#else
+
+PerfCounters::PerfCounters(bool enabled) : enabled(enabled) {
+	for (uint8_t event = 0; event < PERF_EVENT_COUNT; ++event) {
+		descriptors[event] = -1;
+		counts[event] = 0;
+		counted[event] = false;
+	}
+	failure = "Not supported on this platform";
+}
+
+PerfCounters::~PerfCounters() { }
+
+void PerfCounters::start() { }
+
+void PerfCounters::stop() { }
+
+#endif
+
+void PerfCounters::report(std::ostream &output, const char *engine) const {
+	if (!enabled)
+		return;
+
+	bool any = false;
+	for (bool event : counted)
+		any = any || event;
+
+	if (!any) {
+		output << "\n[INFO] Performance counters (" << engine << ") are unavailable: " << (failure.empty() ? "No events were counted" : failure);
+		return;
+	}
+
+	output << "\n[INFO] Performance counters (" << engine << "):";
+	for (uint8_t event = 0; event < PERF_EVENT_COUNT; ++event) {
+		output << (event == 0 ? " " : ", ");
+		if (counted[event])
+			output << counts[event] << ' ' << event_names[event];
+		else output << event_names[event] << " unavailable";
+
+		if (event == PERF_INSTRUCTIONS && counted[PERF_CYCLES] && counted[PERF_INSTRUCTIONS] && counts[PERF_CYCLES] != 0) {
+			char ipc[32];
+			snprintf(ipc, sizeof(ipc), " (%.2f per cycle)", (double) counts[PERF_INSTRUCTIONS] / counts[PERF_CYCLES]);
+			output << ipc;
+		}
+	}
+}
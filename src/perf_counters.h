@@ -0,0 +1,82 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef X10_PERF_COUNTERS_H
+#define X10_PERF_COUNTERS_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/// The hardware events which are counted.
+enum PerfEvent : uint8_t {
+	PERF_CYCLES,
+	PERF_INSTRUCTIONS,
+	PERF_BRANCH_MISSES,
+	PERF_L1D_MISSES,
+	PERF_LLC_MISSES,
+	PERF_EVENT_COUNT
+};
+
+/**
+ * Hardware performance counters of the process, which are read with perf_event_open on Linux.
+ * Only user space is counted, including the threads created while the counters run.
+ * Counters which can't be opened (e.g. in virtual machines, or because of perf_event_paranoid) are reported as unavailable.
+ */
+class PerfCounters {
+	public:
+		/**
+		 * Opens the counters, without starting them.
+		 *
+		 * @param enabled Whether to count. If false, the counters do nothing.
+		 */
+		explicit PerfCounters(bool enabled);
+		~PerfCounters();
+
+		PerfCounters(const PerfCounters&) = delete;
+		PerfCounters &operator=(const PerfCounters&) = delete;
+
+		/// Resets and starts the counters.
+		void start();
+		/// Stops the counters and reads them.
+		void stop();
+		/**
+		 * Writes the counts, if the counters are enabled.
+		 *
+		 * @param output The stream where to write.
+		 * @param engine The name of the engine which was counted.
+		 */
+		void report(std::ostream &output, const char *engine) const;
+
+	private:
+		bool enabled;
+		/// The file descriptors of the counters, or -1 for the counters which couldn't be opened.
+		int descriptors[PERF_EVENT_COUNT];
+		/// The counts, scaled up if the counters were multiplexed.
+		uint64_t counts[PERF_EVENT_COUNT];
+		/// Whether the counters ran while they were started.
+		bool counted[PERF_EVENT_COUNT];
+		/// Why the first counter which couldn't be opened failed.
+		std::string failure;
+};
+
+#endif
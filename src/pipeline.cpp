@@ -0,0 +1,112 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "pipeline.h"
+#include "arguments.h"
+#include "ring_buffer.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+
+/**
+ * Executes a stage of a pipeline, and then closes its ring buffers.
+ *
+ * @param stage The stage.
+ * @param index The index of the stage.
+ * @param cell_bits The width of the cells, in bits.
+ * @param input The stream from which the stage reads.
+ * @param output The stream where the stage writes.
+ * @param reader The ring buffer from which the stage reads, if it is not the first stage.
+ * @param writer The ring buffer where the stage writes, if it is not the last stage.
+ * @param error Where to store the error raised by the stage, if any.
+ */
+static void executeStage(const PipelineStage &stage, uint32_t index, uint8_t cell_bits, std::istream &input, std::ostream &output,
+                         RingInputBuffer *reader, RingOutputBuffer *writer, std::string &error) {
+	std::unique_ptr<ExecutionState> execution = createExecutionState(stage.tape, cell_bits);
+	ExecutionState &state = *execution;
+
+	state.input = &input;
+	state.output = &output;
+	state.program = stage.program;
+
+	try {
+		initializeState(0, nullptr, state);
+		prepareExecution(state);
+		executeProgram(state);
+	}
+	catch (ExecutionError &e) {
+		error = "[ERROR] [Stage " + std::to_string(index) + "] [Instruction " + std::to_string(e.position) + "]: " + e.what() + "\n";
+	}
+	catch (std::exception &e) {
+		error = "[ERROR] [Stage " + std::to_string(index) + "] [Instruction " + std::to_string(stage.program->operations[state.pc].error_position) + "]: " + e.what() + "\n";
+	}
+
+	delete state.file_input;
+	delete state.file_output;
+
+	output.flush();
+	if (writer != nullptr)
+		writer->close();
+	if (reader != nullptr)
+		reader->close();
+}
+
+PipelineResult runPipeline(const std::vector<PipelineStage> &stages, uint8_t cell_bits, std::istream &input, std::ostream &output, std::ostream &errors) {
+	size_t count = stages.size();
+
+	// Ring i connects stage i to stage i + 1.
+	std::vector<std::unique_ptr<RingBuffer>> rings;
+	std::vector<std::unique_ptr<RingOutputBuffer>> writers;
+	std::vector<std::unique_ptr<RingInputBuffer>> readers;
+	std::vector<std::unique_ptr<std::ostream>> outputs;
+	std::vector<std::unique_ptr<std::istream>> inputs;
+	for (size_t i = 0; i + 1 < count; ++i) {
+		rings.emplace_back(new RingBuffer());
+		writers.emplace_back(new RingOutputBuffer(*rings[i]));
+		readers.emplace_back(new RingInputBuffer(*rings[i]));
+		outputs.emplace_back(new std::ostream(writers[i].get()));
+		inputs.emplace_back(new std::istream(readers[i].get()));
+	}
+
+	std::vector<std::string> failures(count);
+	std::vector<std::thread> threads;
+	threads.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		threads.emplace_back(executeStage, std::cref(stages[i]), (uint32_t) i, cell_bits,
+		                     std::ref(i == 0 ? input : *inputs[i - 1]), std::ref(i + 1 == count ? output : *outputs[i]),
+		                     i == 0 ? nullptr : readers[i - 1].get(), i + 1 == count ? nullptr : writers[i].get(), std::ref(failures[i]));
+	}
+
+	for (std::thread &thread : threads)
+		thread.join();
+
+	PipelineResult result;
+	for (const std::string &failure : failures) {
+		if (!failure.empty()) {
+			errors << failure;
+			++result.failed;
+		}
+	}
+	return result;
+}
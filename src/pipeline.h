@@ -0,0 +1,64 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef X10_PIPELINE_H
+#define X10_PIPELINE_H
+
+#include "engine.h"
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+/// A script which is executed as a stage of a pipeline.
+struct PipelineStage {
+	/// The program, which is bound for tape and for the cell width of the pipeline.
+	const Program *program;
+	/// The kind of data pointer of the stage.
+	TapeKind tape;
+};
+
+/// The totals of a pipeline.
+struct PipelineResult {
+	/// The amount of stages which raised an error.
+	uint32_t failed = 0;
+};
+
+/**
+ * Executes the stages of a pipeline at the same time, each on its own thread. The output of every stage
+ * is the input of the next one, through a ring buffer. A stage which ends closes both of its ring buffers,
+ * so that the next stage reads the end of its input, and the previous one discards the rest of its output.
+ * Errors are written to the error stream, in stage order, once every stage ended.
+ *
+ * @param stages The stages, in order.
+ * @param cell_bits The width of the cells, in bits.
+ * @param input The stream from which the first stage reads.
+ * @param output The stream where the last stage writes.
+ * @param errors The stream where the errors are written.
+ *
+ * @return The totals of the pipeline.
+ */
+PipelineResult runPipeline(const std::vector<PipelineStage> &stages, uint8_t cell_bits, std::istream &input, std::ostream &output, std::ostream &errors);
+
+#endif
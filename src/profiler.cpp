@@ -0,0 +1,226 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define X10_PROFILER
+#include <sys/time.h>
+#endif
+
+/// The longest expression shown in a frame.
+#define PROFILE_SNIPPET_LENGTH 40
+
+/// The state of the program when a sample was taken.
+struct ProfileSample {
+	/// The operation executed next.
+	uint32_t pc;
+	/// The amount of open loops which were recorded.
+	uint32_t depth;
+	/// The operations which started the open loops, outermost first.
+	uint32_t loops[PROFILE_MAX_DEPTH];
+};
+
+// Only the signal handler writes the samples while the profiler runs.
+static ExecutionState *volatile profiled_state = nullptr;
+static std::unique_ptr<ProfileSample[]> samples;
+static volatile uint32_t sample_count = 0;
+/// Only every stride-th tick is sampled.
+static volatile uint32_t stride = 1;
+static volatile uint32_t ticks = 0;
+
+/**
+ * Samples the profiled state. The loop stack never reallocates while the program executes, since
+ * prepareExecution() reserves it, so it can be read from the signal handler.
+ *
+ * @param signal The signal.
+ */
+static void sampleState(int signal) {
+	ExecutionState *state = profiled_state;
+	if (state == nullptr || ++ticks % stride != 0)
+		return;
+
+	if (sample_count == PROFILE_CAPACITY) {
+		for (uint32_t i = 0; i < PROFILE_CAPACITY / 2; ++i)
+			samples[i] = samples[2 * i + 1];
+		sample_count = PROFILE_CAPACITY / 2;
+		stride = stride * 2;
+	}
+
+	ProfileSample &sample = samples[sample_count];
+	size_t depth = std::min<size_t>(state->loop_stack.size(), PROFILE_MAX_DEPTH);
+
+	sample.pc = state->pc;
+	sample.depth = (uint32_t) depth;
+	memcpy(sample.loops, state->loop_stack.data(), depth * sizeof(uint32_t));
+	sample_count = sample_count + 1;
+}
+
+#ifdef X10_PROFILER
+
+void startProfiler(ExecutionState &state) {
+	if (!samples)
+		samples.reset(new ProfileSample[PROFILE_CAPACITY]);
+	sample_count = 0;
+	stride = 1;
+	ticks = 0;
+	profiled_state = &state;
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = sampleState;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+
+	itimerval timer;
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = PROFILE_PERIOD;
+	timer.it_value = timer.it_interval;
+
+	if (sigaction(SIGPROF, &action, nullptr) != 0 || setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+		profiled_state = nullptr;
+		throw std::runtime_error("Cannot start the profiler");
+	}
+}
+
+void stopProfiler() {
+	itimerval timer;
+	memset(&timer, 0, sizeof(timer));
+	setitimer(ITIMER_PROF, &timer, nullptr);
+	profiled_state = nullptr;
+}
+
+#else
+
+void startProfiler(ExecutionState &state) {
+	throw std::runtime_error("The profiler is not supported on this platform");
+}
+
+void stopProfiler() { }
+
+#endif
+
+/// Labels the operations of a program with their position in the script.
+class FrameNames {
+	public:
+		explicit FrameNames(const Program &program) : program(program) {
+			line_starts.push_back(0);
+			for (size_t i = 0; i < program.source.size(); ++i)
+				if (program.source[i] == '\n')
+					line_starts.push_back((uint32_t) i + 1);
+		}
+
+		/**
+		 * Gets the frame of an operation: its identifier, line and column. Loops also contain their expression.
+		 *
+		 * @param pc The index of the operation.
+		 *
+		 * @return The frame.
+		 */
+		std::string getFrame(uint32_t pc) const {
+			if (pc >= program.operations.size())
+				return "end";
+
+			uint32_t position = program.operations[pc].position;
+			size_t line = std::upper_bound(line_starts.begin(), line_starts.end(), position) - line_starts.begin();
+
+			std::string frame(1, position < program.source.size() ? program.source[position] : '?');
+			if (program.operations[pc].code == OPCODE_LOOP_START)
+				frame += getExpression(position + 1);
+
+			frame += ' ' + std::to_string(line) + ':' + std::to_string(position - line_starts[line - 1] + 1);
+			return frame;
+		}
+
+	private:
+		const Program &program;
+		/// The positions where lines start.
+		std::vector<uint32_t> line_starts;
+
+		/**
+		 * Gets the text of an expression, which is made of [NUM]s and operators.
+		 *
+		 * @param position The position where the expression starts.
+		 *
+		 * @return The text, shortened if it is too long.
+		 */
+		std::string getExpression(uint32_t position) const {
+			const std::string &source = program.source;
+			size_t end = position;
+			int32_t depth = 0;
+
+			while (end < source.size() && (depth > 0 || source[end] == '[' || (source[end] >= 'A' && source[end] <= 'Z'))) {
+				if (source[end] == '[')
+					++depth;
+				else if (source[end] == ']')
+					--depth;
+				else if (source[end] == '\n' || source[end] == ';')
+					break; // Keep frames on one line, and apart from each other.
+				++end;
+			}
+
+			if (end - position > PROFILE_SNIPPET_LENGTH)
+				return source.substr(position, PROFILE_SNIPPET_LENGTH - 3) + "...";
+			return source.substr(position, end - position);
+		}
+};
+
+void writeProfile(const char *file, const Program &program) {
+	FrameNames names(program);
+	std::map<std::string, uint64_t> stacks;
+
+	for (uint32_t i = 0; i < sample_count; ++i) {
+		const ProfileSample &sample = samples[i];
+		std::string stack = "x10";
+
+		for (uint32_t j = 0; j < sample.depth; ++j) {
+			uint32_t loop = sample.loops[j];
+
+			// The loop starts are only checked here, in case a sample interrupted a push.
+			if (loop < program.operations.size() && program.operations[loop].code == OPCODE_LOOP_START)
+				stack += ';' + names.getFrame(loop);
+		}
+
+		// A loop which is being skipped is shown once.
+		if (sample.depth == 0 || sample.loops[sample.depth - 1] != sample.pc)
+			stack += ';' + names.getFrame(sample.pc);
+		++stacks[stack];
+	}
+
+	std::ofstream stream(file, std::ios::trunc);
+	if (stream.fail())
+		throw std::runtime_error("Cannot write the profile");
+
+	for (const auto &stack : stacks)
+		stream << stack.first << ' ' << stack.second << '\n';
+
+	stream.close();
+	if (stream.fail())
+		throw std::runtime_error("Cannot write the profile");
+}
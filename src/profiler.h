@@ -0,0 +1,57 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef X10_PROFILER_H
+#define X10_PROFILER_H
+
+#include "engine.h"
+
+/// The sampling period, in microseconds of CPU time.
+#define PROFILE_PERIOD 1000
+/// The amount of samples kept. When it's reached, every other sample is discarded and the sampling period doubles.
+#define PROFILE_CAPACITY (1u << 16)
+/// The deepest loop nesting recorded by a sample. Deeper loops are attributed to the loops which contain them.
+#define PROFILE_MAX_DEPTH 32
+
+/**
+ * Starts sampling an execution state with SIGPROF. Every sample records the operation which is executed next,
+ * along with the loop stack. Only one state is sampled at a time.
+ *
+ * @param state The execution state, which must outlive the profiler.
+ *
+ * @throws std::runtime_error If the timer cannot be started.
+ */
+void startProfiler(ExecutionState &state);
+/// Stops sampling. The samples are kept until the profiler is started again.
+void stopProfiler();
+/**
+ * Writes the samples as collapsed stacks ("frame;frame;frame count"), which flamegraph tools accept.
+ * The outer frames are the open loops, labelled with their line, column and expression, and the last frame is the operation.
+ *
+ * @param file The file where to write.
+ * @param program The program which was sampled.
+ *
+ * @throws std::runtime_error If the file cannot be written.
+ */
+void writeProfile(const char *file, const Program &program);
+
+#endif
@@ -0,0 +1,332 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "program.h"
+#include "operators.h"
+
+#include <iomanip>
+
+OperandForm Program::getOperandForm(uint32_t operand) const {
+	const Operand &num = operands[operand];
+
+	if (num.type == OPERAND_CONSTANT)
+		return FORM_CONSTANT; // Constants are negated when compiled.
+	if (num.negative)
+		return FORM_EXPRESSION;
+
+	switch (num.type) {
+		case OPERAND_INDEX: return FORM_INDEX;
+		case OPERAND_CELL: return FORM_CELL;
+		case OPERAND_RELATIVE_CELL: return FORM_RELATIVE_CELL;
+		default: return FORM_EXPRESSION;
+	}
+}
+
+bool Program::hasWideAddressRange() const {
+	uint32_t run = 0;
+
+	for (size_t i = 0; i < operations.size(); ++i) {
+		run = operations[i].code == OPCODE_INDEX_INCREMENT ? run + 1 : 0;
+		if (run >= WIDE_INDEX_RUN)
+			return true;
+
+		if (operations[i].code != OPCODE_LOOP_START)
+			continue;
+
+		// Only innermost loops are checked; their body is executed straight through.
+		int64_t movement = 0;
+		bool writes = false;
+		size_t j = i + 1;
+
+		for (; j < operations.size(); ++j) {
+			Opcode code = operations[j].code;
+
+			if (code == OPCODE_LOOP_END || code == OPCODE_LOOP_START || code == OPCODE_JUMP || code == OPCODE_HALT)
+				break;
+			if (code == OPCODE_INDEX_INCREMENT)
+				++movement;
+			else if (code == OPCODE_INDEX_DECREMENT)
+				--movement;
+			else if (code == OPCODE_VALUE_INCREMENT || code == OPCODE_VALUE_DECREMENT || code == OPCODE_VALUE_OPERATION ||
+			         (code >= OPCODE_INPUT_READ && code <= OPCODE_INPUT_OR) || code == OPCODE_BULK_READ ||
+			         (code >= OPCODE_MEMORY_FILL && code <= OPCODE_MEMORY_COMPARE))
+				writes = true;
+		}
+
+		if (j < operations.size() && operations[j].code == OPCODE_LOOP_END && movement > 0 && !writes)
+			return true;
+	}
+
+	return false;
+}
+
+bool Program::isRangeMap(uint32_t loop) const {
+	if (loop + 3 >= operations.size() || operations[loop].target != loop + 4)
+		return false;
+
+	const Operation &body = operations[loop + 1];
+	if (operations[loop + 2].code != OPCODE_INDEX_INCREMENT || operations[loop + 3].code != OPCODE_LOOP_END)
+		return false;
+
+	// [i] compared to a constant.
+	const Condition &condition = conditions[operations[loop].argument];
+	const Operand &left = operands[condition.left];
+	const Operand &right = operands[condition.right];
+
+	if (condition.conjunction != CONJUNCTION_NONE || left.type != OPERAND_INDEX || left.number != 0 || left.negative || right.type != OPERAND_CONSTANT)
+		return false;
+	if (condition.relation != RELATION_LESS_THAN && condition.relation != RELATION_LESS_THAN_OR_EQUAL && condition.relation != RELATION_NOT_EQUAL)
+		return false;
+
+	if (body.code == OPCODE_VALUE_INCREMENT || body.code == OPCODE_VALUE_DECREMENT)
+		return true;
+	if (body.code != OPCODE_VALUE_OPERATION || body.target_form != TARGET_CURRENT || !isOperator(body.modifier))
+		return false;
+	if (body.modifier == OPERATOR_DIVIDE || body.modifier == OPERATOR_MODULO)
+		return false;
+
+	OperandForm form = getOperandForm(body.argument);
+	return form == FORM_CONSTANT || form == FORM_CELL;
+}
+
+/// The names of the opcodes, in the order of Opcode.
+static const char *const opcode_names[] = {
+	"HALT", "TRAP", "JUMP",
+	"VALUE_INCREMENT", "VALUE_DECREMENT", "VALUE_OPERATION",
+	"INDEX_INCREMENT", "INDEX_DECREMENT",
+	"UNCERTAINTY_START", "UNCERTAINTY_END",
+	"LOOP_START", "LOOP_END",
+	"OUTPUT_WRITE",
+	"INPUT_READ", "INPUT_ADD", "INPUT_XOR", "INPUT_AND", "INPUT_OR",
+	"FILE_OPEN", "FILE_CLOSE",
+	"BULK_READ", "BULK_WRITE",
+	"MEMORY_FILL", "MEMORY_MOVE", "MEMORY_COMPARE",
+	"UNCERTAINTY_ENTER",
+	"COUNTED_LOOP_START", "COUNTED_LOOP_END",
+	"OUTPUT_TEXT"
+};
+
+/// The relational operators, in the order of Relation.
+static const char *const relation_names[] = {
+	RELATIONAL_EQUAL, RELATIONAL_NOT_EQUAL, RELATIONAL_GREATER_THAN, RELATIONAL_GREATER_THAN_OR_EQUAL,
+	RELATIONAL_LESS_THAN, RELATIONAL_LESS_THAN_OR_EQUAL, "?"
+};
+
+/// The conditional operators, in the order of Conjunction.
+static const char *const conjunction_names[] = { "", CONDITIONAL_AND, CONDITIONAL_OR, CONDITIONAL_XOR };
+
+/// Appends an offset from the index, as in [i+5] or [$i-5].
+static void appendOffset(std::string &text, uint32_t number) {
+	int32_t offset = (int32_t) number;
+	if (offset > 0)
+		text.push_back('+');
+	if (offset != 0)
+		text.append(std::to_string(offset));
+}
+
+/**
+ * Writes an operand like it is written in scripts. Traps are written as their error message.
+ *
+ * @param program The program.
+ * @param id The index of the operand.
+ * @param text The string to which the operand is appended.
+ */
+static void appendOperand(const Program &program, uint32_t id, std::string &text) {
+	const Operand &operand = program.operands[id];
+
+	if (operand.type == OPERAND_TRAP) {
+		text.append("<" + program.texts[operand.number] + ">");
+		return;
+	}
+
+	text.push_back(NUMBER_START);
+	if (operand.negative)
+		text.push_back(NUMBER_MODIFIER_NEGATIVE);
+
+	switch (operand.type) {
+		case OPERAND_CONSTANT:
+			text.append(std::to_string((int32_t) operand.number));
+			break;
+		case OPERAND_INDEX:
+			text.push_back(NUMBER_MODIFIER_INDEX);
+			appendOffset(text, operand.number);
+			break;
+		case OPERAND_CELL:
+			text.push_back(NUMBER_MODIFIER_VALUE_AT);
+			text.push_back(NUMBER_MODIFIER_INDEX);
+			text.append(std::to_string(operand.number));
+			break;
+		case OPERAND_RELATIVE_CELL:
+			text.push_back(NUMBER_MODIFIER_VALUE_AT);
+			text.push_back(NUMBER_MODIFIER_INDEX);
+			appendOffset(text, operand.number);
+			break;
+		case OPERAND_NESTED:
+			appendOperand(program, operand.nested, text);
+			break;
+		case OPERAND_INDEX_PLUS_NESTED:
+		case OPERAND_INDEX_MINUS_NESTED:
+			text.push_back(NUMBER_MODIFIER_INDEX);
+			text.push_back(operand.type == OPERAND_INDEX_PLUS_NESTED ? '+' : '-');
+			appendOperand(program, operand.nested, text);
+			break;
+		case OPERAND_CELL_AT_NESTED:
+			text.push_back(NUMBER_MODIFIER_VALUE_AT);
+			appendOperand(program, operand.nested, text);
+			break;
+		default:
+			text.push_back(NUMBER_MODIFIER_VALUE_AT);
+			text.push_back(NUMBER_MODIFIER_INDEX);
+			text.push_back(operand.type == OPERAND_CELL_AT_INDEX_PLUS_NESTED ? '+' : '-');
+			appendOperand(program, operand.nested, text);
+			break;
+	}
+
+	text.push_back(NUMBER_END);
+}
+
+/**
+ * Writes an expression like it is written in scripts, followed by the jump targets of its ANDs.
+ *
+ * @param program The program.
+ * @param id The index of the first expression.
+ * @param text The string to which the expression is appended.
+ */
+static void appendCondition(const Program &program, uint32_t id, std::string &text) {
+	std::string shorts;
+
+	for (;; id = program.conditions[id].next) {
+		const Condition &condition = program.conditions[id];
+
+		appendOperand(program, condition.left, text);
+		text.append(relation_names[condition.relation]);
+		appendOperand(program, condition.right, text);
+		text.append(conjunction_names[condition.conjunction]);
+
+		if (condition.conjunction == CONJUNCTION_AND)
+			shorts.append(" and:" + std::to_string(condition.short_target) + "/" + std::to_string(condition.short_skip));
+		if (condition.conjunction == CONJUNCTION_NONE)
+			break;
+	}
+
+	text.append(shorts);
+}
+
+/**
+ * Writes a text in quotes, escaping the characters which would break the line.
+ *
+ * @param value The text.
+ * @param text The string to which the text is appended.
+ */
+static void appendText(const std::string &value, std::string &text) {
+	static const char digits[] = "0123456789abcdef";
+
+	text.push_back('"');
+	for (char character : value) {
+		if (character == '\n')
+			text.append("\\n");
+		else if (character == '"' || character == '\\') {
+			text.push_back('\\');
+			text.push_back(character);
+		}
+		else if ((unsigned char) character < 0x20 || (unsigned char) character >= 0x7f) {
+			text.append("\\x");
+			text.push_back(digits[(unsigned char) character >> 4]);
+			text.push_back(digits[(unsigned char) character & 0xf]);
+		}
+		else text.push_back(character);
+	}
+	text.push_back('"');
+}
+
+void Program::dump(std::ostream &output) const {
+	output << "[IR] " << operations.size() << " operations, " << operands.size() << " operands, " << conditions.size() << " expressions\n";
+
+	for (size_t pc = 0; pc < operations.size(); ++pc) {
+		const Operation &operation = operations[pc];
+		std::string text;
+
+		switch (operation.code) {
+			case OPCODE_TRAP:
+				text = "\"" + texts[operation.argument] + "\"";
+				break;
+			case OPCODE_JUMP:
+			case OPCODE_UNCERTAINTY_ENTER:
+			case OPCODE_COUNTED_LOOP_END:
+				text = "-> " + std::to_string(operation.target);
+				break;
+			case OPCODE_VALUE_OPERATION:
+				text.push_back('(');
+				if (operation.target_form != TARGET_CURRENT)
+					appendOperand(*this, operation.target, text);
+				text.push_back(operation.modifier);
+				appendOperand(*this, operation.argument, text);
+				text.push_back(')');
+				break;
+			case OPCODE_UNCERTAINTY_START:
+			case OPCODE_LOOP_START:
+				appendCondition(*this, operation.argument, text);
+				text.append(" else -> " + std::to_string(operation.target));
+				break;
+			case OPCODE_COUNTED_LOOP_START: {
+				const CountedLoop &loop = counted_loops[operation.value];
+				appendCondition(*this, operation.argument, text);
+				text.append(" x" + std::to_string(loop.unroll));
+				if (!loop.updates.empty())
+					text.append(" closed");
+				text.append(" else -> " + std::to_string(operation.target));
+				break;
+			}
+			case OPCODE_OUTPUT_WRITE:
+				text = texts[operation.argument];
+				break;
+			case OPCODE_OUTPUT_TEXT:
+				appendText(texts[operation.argument], text);
+				break;
+			case OPCODE_FILE_OPEN:
+				text = std::string(1, operation.modifier) + " \"" + texts[operation.argument] + "\"";
+				break;
+			case OPCODE_FILE_CLOSE:
+				text = std::string(1, operation.modifier);
+				break;
+			case OPCODE_BULK_READ:
+			case OPCODE_BULK_WRITE:
+				appendOperand(*this, operation.argument, text);
+				appendOperand(*this, operation.target, text);
+				break;
+			case OPCODE_MEMORY_FILL:
+			case OPCODE_MEMORY_MOVE:
+			case OPCODE_MEMORY_COMPARE:
+				appendOperand(*this, operation.argument, text);
+				appendOperand(*this, operation.target, text);
+				appendOperand(*this, operation.value, text);
+				if (operation.code == OPCODE_MEMORY_COMPARE)
+					appendOperand(*this, operation.target_value, text);
+				break;
+			default:
+				break;
+		}
+
+		output << std::setw(6) << pc << "  " << std::left << std::setw(18) << opcode_names[operation.code] << std::right
+		       << " " << text << "  @" << operation.position << "\n";
+	}
+}
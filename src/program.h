@@ -0,0 +1,281 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef X10_PROGRAM_H
+#define X10_PROGRAM_H
+
+#include "definitions.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct ExecutionState;
+struct Operation;
+
+/// The length of a run of INDEX_INCREMENT from which a program is considered to use a wide range of the data pointer.
+#define WIDE_INDEX_RUN (1u << 16)
+
+typedef void(*OperationBody)(OPERATION_INFO);
+
+/// The kinds of [NUM] operands.
+enum OperandType : uint8_t {
+	OPERAND_CONSTANT,                 // number
+	OPERAND_INDEX,                    // index + number
+	OPERAND_CELL,                     // pointer.at(number)
+	OPERAND_RELATIVE_CELL,            // pointer.at(index + number)
+	OPERAND_NESTED,                   // [NUM]
+	OPERAND_INDEX_PLUS_NESTED,        // index + [NUM]
+	OPERAND_INDEX_MINUS_NESTED,       // index - [NUM]
+	OPERAND_CELL_AT_NESTED,           // pointer.at([NUM])
+	OPERAND_CELL_AT_INDEX_PLUS_NESTED,  // pointer.at(index + [NUM])
+	OPERAND_CELL_AT_INDEX_MINUS_NESTED, // pointer.at(index - [NUM])
+	OPERAND_TRAP                      // A syntax error, raised when the operand is evaluated.
+};
+
+/// The relational operators.
+enum Relation : uint8_t {
+	RELATION_EQUAL,
+	RELATION_NOT_EQUAL,
+	RELATION_GREATER_THAN,
+	RELATION_GREATER_THAN_OR_EQUAL,
+	RELATION_LESS_THAN,
+	RELATION_LESS_THAN_OR_EQUAL,
+	RELATION_INVALID
+};
+
+/// The conditional operators.
+enum Conjunction : uint8_t {
+	CONJUNCTION_NONE,
+	CONJUNCTION_AND,
+	CONJUNCTION_OR,
+	CONJUNCTION_XOR
+};
+
+/// The kinds of compiled operations.
+enum Opcode : uint8_t {
+	OPCODE_HALT,
+	OPCODE_TRAP,
+	OPCODE_JUMP,
+
+	OPCODE_VALUE_INCREMENT,
+	OPCODE_VALUE_DECREMENT,
+	OPCODE_VALUE_OPERATION,
+
+	OPCODE_INDEX_INCREMENT,
+	OPCODE_INDEX_DECREMENT,
+
+	OPCODE_UNCERTAINTY_START,
+	OPCODE_UNCERTAINTY_END,
+
+	OPCODE_LOOP_START,
+	OPCODE_LOOP_END,
+
+	OPCODE_OUTPUT_WRITE,
+
+	OPCODE_INPUT_READ,
+	OPCODE_INPUT_ADD,
+	OPCODE_INPUT_XOR,
+	OPCODE_INPUT_AND,
+	OPCODE_INPUT_OR,
+
+	OPCODE_FILE_OPEN,
+	OPCODE_FILE_CLOSE,
+
+	OPCODE_BULK_READ,
+	OPCODE_BULK_WRITE,
+
+	OPCODE_MEMORY_FILL,
+	OPCODE_MEMORY_MOVE,
+	OPCODE_MEMORY_COMPARE,
+	OPCODE_UNCERTAINTY_ENTER,   // An uncertainty whose expression is known to be true, which jumps to its body.
+	OPCODE_COUNTED_LOOP_START,  // The start of an unrolled counted loop (see CountedLoop).
+	OPCODE_COUNTED_LOOP_END,    // The end of an unrolled counted loop, which repeats it while its counter isn't exhausted.
+	OPCODE_OUTPUT_TEXT          // OUTPUT_WRITE operations whose output is known, written at once.
+};
+
+/// The forms of the cell on which a VALUE_OPERATION is executed.
+enum TargetForm : uint8_t {
+	TARGET_CURRENT,    // (OP[NUM])
+	TARGET_CONSTANT,   // ([5]OP[NUM])
+	TARGET_EXPRESSION  // ([$i]OP[NUM])
+};
+
+/// The forms of the [NUM] operand of a VALUE_OPERATION.
+enum OperandForm : uint8_t {
+	FORM_CONSTANT,      // [5]
+	FORM_INDEX,         // [i], [i+5]
+	FORM_CELL,          // [$i5]
+	FORM_RELATIVE_CELL, // [$i], [$i+5]
+	FORM_EXPRESSION     // Everything else.
+};
+
+/// Represents a compiled [NUM].
+struct Operand {
+	/// The kind of the operand.
+	OperandType type;
+	/// Whether the value of the operand is negated.
+	bool negative;
+	/// The number or offset of the operand. For traps, the index of the error message.
+	uint32_t number;
+	/// The index of the nested operand, if any.
+	uint32_t nested;
+	/// The position reported if evaluating the operand fails.
+	uint32_t position;
+};
+
+/// Represents a compiled expression, chained to the next one by a conditional operator.
+struct Condition {
+	/// The index of the left operand.
+	uint32_t left;
+	/// The index of the right operand.
+	uint32_t right;
+	/// The relational operator.
+	Relation relation;
+	/// The conditional operator which chains the next expression.
+	Conjunction conjunction;
+	/// The index of the next expression, if any.
+	uint32_t next;
+	/// The position reported if the relational operator is invalid.
+	uint32_t position;
+	/// If AND skips the next expression, the interpreter resumes after AND. These are the operations
+	/// executed next in that case, if the whole expression is true, and if it is false (the skipped body).
+	uint32_t short_target;
+	uint32_t short_skip;
+};
+
+/// Represents a compiled instruction.
+struct Operation {
+	/// The body of the operation.
+	OperationBody body;
+	/// The kind of the operation.
+	Opcode code;
+	/// The operator of a VALUE_OPERATION, or the mode of a file operation.
+	char modifier;
+	/// The target form of a VALUE_OPERATION.
+	TargetForm target_form;
+	/// The operand form of a VALUE_OPERATION.
+	OperandForm operand_form;
+	/// The position of the instruction identifier in the script.
+	uint32_t position;
+	/// The position reported if the operation itself fails.
+	uint32_t error_position;
+	/// The index of the operand, condition or text used by the operation.
+	uint32_t argument;
+	/// The jump target, or the index of the target operand of a VALUE_OPERATION,
+	/// or the index of the second operand of the bulk and memory operations.
+	uint32_t target;
+	/// The number of the operand of a specialized VALUE_OPERATION, the index of the third operand of a memory operation,
+	/// or the index of the loop of a counted loop operation.
+	uint32_t value;
+	/// The target index of a VALUE_OPERATION with a constant target, or the index of the target operand of a MEMORY_COMPARE.
+	uint32_t target_value;
+	/// The reciprocal by which a VALUE_OPERATION divides 8-bit cells by a constant, or the mask of a remainder by a power of two.
+	uint16_t multiplier;
+	/// The amount of bits by which a VALUE_OPERATION shifts 8-bit cells to multiply or divide them by a constant.
+	uint8_t shift;
+};
+
+/// A cell to which every iteration of a counted loop applies the same constant.
+struct CellUpdate {
+	/// The index of the cell.
+	uint32_t cell;
+	/// The operator: OPERATOR_SET, OPERATOR_ADD or OPERATOR_SUBTRACT.
+	char modifier;
+	/// The constant, truncated to the cell width.
+	uint64_t operand;
+};
+
+/**
+ * A loop whose amount of iterations is known when it starts: {[$iK]GT[0] ... ([K]-[1]) ...}, where the counter K is only
+ * written by the decrement, once per iteration. Its body is straight-line code, which doesn't read input.
+ *
+ * The optimizer compiles it to a COUNTED_LOOP_START, followed by unroll copies of the body and a COUNTED_LOOP_END which
+ * repeats them without evaluating the expression, and then to the original loop, which executes the remaining iterations.
+ * The original loop also executes the whole loop if its counter is lower than unroll, or if the body may write the counter.
+ */
+struct CountedLoop {
+	/// The index of the counter.
+	uint32_t counter;
+	/// The amount of copies of the body.
+	uint32_t unroll;
+	/// How far the index moves in an iteration.
+	int64_t step;
+	/// The offsets from the index at the start of an iteration of the cells which are written at the index.
+	std::vector<int64_t> offsets;
+	/// If the body only applies constants to distinct constant cells, the cells; the loop is then executed at once, without copies.
+	std::vector<CellUpdate> updates;
+};
+
+/// Represents a compiled script.
+class Program {
+	public:
+		/// The script source.
+		std::string source;
+		/// The operations. Execution starts at the first one.
+		std::vector<Operation> operations;
+		/// The operands used by the operations.
+		std::vector<Operand> operands;
+		/// The expressions used by the operations.
+		std::vector<Condition> conditions;
+		/// The output formats, file names and error messages used by the operations.
+		std::vector<std::string> texts;
+		/// The counted loops found by the optimizer.
+		std::vector<CountedLoop> counted_loops;
+
+		/**
+		 * Gets the form of an operand, used to select a specialized VALUE_OPERATION.
+		 *
+		 * @param operand The index of the operand.
+		 *
+		 * @return The form of the operand.
+		 */
+		OperandForm getOperandForm(uint32_t operand) const;
+		/**
+		 * Checks whether the program may move the index far past the cells it writes, which is the case for
+		 * long runs of INDEX_INCREMENT, and for loops that move the index forwards without writing any cell.
+		 * Such programs are executed faster on a paged data pointer.
+		 *
+		 * @return True, if the program may use a wide range of the data pointer. False otherwise.
+		 */
+		bool hasWideAddressRange() const;
+		/**
+		 * Checks whether a loop applies the same VALUE_OPERATION to every cell of a range, one cell per iteration:
+		 * {[i]LT[5](OP[NUM])>}, where the relation is LT, LTE or NEQ, and [NUM] is a constant or an absolute cell.
+		 * INCREMENT and DECREMENT count as VALUE_OPERATIONs. Division and modulo are excluded.
+		 *
+		 * @param loop The index of the LOOP_START operation.
+		 *
+		 * @return True, if the loop is a range map. False otherwise.
+		 */
+		bool isRangeMap(uint32_t loop) const;
+		/**
+		 * Writes the operations in a readable form, one per line: the index, the kind of the operation,
+		 * its operands and expressions (written like in scripts), its jump targets and its position in the script.
+		 *
+		 * @param output The stream.
+		 */
+		void dump(std::ostream &output) const;
+};
+
+#endif
@@ -0,0 +1,111 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "range_map.h"
+
+// The operators are always inlined into the vector loops, so the ABI of vector arguments doesn't matter.
+#ifdef __GNUC__
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+#include "operators.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define X10_AVX2 __attribute__((target("avx2")))
+#endif
+
+#ifdef __GNUC__
+/**
+ * Applies an operator to a range of cells, one vector of BYTES bytes at a time.
+ * The cells after the last whole vector are processed one by one.
+ *
+ * @tparam OPERATOR The operator.
+ * @tparam Cell The type of the cells.
+ * @tparam BYTES The size of a vector, in bytes.
+ * @param cells The first cell of the range.
+ * @param count The amount of cells.
+ * @param operand The [NUM] operand of the operation.
+ */
+template<char OPERATOR, typename Cell, size_t BYTES>
+static inline __attribute__((always_inline)) void applyVectors(Cell *cells, size_t count, Cell operand) {
+	typedef Cell Vector __attribute__((vector_size(BYTES)));
+	const size_t lanes = BYTES / sizeof(Cell);
+
+	Vector operands = Vector{} + operand;
+	size_t i = 0;
+
+	for (; i + lanes <= count; i += lanes) {
+		Vector values;
+		memcpy(&values, cells + i, BYTES);
+		values = applyOperator<OPERATOR>(values, operands);
+		memcpy(cells + i, &values, BYTES);
+	}
+	for (; i < count; ++i)
+		cells[i] = applyOperator<OPERATOR>(cells[i], operand);
+}
+#endif
+
+#ifdef X10_AVX2
+template<char OPERATOR, typename Cell>
+X10_AVX2 static void applyAvx2(Cell *cells, size_t count, Cell operand) {
+	applyVectors<OPERATOR, Cell, 32>(cells, count, operand);
+}
+#endif
+
+template<char OPERATOR, typename Cell>
+static void applySse2(Cell *cells, size_t count, Cell operand) {
+#ifdef __GNUC__
+	applyVectors<OPERATOR, Cell, 16>(cells, count, operand);
+#else
+	for (size_t i = 0; i < count; ++i)
+		cells[i] = applyOperator<OPERATOR>(cells[i], operand);
+#endif
+}
+
+template<char OPERATOR, typename Cell>
+void applyRange(Cell *cells, size_t count, Cell operand) {
+#ifdef X10_AVX2
+	static const bool avx2 = __builtin_cpu_supports("avx2");
+
+	if (avx2) {
+		applyAvx2<OPERATOR, Cell>(cells, count, operand);
+		return;
+	}
+#endif
+	applySse2<OPERATOR, Cell>(cells, count, operand);
+}
+
+#define INSTANTIATE_RANGE(OPERATOR) \
+	template void applyRange<OPERATOR, uint8_t>(uint8_t*, size_t, uint8_t); \
+	template void applyRange<OPERATOR, uint16_t>(uint16_t*, size_t, uint16_t); \
+	template void applyRange<OPERATOR, uint32_t>(uint32_t*, size_t, uint32_t); \
+	template void applyRange<OPERATOR, uint64_t>(uint64_t*, size_t, uint64_t);
+
+INSTANTIATE_RANGE(OPERATOR_SET)
+INSTANTIATE_RANGE(OPERATOR_ADD)
+INSTANTIATE_RANGE(OPERATOR_SUBTRACT)
+INSTANTIATE_RANGE(OPERATOR_MULTIPLY)
+INSTANTIATE_RANGE(OPERATOR_XOR)
+INSTANTIATE_RANGE(OPERATOR_AND)
+INSTANTIATE_RANGE(OPERATOR_OR)
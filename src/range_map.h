@@ -0,0 +1,43 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef X10_RANGE_MAP_H
+#define X10_RANGE_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Applies a VALUE_OPERATION operator, with the same operand, to every cell of a contiguous range.
+ * The cells are processed as SIMD vectors; on x86, AVX2 is used when the processor supports it, and SSE2 otherwise.
+ * Instantiated for every operator except division and modulo, and for every cell width.
+ *
+ * @tparam OPERATOR The operator (see OPERATOR_*).
+ * @tparam Cell The type of the cells.
+ * @param cells The first cell of the range.
+ * @param count The amount of cells.
+ * @param operand The [NUM] operand of the operation.
+ */
+template<char OPERATOR, typename Cell>
+void applyRange(Cell *cells, size_t count, Cell operand);
+
+#endif
@@ -0,0 +1,263 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "record_map.h"
+#include "mapped_file.h"
+
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <thread>
+
+/// An input buffer which reads a record in place, without copying it.
+class RecordBuffer : public std::streambuf {
+	public:
+		/**
+		 * Replaces the record.
+		 *
+		 * @param begin The first byte of the record.
+		 * @param end The byte after the record.
+		 */
+		void set(const char *begin, const char *end) {
+			setg((char*) begin, (char*) begin, (char*) end);
+		}
+};
+
+/// A record which was executed, and waits to be written.
+struct MapSlot {
+	/// Everything the record wrote.
+	std::string output;
+	/// The error raised by the record, if any.
+	std::string error;
+	/// Whether the record was executed.
+	bool ready = false;
+};
+
+/// The state shared by the workers and the writer of a map run.
+class RecordMap {
+	public:
+		RecordMap(const uint8_t *data, size_t size, const MapOptions &options, size_t window) : slots(window) {
+			end = (const char*) data + size;
+			cursor = (const char*) data;
+			delimiter = options.delimiter;
+			record_size = options.record_size;
+		}
+
+		/**
+		 * Claims the next record. Waits while the reorder buffer is full.
+		 *
+		 * @param index The variable which will contain the index of the record.
+		 * @param first The variable which will contain the first byte of the record.
+		 * @param last The variable which will contain the byte after the record.
+		 *
+		 * @return True, if a record was claimed. False if there are no records left.
+		 */
+		bool claim(uint64_t &index, const char *&first, const char *&last) {
+			std::unique_lock<std::mutex> lock(mutex);
+			writable.wait(lock, [this] { return cursor >= end || claimed < written + slots.size(); });
+
+			if (cursor >= end)
+				return false;
+
+			first = cursor;
+			if (record_size != 0) {
+				last = (size_t) (end - cursor) < record_size ? end : cursor + record_size;
+				cursor = last;
+			}
+			else {
+				last = (const char*) memchr(cursor, delimiter, end - cursor);
+				if (last == nullptr)
+					last = end;
+				cursor = last == end ? end : last + 1;
+			}
+
+			index = claimed++;
+			return true;
+		}
+
+		/**
+		 * Stores the result of a record, for the writer.
+		 *
+		 * @param index The index of the record.
+		 * @param output Everything the record wrote.
+		 * @param error The error raised by the record, if any.
+		 */
+		void complete(uint64_t index, std::string &output, std::string &error) {
+			std::lock_guard<std::mutex> lock(mutex);
+			MapSlot &slot = slots[index % slots.size()];
+
+			slot.output.swap(output);
+			slot.error.swap(error);
+			slot.ready = true;
+			readable.notify_all();
+		}
+
+		/**
+		 * Writes the results of the records in input order, as they become ready, until every record is written.
+		 *
+		 * @param output The stream where the outputs are written.
+		 * @param errors The stream where the errors are written.
+		 * @param result The totals of the run.
+		 */
+		void write(std::ostream &output, std::ostream &errors, MapResult &result) {
+			std::string text, error;
+
+			while (true) {
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					MapSlot &slot = slots[written % slots.size()];
+
+					readable.wait(lock, [this, &slot] { return slot.ready || (cursor >= end && written == claimed); });
+					if (!slot.ready)
+						break;
+
+					text.swap(slot.output);
+					error.swap(slot.error);
+					slot.ready = false;
+					++written;
+					writable.notify_all();
+				}
+
+				output << text;
+				if (!error.empty()) {
+					errors << error;
+					++result.failed;
+				}
+				++result.records;
+			}
+		}
+
+		/// Wakes the writer after a worker stopped, so that it notices when every record was written.
+		void stop() {
+			std::lock_guard<std::mutex> lock(mutex);
+			readable.notify_all();
+		}
+
+	private:
+		/// The byte after the input.
+		const char *end;
+		/// The first byte of the next record.
+		const char *cursor;
+		char delimiter;
+		size_t record_size;
+
+		/// The reorder buffer. Record i waits in slot i % size.
+		std::vector<MapSlot> slots;
+		/// The amount of records which were claimed.
+		uint64_t claimed = 0;
+		/// The amount of records which were written.
+		uint64_t written = 0;
+
+		std::mutex mutex;
+		/// Signaled when a slot of the reorder buffer is freed.
+		std::condition_variable writable;
+		/// Signaled when a record is ready.
+		std::condition_variable readable;
+};
+
+/**
+ * Executes records until there are none left.
+ *
+ * @param map The map run.
+ * @param program The program.
+ * @param initial The initial data pointer.
+ * @param options The options of the run.
+ */
+static void executeRecords(RecordMap &map, const Program &program, const std::vector<uint8_t> &initial, const MapOptions &options) {
+	std::unique_ptr<ExecutionState> execution = createExecutionState(options.tape, options.cell_bits);
+	ExecutionState &state = *execution;
+
+	RecordBuffer buffer;
+	std::istream input(&buffer);
+	std::ostringstream output;
+	std::string text, error;
+
+	state.input = &input;
+	state.output = &output;
+	state.program = &program;
+	prepareExecution(state);
+
+	uint64_t index;
+	const char *first, *last;
+
+	while (map.claim(index, first, last)) {
+		buffer.set(first, last);
+		input.clear();
+		output.str(std::string());
+		output.clear();
+
+		// Every record starts with a fresh state.
+		state.setPointer(initial.data(), initial.size());
+		state.index = 0;
+		state.uncertainty_count = 0;
+		state.pc = 0;
+		state.loop_stack.clear();
+
+		try {
+			executeProgram(state);
+		}
+		catch (ExecutionError &e) {
+			error = "[ERROR] [Record " + std::to_string(index) + "] [Instruction " + std::to_string(e.position) + "]: " + e.what() + "\n";
+		}
+		catch (std::exception &e) {
+			error = "[ERROR] [Record " + std::to_string(index) + "] [Instruction " + std::to_string(program.operations[state.pc].error_position) + "]: " + e.what() + "\n";
+		}
+
+		delete state.file_input;
+		delete state.file_output;
+		state.file_input = nullptr;
+		state.file_output = nullptr;
+
+		text = output.str();
+		map.complete(index, text, error);
+		error.clear();
+	}
+
+	map.stop();
+}
+
+MapResult mapRecords(const Program &program, const std::vector<uint8_t> &initial, const MapOptions &options, std::ostream &output, std::ostream &errors) {
+	MappedFile file;
+	if (!file.open(options.input))
+		throw std::runtime_error("Cannot read the input file");
+
+	uint32_t jobs = options.jobs != 0 ? options.jobs : std::thread::hardware_concurrency();
+	if (jobs == 0)
+		jobs = 1;
+
+	RecordMap map(file.data(), file.size(), options, (size_t) jobs * MAP_WINDOW_PER_JOB);
+	MapResult result;
+
+	std::vector<std::thread> workers;
+	workers.reserve(jobs);
+	for (uint32_t i = 0; i < jobs; ++i)
+		workers.emplace_back(executeRecords, std::ref(map), std::cref(program), std::cref(initial), std::cref(options));
+
+	map.write(output, errors, result);
+
+	for (std::thread &worker : workers)
+		worker.join();
+	return result;
+}
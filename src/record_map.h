@@ -0,0 +1,77 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef X10_RECORD_MAP_H
+#define X10_RECORD_MAP_H
+
+#include "engine.h"
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+/// The amount of records which can wait in the reorder buffer, per worker.
+#define MAP_WINDOW_PER_JOB 16
+
+/// How a map run splits its input, and executes the records.
+struct MapOptions {
+	/// The input file, which is split into records.
+	const char *input = nullptr;
+	/// The character which ends each record. It is not part of the record.
+	char delimiter = '\n';
+	/// The size of each record, in bytes, or 0 if the records are delimited.
+	size_t record_size = 0;
+	/// The amount of worker threads, or 0 for one per core.
+	uint32_t jobs = 0;
+	/// The kind of data pointer of each record.
+	TapeKind tape = TAPE_DENSE;
+	/// The width of the cells, in bits.
+	uint8_t cell_bits = CELL_BITS_DEFAULT;
+};
+
+/// The totals of a map run.
+struct MapResult {
+	/// The amount of records.
+	uint64_t records = 0;
+	/// The amount of records which raised an error.
+	uint64_t failed = 0;
+};
+
+/**
+ * Executes a program once for every record of a memory-mapped input file. Each record is the input of
+ * its execution, and starts with a fresh copy of the initial data pointer. Records are executed by a pool
+ * of worker threads, and their outputs are written in input order through a bounded reorder buffer.
+ * Errors are written to the error stream, in input order, and don't stop the other records.
+ *
+ * @param program The program, which is bound for options.tape and options.cell_bits.
+ * @param initial The initial data pointer, as returned by ExecutionState::getPointer().
+ * @param options The options of the run.
+ * @param output The stream where the outputs are written.
+ * @param errors The stream where the errors are written.
+ *
+ * @return The totals of the run.
+ *
+ * @throws std::runtime_error If the input file cannot be read.
+ */
+MapResult mapRecords(const Program &program, const std::vector<uint8_t> &initial, const MapOptions &options, std::ostream &output, std::ostream &errors);
+
+#endif
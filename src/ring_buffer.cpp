@@ -0,0 +1,197 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "ring_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+/// Tells the processor that the thread is spinning.
+static inline void relaxProcessor() {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+RingBuffer::RingBuffer(size_t capacity) : data(new char[capacity]), mask(capacity - 1), head(0), reader_closed(false), reader_parked(false),
+                                          tail(0), writer_closed(false), writer_parked(false) { }
+
+void RingBuffer::write(const char *bytes, size_t size) {
+	size_t capacity = mask + 1;
+
+	while (size > 0) {
+		uint64_t position = tail.load(std::memory_order_relaxed);
+
+		// The head is only read again when the buffer looks full.
+		if (position - cached_head == capacity) {
+			await([this, position, capacity] {
+				return position - head.load() != capacity || reader_closed.load();
+			}, writer_parked, writable);
+			cached_head = head.load(std::memory_order_acquire);
+		}
+		if (reader_closed.load(std::memory_order_acquire))
+			return;
+
+		size_t count = std::min<size_t>(size, capacity - (size_t) (position - cached_head));
+		size_t offset = (size_t) position & mask;
+		size_t first = std::min(count, capacity - offset);
+
+		memcpy(data.get() + offset, bytes, first);
+		memcpy(data.get(), bytes + first, count - first);
+
+		tail.store(position + count);
+		wake(reader_parked, readable);
+
+		bytes += count;
+		size -= count;
+	}
+}
+
+size_t RingBuffer::read(char *bytes, size_t size) {
+	size_t capacity = mask + 1;
+	uint64_t position = head.load(std::memory_order_relaxed);
+
+	// The tail is only read again when the buffer looks empty.
+	if (cached_tail == position) {
+		cached_tail = tail.load(std::memory_order_acquire);
+		if (cached_tail == position) {
+			await([this, position] {
+				return tail.load() != position || writer_closed.load();
+			}, reader_parked, readable);
+			cached_tail = tail.load(std::memory_order_acquire);
+			if (cached_tail == position)
+				return 0;
+		}
+	}
+
+	size_t count = std::min<size_t>(size, (size_t) (cached_tail - position));
+	size_t offset = (size_t) position & mask;
+	size_t first = std::min(count, capacity - offset);
+
+	memcpy(bytes, data.get() + offset, first);
+	memcpy(bytes + first, data.get(), count - first);
+
+	head.store(position + count);
+	wake(writer_parked, writable);
+	return count;
+}
+
+void RingBuffer::closeWriter() {
+	writer_closed.store(true);
+	wake(reader_parked, readable);
+}
+
+void RingBuffer::closeReader() {
+	reader_closed.store(true);
+	wake(writer_parked, writable);
+}
+
+template<typename Condition>
+void RingBuffer::await(Condition ready, std::atomic<bool> &parked, std::condition_variable &signal) {
+	for (uint32_t i = 0; i < RING_SPIN_COUNT; ++i) {
+		if (ready())
+			return;
+		relaxProcessor();
+	}
+	for (uint32_t i = 0; i < RING_YIELD_COUNT; ++i) {
+		if (ready())
+			return;
+		std::this_thread::yield();
+	}
+
+	// The flag is set before the condition is checked again, and the other side checks the flag after it changes the
+	// condition, so at least one of them sees the other.
+	std::unique_lock<std::mutex> lock(mutex);
+	parked.store(true);
+	signal.wait(lock, ready);
+	parked.store(false, std::memory_order_relaxed);
+}
+
+void RingBuffer::wake(std::atomic<bool> &parked, std::condition_variable &signal) {
+	if (parked.load()) {
+		std::lock_guard<std::mutex> lock(mutex);
+		signal.notify_one();
+	}
+}
+
+RingOutputBuffer::RingOutputBuffer(RingBuffer &ring) : ring(ring) {
+	setp(batch, batch + RING_BATCH_SIZE);
+}
+
+void RingOutputBuffer::close() {
+	sync();
+	ring.closeWriter();
+}
+
+RingOutputBuffer::int_type RingOutputBuffer::overflow(int_type c) {
+	sync();
+	if (!traits_type::eq_int_type(c, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+std::streamsize RingOutputBuffer::xsputn(const char *bytes, std::streamsize count) {
+	// Writes which fit are gathered, and larger ones are handed over directly.
+	if (count <= epptr() - pptr()) {
+		memcpy(pptr(), bytes, (size_t) count);
+		pbump((int) count);
+	}
+	else {
+		sync();
+		ring.write(bytes, (size_t) count);
+	}
+	return count;
+}
+
+int RingOutputBuffer::sync() {
+	if (pptr() != pbase()) {
+		ring.write(pbase(), (size_t) (pptr() - pbase()));
+		setp(batch, batch + RING_BATCH_SIZE);
+	}
+	return 0;
+}
+
+RingInputBuffer::RingInputBuffer(RingBuffer &ring) : ring(ring) {
+	setg(batch, batch, batch);
+}
+
+void RingInputBuffer::close() {
+	ring.closeReader();
+}
+
+RingInputBuffer::int_type RingInputBuffer::underflow() {
+	if (gptr() < egptr())
+		return traits_type::to_int_type(*gptr());
+
+	size_t count = ring.read(batch, RING_BATCH_SIZE);
+	if (count == 0)
+		return traits_type::eof();
+
+	setg(batch, batch, batch + count);
+	return traits_type::to_int_type(*gptr());
+}
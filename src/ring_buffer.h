@@ -0,0 +1,160 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef X10_RING_BUFFER_H
+#define X10_RING_BUFFER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+
+/// The capacity of a ring buffer, in bytes. Must be a power of two.
+#define RING_CAPACITY (1u << 16)
+/// The amount of bytes which a ring stream buffer gathers before handing them over.
+#define RING_BATCH_SIZE 4096
+/// The amount of times a blocked side of a ring buffer spins before it yields.
+#define RING_SPIN_COUNT 256
+/// The amount of times a blocked side of a ring buffer yields before it parks.
+#define RING_YIELD_COUNT 16
+
+/// The size of a cache line, which separates the positions written by the two sides of a ring buffer.
+#define CACHE_LINE_SIZE 64
+
+/**
+ * A lock-free buffer of bytes, with a single writer and a single reader.
+ * A side which has to wait spins, then yields, and finally parks until the other side wakes it.
+ * The mutex is only taken to park, and to wake a parked side.
+ */
+class RingBuffer {
+	public:
+		/// @param capacity The capacity of the buffer, in bytes. Must be a power of two.
+		explicit RingBuffer(size_t capacity = RING_CAPACITY);
+
+		/**
+		 * Writes bytes to the buffer, waiting while it is full.
+		 * The bytes are discarded if the reader is closed.
+		 *
+		 * @param bytes The bytes to write.
+		 * @param size The amount of bytes.
+		 */
+		void write(const char *bytes, size_t size);
+		/**
+		 * Reads the bytes which are available, waiting until there are any.
+		 *
+		 * @param bytes Where to read the bytes.
+		 * @param size The maximum amount of bytes.
+		 *
+		 * @return The amount of bytes read, or 0 if the writer is closed and every byte was read.
+		 */
+		size_t read(char *bytes, size_t size);
+
+		/// Marks the end of the bytes, and wakes the reader.
+		void closeWriter();
+		/// Marks that no more bytes will be read, and wakes the writer.
+		void closeReader();
+
+	private:
+		/**
+		 * Waits until a condition holds: spins, then yields, and finally parks.
+		 *
+		 * @param ready The condition.
+		 * @param parked The flag which tells the other side that this side is parked.
+		 * @param signal The variable on which this side parks.
+		 */
+		template<typename Condition>
+		void await(Condition ready, std::atomic<bool> &parked, std::condition_variable &signal);
+		/**
+		 * Wakes the other side, if it is parked.
+		 *
+		 * @param parked The flag of the other side.
+		 * @param signal The variable on which the other side parks.
+		 */
+		void wake(std::atomic<bool> &parked, std::condition_variable &signal);
+
+		std::unique_ptr<char[]> data;
+		size_t mask;
+
+		/// The amount of bytes which were read. Written by the reader.
+		alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head;
+		/// The last value of tail seen by the reader.
+		uint64_t cached_tail = 0;
+		/// Whether the reader is closed.
+		std::atomic<bool> reader_closed;
+		/// Whether the reader is parked.
+		std::atomic<bool> reader_parked;
+
+		/// The amount of bytes which were written. Written by the writer.
+		alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail;
+		/// The last value of head seen by the writer.
+		uint64_t cached_head = 0;
+		/// Whether the writer is closed.
+		std::atomic<bool> writer_closed;
+		/// Whether the writer is parked.
+		std::atomic<bool> writer_parked;
+
+		alignas(CACHE_LINE_SIZE) std::mutex mutex;
+		/// Signaled when bytes were written, or the writer was closed.
+		std::condition_variable readable;
+		/// Signaled when bytes were read, or the reader was closed.
+		std::condition_variable writable;
+};
+
+/// An output buffer which gathers bytes, and writes them to a ring buffer in batches.
+class RingOutputBuffer : public std::streambuf {
+	public:
+		explicit RingOutputBuffer(RingBuffer &ring);
+
+		/// Writes the gathered bytes, and closes the writer of the ring buffer.
+		void close();
+
+	protected:
+		int_type overflow(int_type c) override;
+		std::streamsize xsputn(const char *bytes, std::streamsize count) override;
+		int sync() override;
+
+	private:
+		RingBuffer &ring;
+		char batch[RING_BATCH_SIZE];
+};
+
+/// An input buffer which reads a ring buffer in batches.
+class RingInputBuffer : public std::streambuf {
+	public:
+		explicit RingInputBuffer(RingBuffer &ring);
+
+		/// Closes the reader of the ring buffer, which discards the bytes written from now on.
+		void close();
+
+	protected:
+		int_type underflow() override;
+
+	private:
+		RingBuffer &ring;
+		char batch[RING_BATCH_SIZE];
+};
+
+#endif
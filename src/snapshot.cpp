@@ -0,0 +1,254 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "snapshot.h"
+#include "hash.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+/// Marks a file which is not open.
+#define SNAPSHOT_NO_FILE 0xFFFFFFFFu
+
+/**
+ * Writes a value to a snapshot.
+ *
+ * @param stream The snapshot stream.
+ * @param value The value to write.
+ */
+template<typename T>
+static void writeValue(std::ostream &stream, T value) {
+	stream.write((const char*) &value, sizeof(T));
+}
+
+/**
+ * Writes an open file to a snapshot.
+ *
+ * @param stream The snapshot stream.
+ * @param open Whether the file is open.
+ * @param name The name of the file.
+ * @param offset The offset in the file, or -1 if the end of the file was reached.
+ */
+static void writeFile(std::ostream &stream, bool open, const std::string &name, int64_t offset) {
+	if (!open) {
+		writeValue<uint32_t>(stream, SNAPSHOT_NO_FILE);
+		return;
+	}
+
+	writeValue<uint32_t>(stream, (uint32_t) name.size());
+	stream.write(name.data(), name.size());
+	writeValue<int64_t>(stream, offset);
+}
+
+void writeSnapshot(std::ostream &stream, ExecutionState &state) {
+	const Program &program = *state.program;
+
+	int64_t input_offset = -1;
+	if (state.file_input != nullptr)
+		input_offset = (int64_t) state.file_input->tellg();
+
+	int64_t output_offset = -1;
+	if (state.file_output != nullptr) {
+		state.file_output->flush();
+		output_offset = (int64_t) state.file_output->tellp();
+	}
+
+	stream.write(SNAPSHOT_MAGIC, 4);
+	writeValue<uint32_t>(stream, SNAPSHOT_VERSION);
+	writeValue<uint64_t>(stream, hashBytes(program.source.data(), program.source.size()));
+	writeValue<uint32_t>(stream, state.getCellBits());
+	writeValue<uint32_t>(stream, state.index);
+	writeValue<uint32_t>(stream, state.uncertainty_count);
+	writeValue<uint32_t>(stream, state.pc);
+
+	writeValue<uint32_t>(stream, (uint32_t) state.loop_stack.size());
+	stream.write((const char*) state.loop_stack.data(), state.loop_stack.size() * sizeof(uint32_t));
+
+	writeFile(stream, state.file_input != nullptr, state.file_input_name, input_offset);
+	writeFile(stream, state.file_output != nullptr, state.file_output_name, output_offset);
+
+	std::vector<uint8_t> pointer;
+	state.getPointer(pointer);
+	writeValue<uint64_t>(stream, state.getSize());
+	stream.write((const char*) pointer.data(), pointer.size());
+}
+
+void saveSnapshot(const char *file, ExecutionState &state) {
+	std::string temporary = std::string(file) + ".tmp";
+	std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+	if (stream.fail())
+		throw std::runtime_error("Cannot write the snapshot");
+
+	writeSnapshot(stream, state);
+
+	stream.close();
+	if (stream.fail())
+		throw std::runtime_error("Cannot write the snapshot");
+
+	std::error_code error;
+	std::filesystem::rename(temporary, file, error);
+	if (error)
+		throw std::runtime_error("Cannot write the snapshot");
+}
+
+/// Reads values from a mapped snapshot.
+class SnapshotReader {
+	public:
+		SnapshotReader(const uint8_t *data, size_t size) : data(data), size(size), offset(0) { }
+
+		/**
+		 * Reads bytes from the snapshot.
+		 *
+		 * @param count The amount of bytes.
+		 *
+		 * @return The bytes.
+		 *
+		 * @throws std::runtime_error If the snapshot ends before the bytes.
+		 */
+		const uint8_t *read(size_t count) {
+			if (count > size - offset)
+				throw std::runtime_error("Invalid snapshot");
+
+			const uint8_t *bytes = data + offset;
+			offset += count;
+			return bytes;
+		}
+
+		/// Reads a value from the snapshot.
+		template<typename T>
+		T readValue() {
+			T value;
+			memcpy(&value, read(sizeof(T)), sizeof(T));
+			return value;
+		}
+
+		/**
+		 * Reads an open file from the snapshot.
+		 *
+		 * @param name The variable which will contain the name of the file.
+		 * @param offset The variable which will contain the offset in the file.
+		 *
+		 * @return True, if the file was open. False otherwise.
+		 */
+		bool readFile(std::string &name, int64_t &offset) {
+			uint32_t length = readValue<uint32_t>();
+			if (length == SNAPSHOT_NO_FILE)
+				return false;
+
+			name.assign((const char*) read(length), length);
+			offset = readValue<int64_t>();
+			return true;
+		}
+
+		/// Whether the whole snapshot was read.
+		bool done() const { return offset == size; }
+
+	private:
+		const uint8_t *data;
+		size_t size;
+		size_t offset;
+};
+
+void readSnapshot(const uint8_t *data, size_t size, ExecutionState &state) {
+	const Program &program = *state.program;
+	SnapshotReader reader(data, size);
+
+	if (memcmp(reader.read(4), SNAPSHOT_MAGIC, 4) != 0 || reader.readValue<uint32_t>() != SNAPSHOT_VERSION)
+		throw std::runtime_error("Invalid snapshot");
+	if (reader.readValue<uint64_t>() != hashBytes(program.source.data(), program.source.size()))
+		throw std::runtime_error("The snapshot was taken from another script");
+
+	uint32_t cell_bits = reader.readValue<uint32_t>();
+	if (cell_bits != state.getCellBits())
+		throw std::runtime_error("The snapshot was taken with --cell-bits=" + std::to_string(cell_bits));
+
+	state.index = reader.readValue<uint32_t>();
+	state.uncertainty_count = reader.readValue<uint32_t>();
+	state.pc = reader.readValue<uint32_t>();
+	if (state.pc > program.operations.size())
+		throw std::runtime_error("Invalid snapshot");
+
+	// The depth is checked before anything is allocated, so that corrupt snapshots can't allocate gigabytes.
+	uint32_t depth = reader.readValue<uint32_t>();
+	const uint8_t *starts = reader.read((size_t) depth * sizeof(uint32_t));
+	if (depth > std::count_if(program.operations.begin(), program.operations.end(), [](const Operation &operation) { return operation.code == OPCODE_LOOP_START; }))
+		throw std::runtime_error("Invalid snapshot");
+
+	state.loop_stack.resize(depth);
+	memcpy(state.loop_stack.data(), starts, depth * sizeof(uint32_t));
+
+	for (uint32_t start : state.loop_stack)
+		if (start >= program.operations.size() || program.operations[start].code != OPCODE_LOOP_START)
+			throw std::runtime_error("Invalid snapshot");
+
+	std::string input_name, output_name;
+	int64_t input_offset = -1, output_offset = -1;
+	bool input_open = reader.readFile(input_name, input_offset);
+	bool output_open = reader.readFile(output_name, output_offset);
+
+	uint64_t cells = reader.readValue<uint64_t>();
+	if (cells == 0 || cells > 0xFFFFFFFFull)
+		throw std::runtime_error("Invalid snapshot");
+
+	cells *= cell_bits / 8;
+	const uint8_t *pointer = reader.read(cells);
+	state.setPointer(pointer, cells);
+
+	if (!reader.done())
+		throw std::runtime_error("Invalid snapshot");
+
+	if (input_open) {
+		state.file_input = new std::ifstream(input_name);
+		state.file_input_name = input_name;
+
+		if (input_offset == -1)
+			state.file_input->seekg(0, std::ios::end);
+		else state.file_input->seekg(input_offset);
+	}
+
+	if (output_open) {
+		// Discard what was written after the snapshot was taken.
+		std::error_code error;
+		if (output_offset != -1)
+			std::filesystem::resize_file(output_name, output_offset, error);
+
+		state.file_output = new std::ofstream(output_name, std::ios::in | std::ios::out);
+		if (state.file_output->fail()) {
+			delete state.file_output;
+			state.file_output = new std::ofstream(output_name);
+		}
+		state.file_output_name = output_name;
+
+		if (output_offset != -1)
+			state.file_output->seekp(output_offset);
+	}
+}
+
+void loadSnapshot(const char *file, ExecutionState &state) {
+	MappedFile snapshot;
+	if (!snapshot.open(file))
+		throw std::runtime_error("Cannot read the snapshot");
+
+	readSnapshot(snapshot.data(), snapshot.size(), state);
+}
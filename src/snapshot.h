@@ -0,0 +1,74 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef X10_SNAPSHOT_H
+#define X10_SNAPSHOT_H
+
+#include "engine.h"
+
+/// The first bytes of a snapshot file.
+#define SNAPSHOT_MAGIC "X10S"
+/// The version of the snapshot format.
+#define SNAPSHOT_VERSION 2u
+
+/**
+ * Writes the state of a suspended program to a stream, in the format of a snapshot file.
+ *
+ * @param stream The stream, which is opened in binary mode.
+ * @param state The execution state.
+ */
+void writeSnapshot(std::ostream &stream, ExecutionState &state);
+/**
+ * Writes the state of a suspended program to a snapshot file.
+ * The state contains the data pointer, the index, the loop stack, the amount of open uncertainties,
+ * the operation which is executed next, and the open files along with their offsets.
+ * The snapshot is written to a temporary file first, which then replaces the snapshot file.
+ *
+ * @param file The snapshot file.
+ * @param state The execution state.
+ *
+ * @throws std::runtime_error If the snapshot cannot be written.
+ */
+void saveSnapshot(const char *file, ExecutionState &state);
+/**
+ * Restores the state of a program from the bytes of a snapshot.
+ * Open files are reopened at their offsets. Output files are truncated to their offsets.
+ *
+ * @param data The bytes of the snapshot.
+ * @param size The amount of bytes.
+ * @param state The execution state, which contains the program the snapshot was taken from.
+ *
+ * @throws std::runtime_error If the snapshot is invalid, or was taken from another script or with another cell width.
+ */
+void readSnapshot(const uint8_t *data, size_t size, ExecutionState &state);
+/**
+ * Restores the state of a program from a memory-mapped snapshot file.
+ * Open files are reopened at their offsets. Output files are truncated to their offsets.
+ *
+ * @param file The snapshot file.
+ * @param state The execution state, which contains the program the snapshot was taken from.
+ *
+ * @throws std::runtime_error If the snapshot is invalid, or was taken from another script or with another cell width.
+ */
+void loadSnapshot(const char *file, ExecutionState &state);
+
+#endif
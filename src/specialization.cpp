@@ -0,0 +1,118 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "specialization.h"
+#include "execution_key.h"
+#include "snapshot.h"
+#include "hash.h"
+#include "mapped_file.h"
+
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <sstream>
+
+std::string getSpecializationFile(const std::string &directory, const Program &program, uint32_t argc, char *argv[], uint8_t cell_bits, bool optimized) {
+	// The saved state refers to the operations compiled by this build of the interpreter, which is part of the key.
+	uint64_t hash = hashExecutionKey(SPECIALIZATION_VERSION, program, argc, argv, cell_bits);
+	hash = hashBytes(&optimized, sizeof(optimized), hash);
+	return getExecutionKeyFile(directory, hash, SPECIALIZATION_EXTENSION);
+}
+
+std::string specializeProgram(ExecutionState &state) {
+	std::ostream *output = state.output;
+	std::ostringstream setup;
+
+	state.output = &setup;
+	state.suspend_before_input = true;
+
+	try {
+		executeProgram(state);
+	}
+	catch (ExecutionSuspended &e) {
+		// The program reads input next.
+	}
+	catch (...) {
+		state.output = output;
+		state.suspend_before_input = false;
+		*output << setup.str();
+		throw;
+	}
+
+	state.output = output;
+	state.suspend_before_input = false;
+	*output << setup.str();
+	return setup.str();
+}
+
+void saveSpecialization(const char *file, ExecutionState &state, const std::string &output) {
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(file).parent_path(), error);
+
+	// Concurrent executions write the same specialization, so each one writes its own temporary file.
+	std::string temporary = std::string(file) + ".tmp" + std::to_string(std::random_device()());
+	std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+	if (stream.fail())
+		throw std::runtime_error("Cannot write the specialization");
+
+	uint32_t version = SPECIALIZATION_VERSION;
+	uint64_t length = output.size();
+	stream.write(SPECIALIZATION_MAGIC, 4);
+	stream.write((const char*) &version, sizeof(version));
+	stream.write((const char*) &length, sizeof(length));
+	stream.write(output.data(), output.size());
+	writeSnapshot(stream, state);
+
+	stream.close();
+	if (stream.fail()) {
+		std::filesystem::remove(temporary, error);
+		throw std::runtime_error("Cannot write the specialization");
+	}
+
+	std::filesystem::rename(temporary, file, error);
+	if (error) {
+		std::filesystem::remove(temporary, error);
+		throw std::runtime_error("Cannot write the specialization");
+	}
+}
+
+bool loadSpecialization(const char *file, ExecutionState &state) {
+	MappedFile specialization;
+	if (!specialization.open(file))
+		return false;
+
+	const uint8_t *data = specialization.data();
+	size_t size = specialization.size();
+	uint32_t version;
+	uint64_t length;
+
+	if (size < 16 || memcmp(data, SPECIALIZATION_MAGIC, 4) != 0)
+		throw std::runtime_error("Invalid specialization");
+	memcpy(&version, data + 4, sizeof(version));
+	memcpy(&length, data + 8, sizeof(length));
+	if (version != SPECIALIZATION_VERSION || length > size - 16)
+		throw std::runtime_error("Invalid specialization");
+
+	readSnapshot(data + 16 + length, size - 16 - length, state);
+	state.output->write((const char*) data + 16, (std::streamsize) length);
+	return true;
+}
@@ -0,0 +1,86 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef X10_SPECIALIZATION_H
+#define X10_SPECIALIZATION_H
+
+#include "engine.h"
+
+#include <string>
+
+/// The first bytes of a specialization file.
+#define SPECIALIZATION_MAGIC "X10P"
+/// The version of the specialization format.
+#define SPECIALIZATION_VERSION 1u
+/// The extension of specialization files.
+#define SPECIALIZATION_EXTENSION ".x10p"
+
+/**
+ * Gets the file which contains the specialization of a script for a set of arguments.
+ * The name of the file is the hash of the script, the arguments, the cell width, whether the script is optimized and the
+ * build of the interpreter, since the saved state refers to the operations it compiled.
+ *
+ * @param directory The directory of the specializations.
+ * @param program The compiled script.
+ * @param argc The amount of arguments which initialize the data pointer.
+ * @param argv The arguments which initialize the data pointer.
+ * @param cell_bits The width of the cells.
+ * @param optimized Whether the program was optimized.
+ *
+ * @return The path of the specialization file.
+ */
+std::string getSpecializationFile(const std::string &directory, const Program &program, uint32_t argc, char *argv[], uint8_t cell_bits, bool optimized);
+/**
+ * Executes a program until it first reads input, or until it ends. Execution can then be resumed from the state.
+ * The output written until then is buffered, and then written to the output of the state.
+ *
+ * @param state The execution state, which is initialized from the arguments.
+ *
+ * @return The output written until the program was suspended.
+ *
+ * @throws ExecutionError If the program raises an error before reading input.
+ */
+std::string specializeProgram(ExecutionState &state);
+/**
+ * Writes the state of a program, which was suspended by specializeProgram(), to a specialization file.
+ * The directory is created if needed. The specialization is written to a temporary file first, which then replaces the specialization file.
+ *
+ * @param file The specialization file.
+ * @param state The execution state.
+ * @param output The output written until the program was suspended.
+ *
+ * @throws std::runtime_error If the specialization cannot be written.
+ */
+void saveSpecialization(const char *file, ExecutionState &state, const std::string &output);
+/**
+ * Restores the state of a program from a specialization file, and writes the output saved along with it.
+ *
+ * @param file The specialization file.
+ * @param state The execution state, which contains the program the specialization was made from.
+ *
+ * @return True, if the specialization was loaded. False, if the file doesn't exist.
+ *
+ * @throws std::runtime_error If the specialization is invalid.
+ */
+bool loadSpecialization(const char *file, ExecutionState &state);
+
+#endif
@@ -0,0 +1,134 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tape.h"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+/// The page which is read instead of the pages which were never written. It is never written.
+template<typename Cell>
+static Cell zero_page[PAGE_SIZE];
+
+template<typename Cell>
+PagedTape<Cell>::PagedTape() {
+	length = 0;
+	cached_page = SIZE_MAX;
+	cached = zero_page<Cell>;
+	cached_writable = false;
+}
+
+template<typename Cell>
+void PagedTape<Cell>::resize(size_t size) {
+	if (size < length) {
+		// Clear the removed cells, so that they are 0 if they are added again.
+		for (size_t page = (size + PAGE_SIZE - 1) >> PAGE_BITS; page < pages.size(); ++page)
+			pages[page].reset();
+		if ((size & (PAGE_SIZE - 1)) != 0 && (size >> PAGE_BITS) < pages.size() && pages[size >> PAGE_BITS])
+			memset(pages[size >> PAGE_BITS].get() + (size & (PAGE_SIZE - 1)), 0, (PAGE_SIZE - (size & (PAGE_SIZE - 1))) * sizeof(Cell));
+
+		cached_page = SIZE_MAX;
+	}
+	length = size;
+}
+
+template<typename Cell>
+void PagedTape<Cell>::push_back(Cell value) {
+	++length;
+	if (value != 0)
+		(*this)[length - 1] = value;
+}
+
+template<typename Cell>
+Cell PagedTape<Cell>::at(size_t index) const {
+	if (index >= length) {
+#ifdef __GLIBCXX__
+		char message[128];
+		snprintf(message, sizeof(message), "vector::_M_range_check: __n (which is %zu) >= this->size() (which is %zu)", index, length);
+		throw std::out_of_range(message);
+#else
+		// Raise the error which the standard library raises for an invalid index.
+		std::vector<Cell>().at(index);
+#endif
+	}
+	return (*this)[index];
+}
+
+template<typename Cell>
+void PagedTape<Cell>::assign(const uint8_t *bytes, size_t size) {
+	pages.clear();
+	pages.reserve(INITIAL_PAGE_CAPACITY);
+	length = size;
+	cached_page = SIZE_MAX;
+
+	for (size_t start = 0; start < size; start += PAGE_SIZE) {
+		size_t count = size - start < PAGE_SIZE ? size - start : PAGE_SIZE;
+
+		if (memcmp(bytes + start * sizeof(Cell), zero_page<Cell>, count * sizeof(Cell)) != 0)
+			memcpy(&(*this)[start], bytes + start * sizeof(Cell), count * sizeof(Cell));
+	}
+}
+
+template<typename Cell>
+void PagedTape<Cell>::copy(std::vector<uint8_t> &bytes) const {
+	bytes.assign(length * sizeof(Cell), 0);
+
+	for (size_t page = 0; page < pages.size(); ++page) {
+		size_t start = page << PAGE_BITS;
+		if (pages[page] && start < length)
+			memcpy(bytes.data() + start * sizeof(Cell), pages[page].get(), (length - start < PAGE_SIZE ? length - start : PAGE_SIZE) * sizeof(Cell));
+	}
+}
+
+template<typename Cell>
+size_t PagedTape<Cell>::getPageCount() const {
+	size_t count = 0;
+	for (const std::unique_ptr<Cell[]> &page : pages)
+		count += page ? 1 : 0;
+	return count;
+}
+
+template<typename Cell>
+void PagedTape<Cell>::cachePage(size_t page) const {
+	cached_page = page;
+	cached_writable = page < pages.size() && pages[page];
+	cached = cached_writable ? pages[page].get() : zero_page<Cell>;
+}
+
+template<typename Cell>
+void PagedTape<Cell>::allocatePage(size_t page) {
+	if (page >= pages.size())
+		pages.resize(page + 1);
+	if (!pages[page])
+		pages[page].reset(new Cell[PAGE_SIZE]());
+
+	cached_page = page;
+	cached_writable = true;
+	cached = pages[page].get();
+}
+
+template class PagedTape<uint8_t>;
+template class PagedTape<uint16_t>;
+template class PagedTape<uint32_t>;
+template class PagedTape<uint64_t>;
@@ -0,0 +1,133 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef X10_TAPE_H
+#define X10_TAPE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// The amount of cells in a page of a paged data pointer, as a power of 2.
+#define PAGE_BITS 12
+/// The amount of cells in a page of a paged data pointer.
+#define PAGE_SIZE (1u << PAGE_BITS)
+/// The amount of pages for which the page table is reserved.
+#define INITIAL_PAGE_CAPACITY 256
+
+/**
+ * A data pointer which is split into fixed-size pages. Pages are allocated when they are first written,
+ * and pages which were never written are read from a shared page of zeros.
+ * It behaves like the std::vector<Cell> data pointer, and implements the part of its interface which the engine uses.
+ *
+ * @tparam Cell The type of the cells.
+ */
+template<typename Cell>
+class PagedTape {
+	public:
+		typedef Cell value_type;
+
+		PagedTape();
+
+		/// Gets the amount of cells.
+		size_t size() const { return length; }
+		/// Adds cells, or removes them from the end.
+		void resize(size_t size);
+		/// Adds a cell at the end.
+		void push_back(Cell value);
+
+		/**
+		 * Gets the value at an index, like std::vector<Cell>::at() does.
+		 *
+		 * @param index The index.
+		 *
+		 * @return The value.
+		 *
+		 * @throws std::out_of_range If the index is invalid.
+		 */
+		Cell at(size_t index) const;
+
+		/// Reads the value at a valid index.
+		Cell operator[](size_t index) const {
+			size_t page = index >> PAGE_BITS;
+			if (page != cached_page)
+				cachePage(page);
+			return cached[index & (PAGE_SIZE - 1)];
+		}
+
+		/// Reads the values from a valid index to the end of its page.
+		const Cell *run(size_t index) const {
+			size_t page = index >> PAGE_BITS;
+			if (page != cached_page)
+				cachePage(page);
+			return cached + (index & (PAGE_SIZE - 1));
+		}
+
+		/// Gets the value at a valid index, in order to write it. The page is allocated, if needed.
+		Cell &operator[](size_t index) {
+			size_t page = index >> PAGE_BITS;
+			if (page != cached_page || !cached_writable)
+				allocatePage(page);
+			return cached[index & (PAGE_SIZE - 1)];
+		}
+
+		/**
+		 * Replaces the cells. Only the pages which contain values other than 0 are allocated.
+		 *
+		 * @param bytes The cells, as they are stored in memory.
+		 * @param size The amount of cells.
+		 */
+		void assign(const uint8_t *bytes, size_t size);
+		/**
+		 * Copies the cells into a buffer, as they are stored in memory.
+		 *
+		 * @param bytes The buffer.
+		 */
+		void copy(std::vector<uint8_t> &bytes) const;
+
+		/// Gets the amount of allocated pages.
+		size_t getPageCount() const;
+
+	private:
+		/// The pages, or nullptr for the pages which were never written.
+		std::vector<std::unique_ptr<Cell[]>> pages;
+		/// The amount of cells.
+		size_t length;
+
+		/// The page which was accessed last.
+		mutable size_t cached_page;
+		/// The cells of the page which was accessed last, or the page of zeros.
+		mutable Cell *cached;
+		/// Whether the cached page can be written (i.e. it is not the page of zeros).
+		mutable bool cached_writable;
+
+		void cachePage(size_t page) const;
+		void allocatePage(size_t page);
+};
+
+extern template class PagedTape<uint8_t>;
+extern template class PagedTape<uint16_t>;
+extern template class PagedTape<uint32_t>;
+extern template class PagedTape<uint64_t>;
+
+#endif
@@ -0,0 +1,266 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "trace.h"
+#include "hash.h"
+#include "mapped_file.h"
+
+#include <cstring>
+
+/// The events which are stored after the header. A value is stored as (zigzag(difference) << 1).
+#define TRACE_EVENT_CHECKPOINT 1u
+#define TRACE_EVENT_END 3u
+#define TRACE_EVENT_BLOCK 5u
+
+ExecutionTrace::~ExecutionTrace() = default;
+
+std::unique_ptr<ExecutionTrace> ExecutionTrace::record(const char *file, const Program &program, uint8_t cell_bits, uint32_t argc,
+                                                       char *argv[], uint32_t checkpoint_period) {
+	std::unique_ptr<ExecutionTrace> trace(new ExecutionTrace());
+	trace->checkpoint_period = checkpoint_period;
+	trace->stream.open(file, std::ios::binary | std::ios::trunc);
+	if (trace->stream.fail())
+		throw std::runtime_error("Cannot write the trace");
+
+	uint64_t hash = hashBytes(program.source.data(), program.source.size());
+	uint32_t version = TRACE_VERSION;
+	uint32_t bits = cell_bits;
+
+	trace->stream.write(TRACE_MAGIC, 4);
+	trace->stream.write((const char*) &version, sizeof(version));
+	trace->stream.write((const char*) &hash, sizeof(hash));
+	trace->stream.write((const char*) &bits, sizeof(bits));
+	trace->stream.write((const char*) &checkpoint_period, sizeof(checkpoint_period));
+	trace->stream.write((const char*) &argc, sizeof(argc));
+
+	for (uint32_t i = 0; i < argc; ++i) {
+		uint32_t length = (uint32_t) strlen(argv[i]);
+		trace->stream.write((const char*) &length, sizeof(length));
+		trace->stream.write(argv[i], length);
+		trace->arguments.emplace_back(argv[i]);
+	}
+
+	trace->buffer.reserve(TRACE_BUFFER_SIZE + 32);
+	return trace;
+}
+
+std::unique_ptr<ExecutionTrace> ExecutionTrace::replay(const char *file, const Program &program, uint8_t cell_bits) {
+	MappedFile contents;
+	if (!contents.open(file))
+		throw std::runtime_error("Cannot read the trace");
+
+	std::unique_ptr<ExecutionTrace> trace(new ExecutionTrace());
+	trace->replaying = true;
+	trace->buffer.assign(contents.data(), contents.data() + contents.size());
+
+	const std::vector<uint8_t> &bytes = trace->buffer;
+	auto read = [&](void *value, size_t size) {
+		if (size > bytes.size() - trace->offset)
+			throw std::runtime_error("Invalid trace");
+		memcpy(value, bytes.data() + trace->offset, size);
+		trace->offset += size;
+	};
+
+	char magic[4];
+	uint32_t version, bits, argc;
+	uint64_t hash;
+
+	read(magic, 4);
+	read(&version, sizeof(version));
+	if (memcmp(magic, TRACE_MAGIC, 4) != 0 || version != TRACE_VERSION)
+		throw std::runtime_error("Invalid trace");
+
+	read(&hash, sizeof(hash));
+	if (hash != hashBytes(program.source.data(), program.source.size()))
+		throw std::runtime_error("The trace was recorded from another script");
+
+	read(&bits, sizeof(bits));
+	if (bits != cell_bits)
+		throw std::runtime_error("The trace was recorded with --cell-bits=" + std::to_string(bits));
+
+	read(&trace->checkpoint_period, sizeof(trace->checkpoint_period));
+	read(&argc, sizeof(argc));
+
+	for (uint32_t i = 0; i < argc; ++i) {
+		uint32_t length;
+		read(&length, sizeof(length));
+		if (length > bytes.size() - trace->offset)
+			throw std::runtime_error("Invalid trace");
+
+		trace->arguments.emplace_back((const char*) bytes.data() + trace->offset, length);
+		trace->offset += length;
+	}
+
+	return trace;
+}
+
+void ExecutionTrace::recordInput(const ExecutionState &state, uint64_t value) {
+	recordCheckpoint(state);
+
+	int64_t difference = (int64_t) (value - previous);
+	writeVarint(((uint64_t) (difference << 1) ^ (uint64_t) (difference >> 63)) << 1);
+
+	previous = value;
+	++count;
+
+	if (buffer.size() >= TRACE_BUFFER_SIZE)
+		flush();
+}
+
+uint64_t ExecutionTrace::replayInput(const ExecutionState &state, uint32_t position) {
+	uint64_t event;
+	replayCheckpoint(state, position);
+
+	if (!readVarint(event) || event == TRACE_EVENT_END)
+		throw ExecutionError("The trace has no more input", position);
+	if ((event & 1) != 0)
+		throw ExecutionError("Invalid trace", position);
+
+	uint64_t zigzag = event >> 1;
+	previous += (zigzag >> 1) ^ (0 - (zigzag & 1));
+	++count;
+	return previous;
+}
+
+void ExecutionTrace::recordBlock(const ExecutionState &state, const uint8_t *bytes, size_t size) {
+	recordCheckpoint(state);
+
+	writeVarint(TRACE_EVENT_BLOCK);
+	writeVarint(size);
+	buffer.insert(buffer.end(), bytes, bytes + size);
+	++count;
+
+	if (buffer.size() >= TRACE_BUFFER_SIZE)
+		flush();
+}
+
+size_t ExecutionTrace::replayBlock(const ExecutionState &state, uint32_t position, const uint8_t *&bytes) {
+	uint64_t event, size;
+	replayCheckpoint(state, position);
+
+	if (!readVarint(event) || event == TRACE_EVENT_END)
+		throw ExecutionError("The trace has no more input", position);
+	if (event != TRACE_EVENT_BLOCK || !readVarint(size) || size > buffer.size() - offset)
+		throw ExecutionError("Invalid trace", position);
+
+	bytes = buffer.data() + offset;
+	offset += (size_t) size;
+	++count;
+	return (size_t) size;
+}
+
+void ExecutionTrace::finish() {
+	if (replaying)
+		return;
+
+	writeVarint(TRACE_EVENT_END);
+	flush();
+	stream.close();
+	if (stream.fail())
+		throw std::runtime_error("Cannot write the trace");
+}
+
+/**
+ * Records a checkpoint before the next value, if one is due.
+ *
+ * @param state The execution state, before the value is applied.
+ */
+void ExecutionTrace::recordCheckpoint(const ExecutionState &state) {
+	if (checkpoint_period == 0 || count % checkpoint_period != 0)
+		return;
+
+	uint64_t hash = hashExecutionState(state);
+	writeVarint(TRACE_EVENT_CHECKPOINT);
+	buffer.insert(buffer.end(), (const uint8_t*) &hash, (const uint8_t*) &hash + sizeof(hash));
+}
+
+/**
+ * Checks the checkpoint before the next value, if one is due.
+ *
+ * @param state The execution state, before the value is applied.
+ * @param position The position reported if the trace ended or diverged.
+ */
+void ExecutionTrace::replayCheckpoint(const ExecutionState &state, uint32_t position) {
+	if (checkpoint_period == 0 || count % checkpoint_period != 0)
+		return;
+
+	uint64_t event, hash;
+	if (!readVarint(event) || event == TRACE_EVENT_END)
+		throw ExecutionError("The trace has no more input", position);
+	if (event != TRACE_EVENT_CHECKPOINT || buffer.size() - offset < sizeof(hash))
+		throw ExecutionError("Invalid trace", position);
+
+	memcpy(&hash, buffer.data() + offset, sizeof(hash));
+	offset += sizeof(hash);
+	if (hash != hashExecutionState(state))
+		throw ExecutionError("The execution diverged from the trace before input " + std::to_string(count), position);
+}
+
+/**
+ * Writes a LEB128 varint to the buffer.
+ *
+ * @param value The value.
+ */
+void ExecutionTrace::writeVarint(uint64_t value) {
+	while (value >= 0x80) {
+		buffer.push_back((uint8_t) (value | 0x80));
+		value >>= 7;
+	}
+	buffer.push_back((uint8_t) value);
+}
+
+/**
+ * Reads a LEB128 varint from the replayed trace.
+ *
+ * @param value The variable which will contain the value.
+ *
+ * @return True, if a varint was read. False, if the trace ended.
+ */
+bool ExecutionTrace::readVarint(uint64_t &value) {
+	value = 0;
+
+	for (uint32_t shift = 0; offset < buffer.size() && shift < 64; shift += 7) {
+		uint8_t byte = buffer[offset++];
+		value |= (uint64_t) (byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+/// Writes the buffered bytes to the trace file, so that the trace is kept if the process is killed.
+void ExecutionTrace::flush() {
+	stream.write((const char*) buffer.data(), buffer.size());
+	stream.flush();
+	buffer.clear();
+}
+
+uint64_t hashExecutionState(const ExecutionState &state) {
+	std::vector<uint8_t> pointer;
+	state.getPointer(pointer);
+
+	// The position is hashed instead of the operation, which differs between optimized and unoptimized programs.
+	uint32_t position = state.pc < state.program->operations.size() ? state.program->operations[state.pc].position : UINT32_MAX;
+	uint64_t hash = hashBytes(&position, sizeof(position));
+	hash = hashBytes(&state.index, sizeof(state.index), hash);
+	return hashBytes(pointer.data(), pointer.size(), hash);
+}
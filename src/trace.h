@@ -0,0 +1,161 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef X10_TRACE_H
+#define X10_TRACE_H
+
+#include "engine.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/// The first bytes of a trace file.
+#define TRACE_MAGIC "X10T"
+/// The version of the trace format.
+#define TRACE_VERSION 1u
+/// The amount of bytes which are buffered before they are written to the trace file.
+#define TRACE_BUFFER_SIZE (1u << 16)
+
+/**
+ * The input read by a program, which is recorded to a trace file and then replayed from it.
+ * A trace starts with the hash of the script, the cell width and the arguments. Then, every value read by an input instruction
+ * (from STDIN or from a file) is stored as the LEB128 varint of its zigzagged difference from the previous value, and every
+ * checkpoint_period values a checkpoint with the hash of the execution state is stored, so that replays which diverge are detected.
+ * The raw bytes read by a bulk read are stored as a block, which counts as one value.
+ */
+class ExecutionTrace {
+	public:
+		~ExecutionTrace();
+
+		/**
+		 * Creates a trace file, and records the arguments which initialize the data pointer.
+		 *
+		 * @param file The trace file.
+		 * @param program The program which is recorded.
+		 * @param cell_bits The width of the cells.
+		 * @param argc The amount of arguments.
+		 * @param argv The arguments.
+		 * @param checkpoint_period The amount of values between checkpoints, or 0 for no checkpoints.
+		 *
+		 * @return The trace.
+		 *
+		 * @throws std::runtime_error If the trace file cannot be written.
+		 */
+		static std::unique_ptr<ExecutionTrace> record(const char *file, const Program &program, uint8_t cell_bits, uint32_t argc,
+		                                              char *argv[], uint32_t checkpoint_period);
+		/**
+		 * Reads a trace file, in order to replay it.
+		 *
+		 * @param file The trace file.
+		 * @param program The program which is replayed.
+		 * @param cell_bits The width of the cells.
+		 *
+		 * @return The trace.
+		 *
+		 * @throws std::runtime_error If the trace is invalid, or was recorded from another script or with another cell width.
+		 */
+		static std::unique_ptr<ExecutionTrace> replay(const char *file, const Program &program, uint8_t cell_bits);
+
+		/// Whether the trace is replayed, in which case files aren't opened and input isn't read.
+		bool isReplaying() const { return replaying; }
+		/// The arguments which initialized the data pointer when the trace was recorded.
+		const std::vector<std::string> &getArguments() const { return arguments; }
+
+		/**
+		 * Records a value which was read.
+		 *
+		 * @param state The execution state, before the value is applied.
+		 * @param value The value.
+		 */
+		void recordInput(const ExecutionState &state, uint64_t value);
+		/**
+		 * Replays the next value.
+		 *
+		 * @param state The execution state, before the value is applied.
+		 * @param position The position reported if the trace ended or diverged.
+		 *
+		 * @return The value.
+		 *
+		 * @throws ExecutionError If the trace has no more values, or the execution state doesn't match a checkpoint.
+		 */
+		uint64_t replayInput(const ExecutionState &state, uint32_t position);
+		/**
+		 * Records the bytes which were read by a bulk read.
+		 *
+		 * @param state The execution state, before the bytes are stored.
+		 * @param bytes The bytes.
+		 * @param size The amount of bytes.
+		 */
+		void recordBlock(const ExecutionState &state, const uint8_t *bytes, size_t size);
+		/**
+		 * Replays the bytes of the next bulk read.
+		 *
+		 * @param state The execution state, before the bytes are stored.
+		 * @param position The position reported if the trace ended or diverged.
+		 * @param bytes The variable which will point to the bytes, inside the trace.
+		 *
+		 * @return The amount of bytes.
+		 *
+		 * @throws ExecutionError If the trace has no more values, or the execution state doesn't match a checkpoint.
+		 */
+		size_t replayBlock(const ExecutionState &state, uint32_t position, const uint8_t *&bytes);
+		/**
+		 * Ends a recorded trace, and writes what is still buffered.
+		 *
+		 * @throws std::runtime_error If the trace file cannot be written.
+		 */
+		void finish();
+
+	private:
+		ExecutionTrace() = default;
+
+		bool replaying = false;
+		std::vector<std::string> arguments;
+		uint32_t checkpoint_period = 0;
+		/// The amount of values recorded or replayed.
+		uint64_t count = 0;
+		/// The previous value.
+		uint64_t previous = 0;
+		/// The recorded bytes which aren't written yet, or the whole replayed trace.
+		std::vector<uint8_t> buffer;
+		/// The offset of the next event in the replayed trace.
+		size_t offset = 0;
+		std::ofstream stream;
+
+		void recordCheckpoint(const ExecutionState &state);
+		void replayCheckpoint(const ExecutionState &state, uint32_t position);
+		void writeVarint(uint64_t value);
+		bool readVarint(uint64_t &value);
+		void flush();
+};
+
+/**
+ * Hashes the execution state of a checkpoint: the position of the operation executed next, the index and the data pointer.
+ *
+ * @param state The execution state.
+ *
+ * @return The hash.
+ */
+uint64_t hashExecutionState(const ExecutionState &state);
+
+#endif
@@ -0,0 +1,360 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "virtual_clock.h"
+
+#include <algorithm>
+
+/// The cost of every event, in ticks, in the order of VirtualEvent.
+static const uint64_t event_costs[VIRTUAL_EVENT_COUNT] = { 1, 1, 1, 2, 2, 16 };
+/// The names of the events, as they are reported.
+static const char *const event_names[VIRTUAL_EVENT_COUNT] = {
+	"dispatches", "cell reads", "cell writes", "expressions", "bytes of I/O", "tape growths"
+};
+
+int CountingBuffer::underflow() {
+	return source->sgetc();
+}
+
+int CountingBuffer::uflow() {
+	int c = source->sbumpc();
+	if (c != EOF)
+		++count;
+	return c;
+}
+
+std::streamsize CountingBuffer::xsgetn(char *bytes, std::streamsize size) {
+	std::streamsize read = source->sgetn(bytes, size);
+	count += (uint64_t) read;
+	return read;
+}
+
+int CountingBuffer::overflow(int c) {
+	if (c == EOF)
+		return 0;
+	if (source->sputc((char) c) == EOF)
+		return EOF;
+	++count;
+	return c;
+}
+
+std::streamsize CountingBuffer::xsputn(const char *bytes, std::streamsize size) {
+	std::streamsize written = source->sputn(bytes, size);
+	count += (uint64_t) written;
+	return written;
+}
+
+int CountingBuffer::sync() {
+	return source->pubsync();
+}
+
+VirtualClock::VirtualClock(ExecutionState &state)
+	: state(state), program(nullptr), input(state.input), output(state.output), input_buffer(state.input->rdbuf()),
+	  output_buffer(state.output->rdbuf()), counted_input(&input_buffer), counted_output(&output_buffer) {
+	std::fill(counts, counts + VIRTUAL_EVENT_COUNT, 0);
+	pc = 0;
+	index = 0;
+	size = 0;
+	bytes = 0;
+	pending_reads = 0;
+	pending_writes = 0;
+	counted_iterations = 0;
+
+	// Reading the input still flushes the output first, like it does for STDIN.
+	counted_input.tie(input->tie());
+	state.input = &counted_input;
+	state.output = &counted_output;
+}
+
+VirtualClock::~VirtualClock() {
+	counted_output.flush();
+	state.input = input;
+	state.output = output;
+}
+
+/**
+ * Counts the cells read by evaluating an operand.
+ *
+ * @param operand The index of the operand.
+ *
+ * @return The amount of cells.
+ */
+uint32_t VirtualClock::countReads(uint32_t operand) const {
+	const Operand &num = program->operands[operand];
+	uint32_t reads = 0;
+
+	switch (num.type) {
+		case OPERAND_CELL:
+		case OPERAND_RELATIVE_CELL:
+			return 1;
+		case OPERAND_CELL_AT_NESTED:
+		case OPERAND_CELL_AT_INDEX_PLUS_NESTED:
+		case OPERAND_CELL_AT_INDEX_MINUS_NESTED:
+			reads = 1;
+			[[fallthrough]];
+		case OPERAND_NESTED:
+		case OPERAND_INDEX_PLUS_NESTED:
+		case OPERAND_INDEX_MINUS_NESTED:
+			return reads + countReads(num.nested);
+		default:
+			return 0;
+	}
+}
+
+/// Counts the bytes read and written through the streams of the execution state so far.
+uint64_t VirtualClock::countBytes() const {
+	uint64_t total = input_buffer.getCount() + output_buffer.getCount();
+	for (const std::unique_ptr<CountingBuffer> &buffer : file_buffers)
+		total += buffer->getCount();
+	return total;
+}
+
+void VirtualClock::prepare(const Program &program) {
+	this->program = &program;
+	costs.assign(program.operations.size(), { 0, 0 });
+	range_maps.assign(program.operations.size(), false);
+
+	for (uint32_t pc = 0; pc < program.operations.size(); ++pc) {
+		const Operation &operation = program.operations[pc];
+		OperationCost &cost = costs[pc];
+
+		switch (operation.code) {
+			case OPCODE_VALUE_INCREMENT:
+			case OPCODE_VALUE_DECREMENT:
+			case OPCODE_INPUT_ADD:
+			case OPCODE_INPUT_XOR:
+			case OPCODE_INPUT_AND:
+			case OPCODE_INPUT_OR:
+				cost = { 1, 1 };
+				break;
+			case OPCODE_INPUT_READ:
+				cost = { 0, 1 };
+				break;
+			case OPCODE_VALUE_OPERATION:
+				cost.reads = countReads(operation.argument) + (operation.modifier == OPERATOR_SET ? 0 : 1);
+				if (operation.target_form != TARGET_CURRENT)
+					cost.reads += countReads(operation.target);
+				cost.writes = 1;
+				break;
+			case OPCODE_OUTPUT_WRITE: {
+				const std::string &formats = program.texts[operation.argument];
+				cost.reads = formats.empty() ? 1 : (uint32_t) std::count_if(formats.begin(), formats.end(), [](char format) { return format == 'n' || format == 'c'; });
+				break;
+			}
+			case OPCODE_BULK_READ:
+			case OPCODE_BULK_WRITE:
+				cost.reads = countReads(operation.argument) + countReads(operation.target);
+				cost.writes = operation.code == OPCODE_BULK_READ ? 1 : 0; // The amount read.
+				break;
+			case OPCODE_MEMORY_FILL:
+			case OPCODE_MEMORY_MOVE:
+				cost.reads = countReads(operation.argument) + countReads(operation.target) + countReads(operation.value);
+				break;
+			case OPCODE_MEMORY_COMPARE:
+				cost.reads = countReads(operation.argument) + countReads(operation.target) + countReads(operation.value) + countReads(operation.target_value);
+				cost.writes = 1; // The result.
+				break;
+			case OPCODE_LOOP_START:
+				range_maps[pc] = program.isRangeMap(pc);
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+/**
+ * Checks a relation between two values, like the engine does.
+ *
+ * @return True, if the relation holds. False otherwise, or if the relation is invalid.
+ */
+static bool relate(Relation relation, uint64_t left, uint64_t right) {
+	switch (relation) {
+		case RELATION_EQUAL: return left == right;
+		case RELATION_NOT_EQUAL: return left != right;
+		case RELATION_GREATER_THAN: return left > right;
+		case RELATION_GREATER_THAN_OR_EQUAL: return left >= right;
+		case RELATION_LESS_THAN: return left < right;
+		case RELATION_LESS_THAN_OR_EQUAL: return left <= right;
+		default: return false;
+	}
+}
+
+/**
+ * Charges the expressions of a condition which are evaluated, up to the AND which skips the rest, if any.
+ *
+ * @param id The index of the first expression.
+ */
+void VirtualClock::chargeCondition(uint32_t id) {
+	for (;;) {
+		const Condition &condition = program->conditions[id];
+
+		++counts[VIRTUAL_EXPRESSION];
+		counts[VIRTUAL_CELL_READ] += countReads(condition.left) + countReads(condition.right);
+
+		if (condition.conjunction == CONJUNCTION_NONE)
+			return;
+		if (condition.conjunction == CONJUNCTION_AND && !relate(condition.relation, state.evaluate(condition.left), state.evaluate(condition.right)))
+			return;
+		id = condition.next;
+	}
+}
+
+/**
+ * Computes the cells of the ranges which an operation reads and writes, which are charged if the operation succeeds.
+ *
+ * @param operation The operation.
+ */
+void VirtualClock::chargeRange(const Operation &operation) {
+	uint64_t count;
+
+	switch (operation.code) {
+		case OPCODE_BULK_WRITE: {
+			uint64_t first = state.evaluate(operation.argument);
+			uint64_t last = state.evaluate(operation.target);
+			pending_reads = last > first ? last - first : 0;
+			break;
+		}
+		case OPCODE_MEMORY_FILL:
+			pending_writes = state.evaluate(operation.target);
+			break;
+		case OPCODE_MEMORY_MOVE:
+			count = state.evaluate(operation.value);
+			pending_reads = count;
+			pending_writes = count;
+			break;
+		case OPCODE_MEMORY_COMPARE:
+			pending_reads = 2 * state.evaluate(operation.value); // Both ranges are charged, even if they differ early.
+			break;
+		default:
+			break;
+	}
+}
+
+void VirtualClock::startOperation() {
+	const Operation &operation = program->operations[state.pc];
+
+	pc = state.pc;
+	index = state.index;
+	size = state.getSize();
+	bytes = countBytes();
+	pending_reads = 0;
+	pending_writes = 0;
+
+	++counts[VIRTUAL_DISPATCH];
+	counts[VIRTUAL_CELL_READ] += costs[pc].reads;
+	counts[VIRTUAL_CELL_WRITE] += costs[pc].writes;
+
+	try {
+		switch (operation.code) {
+			case OPCODE_UNCERTAINTY_START:
+			case OPCODE_LOOP_START:
+				chargeCondition(operation.argument);
+				break;
+			case OPCODE_COUNTED_LOOP_START:
+				counted_iterations = 0;
+				chargeCondition(operation.argument);
+				counted_iterations = state.evaluate(program->conditions[operation.argument].left);
+				break;
+			case OPCODE_LOOP_END:
+				if (!state.loop_stack.empty())
+					chargeCondition(program->operations[state.loop_stack.back()].argument);
+				break;
+			case OPCODE_BULK_WRITE:
+			case OPCODE_MEMORY_FILL:
+			case OPCODE_MEMORY_MOVE:
+			case OPCODE_MEMORY_COMPARE:
+				chargeRange(operation);
+				break;
+			default:
+				break;
+		}
+	}
+	catch (std::exception &) {
+		// The operation raises the same error when it is executed.
+	}
+}
+
+void VirtualClock::finishOperation() {
+	const Operation &operation = program->operations[pc];
+
+	counts[VIRTUAL_CELL_READ] += pending_reads;
+	counts[VIRTUAL_CELL_WRITE] += pending_writes;
+	if (state.getSize() > size)
+		++counts[VIRTUAL_TAPE_GROWTH];
+
+	switch (operation.code) {
+		case OPCODE_BULK_READ:
+			counts[VIRTUAL_CELL_WRITE] += countBytes() - bytes;
+			break;
+		case OPCODE_LOOP_START:
+			// A range map executes all of its iterations at once, and leaves the index after the range.
+			if (range_maps[pc] && state.pc == operation.target && state.index > index) {
+				uint64_t iterations = state.index - index;
+				counts[VIRTUAL_CELL_READ] += iterations * costs[pc + 1].reads;
+				counts[VIRTUAL_CELL_WRITE] += iterations;
+			}
+			break;
+		case OPCODE_COUNTED_LOOP_START: {
+			// A closed form executes all of its iterations at once: each one reads and writes the counter, and writes every cell.
+			const CountedLoop &loop = program->counted_loops[operation.value];
+			if (!loop.updates.empty() && state.pc == program->operations[operation.target].target) {
+				uint64_t reads = 1 + std::count_if(loop.updates.begin(), loop.updates.end(), [](const CellUpdate &update) { return update.modifier != OPERATOR_SET; });
+				counts[VIRTUAL_CELL_READ] += counted_iterations * reads;
+				counts[VIRTUAL_CELL_WRITE] += counted_iterations * (loop.updates.size() + 1);
+			}
+			break;
+		}
+		case OPCODE_FILE_OPEN: {
+			// The file stream reads and writes through a counting buffer from now on, without changing its state.
+			std::ios *stream = operation.modifier == 'v' ? (std::ios*) state.file_input : (std::ios*) state.file_output;
+			std::ios::iostate flags = stream->rdstate();
+
+			file_buffers.emplace_back(new CountingBuffer(stream->rdbuf()));
+			stream->rdbuf(file_buffers.back().get());
+			stream->clear(flags);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+uint64_t VirtualClock::getCount(VirtualEvent event) const {
+	uint64_t count = counts[event];
+	return event == VIRTUAL_IO_BYTE ? count + countBytes() : count;
+}
+
+uint64_t VirtualClock::getTime() const {
+	uint64_t time = 0;
+	for (uint8_t event = 0; event < VIRTUAL_EVENT_COUNT; ++event)
+		time += getCount((VirtualEvent) event) * event_costs[event];
+	return time;
+}
+
+void VirtualClock::report(std::ostream &output) const {
+	output << "\n[INFO] Virtual time (cost model v" << VIRTUAL_CLOCK_VERSION << "): " << getTime() << " ticks (";
+	for (uint8_t event = 0; event < VIRTUAL_EVENT_COUNT; ++event)
+		output << (event == 0 ? "" : ", ") << getCount((VirtualEvent) event) << ' ' << event_names[event];
+	output << ')';
+}
@@ -0,0 +1,147 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef X10_VIRTUAL_CLOCK_H
+#define X10_VIRTUAL_CLOCK_H
+
+#include "engine.h"
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+/// The version of the cost model. It changes whenever an event is counted differently, or costs something else.
+#define VIRTUAL_CLOCK_VERSION 1u
+
+/// The events charged by the virtual clock.
+enum VirtualEvent : uint8_t {
+	VIRTUAL_DISPATCH,    // An operation is executed.
+	VIRTUAL_CELL_READ,   // A cell is read.
+	VIRTUAL_CELL_WRITE,  // A cell is written.
+	VIRTUAL_EXPRESSION,  // An expression of a condition is evaluated.
+	VIRTUAL_IO_BYTE,     // A byte is read from the input or a file, or written to the output or a file.
+	VIRTUAL_TAPE_GROWTH, // An operation adds cells to the data pointer.
+	VIRTUAL_EVENT_COUNT
+};
+
+/// A stream buffer which counts the bytes that pass through it to another one. It doesn't buffer, so nothing is counted twice.
+class CountingBuffer : public std::streambuf {
+	public:
+		explicit CountingBuffer(std::streambuf *source) : source(source), count(0) { }
+
+		/// Gets the amount of bytes read or written.
+		uint64_t getCount() const { return count; }
+
+	protected:
+		int underflow() override;
+		int uflow() override;
+		std::streamsize xsgetn(char *bytes, std::streamsize size) override;
+		int overflow(int c) override;
+		std::streamsize xsputn(const char *bytes, std::streamsize size) override;
+		int sync() override;
+
+	private:
+		std::streambuf *source;
+		uint64_t count;
+};
+
+/**
+ * Charges every operation which is executed with a fixed cost model (see VIRTUAL_CLOCK_VERSION), which gives a time that
+ * depends only on the script, its arguments and its input. The operations are executed by the engine as usual; the clock
+ * counts what they do from their operands and from the execution state before and after them.
+ */
+class VirtualClock {
+	public:
+		/**
+		 * Starts counting the input and the output of an execution state, whose streams are replaced until the clock is destroyed.
+		 *
+		 * @param state The execution state.
+		 */
+		explicit VirtualClock(ExecutionState &state);
+		~VirtualClock();
+
+		/**
+		 * Computes the costs which are the same every time an operation of a program is executed.
+		 *
+		 * @param program The program, which is executed next.
+		 */
+		void prepare(const Program &program);
+		/// Charges the operation at pc, before the engine executes it.
+		void startOperation();
+		/// Charges what the operation at pc did, after the engine executed it.
+		void finishOperation();
+
+		/// Gets the amount of times an event happened.
+		uint64_t getCount(VirtualEvent event) const;
+		/// Gets the virtual time, in ticks.
+		uint64_t getTime() const;
+		/**
+		 * Writes the virtual time, and the amount of every event.
+		 *
+		 * @param output The stream.
+		 */
+		void report(std::ostream &output) const;
+
+	private:
+		/// The costs of an operation which don't depend on the execution state.
+		struct OperationCost {
+			uint32_t reads;
+			uint32_t writes;
+		};
+
+		ExecutionState &state;
+		const Program *program;
+		std::vector<OperationCost> costs;
+		/// Whether every LOOP_START is executed as a range map (see Program::isRangeMap()).
+		std::vector<bool> range_maps;
+		uint64_t counts[VIRTUAL_EVENT_COUNT];
+
+		std::istream *input;
+		std::ostream *output;
+		CountingBuffer input_buffer;
+		CountingBuffer output_buffer;
+		std::istream counted_input;
+		std::ostream counted_output;
+		/// The buffers of the files which were opened, which stay alive until the clock is destroyed.
+		std::vector<std::unique_ptr<CountingBuffer>> file_buffers;
+
+		/// The execution state before the operation which is executed.
+		uint32_t pc;
+		uint32_t index;
+		size_t size;
+		uint64_t bytes;
+		/// The cells of the ranges of the operation, charged once it succeeds.
+		uint64_t pending_reads;
+		uint64_t pending_writes;
+		/// The counter of a COUNTED_LOOP_START, before it is executed.
+		uint64_t counted_iterations;
+
+		uint32_t countReads(uint32_t operand) const;
+		uint64_t countBytes() const;
+		void chargeCondition(uint32_t id);
+		void chargeRange(const Operation &operation);
+};
+
+#endif
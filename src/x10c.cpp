@@ -0,0 +1,200 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "daemon_protocol.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * Executes x10 in place of the client, with the same arguments.
+ * The interpreter is X10_INTERPRETER, or x10 from the directory of the client, or x10 from the PATH.
+ *
+ * @param argv The command-line arguments.
+ */
+[[noreturn]] void executeInterpreter(char *argv[]);
+/**
+ * Connects to the daemon.
+ *
+ * @return The socket, or -1 if no daemon of the same user listens.
+ */
+int connectDaemon();
+/**
+ * Writes bytes to a file descriptor. Retries interrupted and partial writes.
+ *
+ * @param fd The file descriptor.
+ * @param data The bytes.
+ * @param size The amount of bytes.
+ *
+ * @return True, if every byte was written.
+ */
+bool writeAll(int fd, const char *data, size_t size);
+
+/**
+ * The main function of the client. Takes the same arguments as x10, and executes the script on the daemon.
+ * Falls back to x10 if no daemon of the same user listens, or if the daemon doesn't support an option.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv The command-line arguments.
+ *
+ * @return The program exit code.
+ */
+int main(int argc, char *argv[]) {
+	int first = 1;
+	for (; first < argc && strncmp(argv[first], "--", 2) == 0; ++first) {
+		if (!isDaemonOption(argv[first]))
+			executeInterpreter(argv);
+	}
+
+	// Without a script, x10 reports the error.
+	if (first >= argc)
+		executeInterpreter(argv);
+
+	std::vector<char> directory(4096);
+	while (getcwd(directory.data(), directory.size()) == nullptr) {
+		if (errno != ERANGE)
+			executeInterpreter(argv);
+		directory.resize(directory.size() * 2);
+	}
+
+	int connection = connectDaemon();
+	if (connection == -1)
+		executeInterpreter(argv);
+
+	std::string request(directory.data());
+	request.push_back('\0');
+	for (int i = 1; i < argc; ++i) {
+		request.append(argv[i]);
+		request.push_back('\0');
+	}
+
+	// Nothing was executed yet, so x10 can still take over.
+	if (!sendFrame(connection, FRAME_REQUEST, request.data(), request.size())) {
+		close(connection);
+		executeInterpreter(argv);
+	}
+
+	FrameType type;
+	std::string payload;
+	std::vector<char> input(DAEMON_BLOCK_SIZE);
+
+	while (receiveFrame(connection, type, payload)) {
+		switch (type) {
+			case FRAME_OUTPUT:
+				writeAll(STDOUT_FILENO, payload.data(), payload.size());
+				break;
+			case FRAME_ERROR:
+				writeAll(STDERR_FILENO, payload.data(), payload.size());
+				break;
+			case FRAME_READ: {
+				ssize_t size;
+				do size = read(STDIN_FILENO, input.data(), input.size());
+				while (size < 0 && errno == EINTR);
+
+				// An error reading STDIN ends the input, like it would for x10.
+				sendFrame(connection, FRAME_INPUT, input.data(), size > 0 ? (size_t) size : 0);
+				break;
+			}
+			case FRAME_EXIT: {
+				const unsigned char *code = (const unsigned char*) payload.data();
+				exit(payload.size() == 4 ? (int) (code[0] | code[1] << 8 | code[2] << 16 | (uint32_t) code[3] << 24) : EXIT_FAILURE);
+			}
+			default:
+				break;
+		}
+	}
+
+	const char text[] = "\n[ERROR]: The daemon closed the connection";
+	writeAll(STDERR_FILENO, text, sizeof(text) - 1);
+	exit(EXIT_FAILURE);
+}
+
+void executeInterpreter(char *argv[]) {
+	const char *interpreter = getenv(DAEMON_INTERPRETER_VARIABLE);
+	std::string path;
+
+	if (interpreter == nullptr || *interpreter == '\0') {
+		const char *separator = strrchr(argv[0], '/');
+
+		if (separator != nullptr) {
+			path.assign(argv[0], separator + 1 - argv[0]);
+			path.append("x10");
+		}
+		if (path.empty() || access(path.c_str(), X_OK) != 0)
+			path = "x10";
+		interpreter = path.c_str();
+	}
+
+	argv[0] = const_cast<char*>(interpreter);
+	execvp(interpreter, argv);
+
+	std::string text = std::string("[ERROR]: Cannot execute ") + interpreter;
+	writeAll(STDERR_FILENO, text.data(), text.size());
+	exit(EXIT_FAILURE);
+}
+
+int connectDaemon() {
+	std::string path = getDaemonSocket();
+
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	if (path.size() >= sizeof(address.sun_path))
+		return -1;
+	memcpy(address.sun_path, path.c_str(), path.size());
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd == -1)
+		return -1;
+
+	// A socket bound by another user is treated like no daemon, so that x10 executes the script instead.
+	if (connect(fd, (sockaddr*) &address, sizeof(address)) != 0 || !isOwnPeer(fd)) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+bool writeAll(int fd, const char *data, size_t size) {
+	while (size != 0) {
+		ssize_t written = write(fd, data, size);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			return false;
+
+		data += written;
+		size -= (size_t) written;
+	}
+
+	return true;
+}
@@ -0,0 +1,77 @@
+/**
+ * X10 (https://github.com/UnexomWid/X10)
+ *
+ * This project is licensed under the MIT license.
+ * Copyright (c) 2018-2019 UnexomWid (https://uw.exom.dev)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the
+ * following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial
+ * portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "daemon.h"
+#include "daemon_protocol.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+/**
+ * Writes an error to STDERR and terminates the program with the status code 1.
+ *
+ * @param[in] text The error to write.
+ */
+void error(const std::string &text);
+
+/**
+ * The main function of the daemon.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv The command-line arguments.
+ *
+ * @return The program exit code.
+ */
+int main(int argc, char *argv[]) {
+	DaemonOptions options;
+	options.socket = getDaemonSocket();
+
+	for (int i = 1; i < argc; ++i) {
+		const char *option = argv[i];
+
+		if (strncmp(option, "--socket=", 9) == 0 && option[9] != '\0')
+			options.socket = option + 9;
+		else if (strncmp(option, "--jobs=", 7) == 0 && isdigit(option[7]))
+			options.jobs = (uint32_t) strtoul(option + 7, nullptr, 10);
+		else if (strncmp(option, "--cache=", 8) == 0 && isdigit(option[8]))
+			options.cache_size = (size_t) strtoull(option + 8, nullptr, 10);
+		else error(std::string("[ERROR]: Invalid option '") + option + "'");
+	}
+
+	try {
+		std::cout << "[INFO] Listening on " << options.socket << std::endl;
+		runDaemon(options);
+	}
+	catch (std::exception &e) {
+		error(std::string("[ERROR]: ") + e.what());
+	}
+
+	exit(EXIT_SUCCESS);
+}
+
+void error(const std::string &text) {
+	std::cerr << text;
+	exit(EXIT_FAILURE);
+}